@@ -20,6 +20,21 @@
 #include "user_config.h"
 #include "user_custs1_def.h"
 #include "user_custs1_impl.h"
+#include "user_broadcast.h"
+#include "user_time_sync.h"
+#include "user_capture.h"
+#include "user_profile.h"
+#include "user_ctrl.h"
+#include "user_gait.h"
+#include "user_fall.h"
+#include "user_pressure.h"
+#include "user_ota.h"
+#include "user_mem.h"
+#include "user_power.h"
+#include "user_nvm.h"
+#include "user_packets.h"
+#include "user_reps.h"
+#include "user_wear.h"
 #include "gpio.h"
 #include "i2c.h"
 #include "adc.h"
@@ -27,18 +42,23 @@
 
 // Configuration
 #define SAMPLE_RATE_HZ          100
-#define JUMP_THRESHOLD_G        1.5
-#define LANDING_THRESHOLD_G     2.5
 #define CALIBRATION_SAMPLES     500
 #define LED_PIN                 GPIO_PIN_11
 #define PRESSURE_ADC_CHANNEL    ADC_CHANNEL_P0_5
+#define TICK_SUBDIV             32      // Timer0 32.768kHz counts per tick (976.5625us)
+#define LED_ALERT_BLINK_MS      100
+#define VBAT_CONVERSIONS        4
+#define SESSION_LOG_VERSION     1
 
 // Data Structures
 typedef struct {
     float accel_x, accel_y, accel_z;
     float gyro_x, gyro_y, gyro_z;
-    uint16_t pressure;
+    float accel_mag;
+    uint16_t pressure;          // 25 Pa per LSB
+    int32_t load_rate;          // 25 Pa/s per LSB
     uint32_t timestamp;
+    uint32_t timestamp_us;
 } sensor_data_t;
 
 typedef struct {
@@ -51,16 +71,29 @@ typedef struct {
     uint32_t total_jumps;
     float jump_height;
     float flight_time;
+    float max_height;
     bool in_jump;
     uint32_t jump_start;
+    uint32_t jump_start_us;
     uint16_t battery_mv;
 } device_state_t;
 
+// Session Log (NVM, written before the battery runs out)
+typedef struct {
+    uint32_t total_jumps;
+    uint32_t uptime_s;
+    uint16_t max_height_mm;
+    uint16_t battery_mv;
+} session_log_t;
+
 // Global Variables
 static sensor_data_t sensor_data;
 static cal_data_t calibration = {0};
 static device_state_t device = {0};
 static volatile uint32_t system_ticks = 0;
+static volatile uint32_t system_ticks_hi = 0;
+static uint32_t led_off_time = 0;
+static bool led_on = false;
 
 // Function Prototypes
 static void system_init(void);
@@ -71,10 +104,28 @@ static void ble_transmit(void);
 static uint32_t get_time_ms(void);
 static void delay_ms(uint32_t ms);
 static void led_flash(uint8_t count);
+static void broadcast_refresh(bool jump_event);
+static void send_jump_record(void);
+static void capture_sample(void);
+static void process_actions(void);
+static void publish_status(void);
+static void gait_update(void);
+static void reps_update(void);
+static bool wear_update(void);
+static uint8_t loop_rate_hz(void);
+static void fall_update(void);
+static uint16_t accel_magnitude_mg(void);
+static void led_pulse(uint32_t ms);
+static void led_update(void);
+static void battery_update(void);
+static void session_log_flush(void);
+static void session_log_restore(void);
 
 // Timer interrupt for system tick
 void timer0_handler(void) {
-    system_ticks++;
+    if (++system_ticks == 0) {
+        system_ticks_hi++;
+    }
 }
 
 /**
@@ -83,26 +134,85 @@ void timer0_handler(void) {
 int main(void) {
     system_init_func(NULL);
     
+#if CFG_MEM_TELEMETRY
+    // Paint the free stack before anything else deepens it
+    user_mem_init();
+#endif
+    
     // Initialize application
     system_init();
     
     // Perform calibration
     calibrate_sensors();
     
+#if CFG_WEAR_DETECTION
+    // Off-body windows start once the band is calibrated on the ankle
+    user_wear_init(get_time_ms());
+#endif
+    
     printf("Ankle Band V2 Ready - Jumps: %d\n", (int)device.total_jumps);
     led_flash(3); // Ready indication
     
     // Main application loop
     while (1) {
+        battery_update();
         read_sensors();
-        detect_jump();
         
-        if (user_ble_get_state() == BLE_CONNECTED) {
+        // Detectors, capture and streaming pause while the band is not worn
+        bool worn = wear_update();
+        if (worn) {
+            fall_update();
+            capture_sample();
+            detect_jump();
+            gait_update();
+            reps_update();
+        }
+        
+#if CFG_FALL_DETECTION
+        // Unacknowledged alerts keep repeating whatever the wear state
+        user_fall_poll(user_get_time_us());
+#endif
+        
+        // Streaming stops at battery cutoff and gives the link to an update
+        bool streaming = worn && user_power_tier() < POWER_TIER_CUTOFF;
+#if CFG_OTA
+        streaming = streaming && !user_ota_active();
+#endif
+        
+        if (user_ble_get_state() == BLE_CONNECTED && streaming) {
             ble_transmit();
+#if CFG_JUMP_CAPTURE
+            // Raw jump captures only use link time left over by live data
+            if (!user_fall_alert_active()) {
+                user_capture_poll_tx();
+            }
+#endif
         }
         
+        led_update();
+        process_actions();
+        publish_status();
+#if CFG_MEM_TELEMETRY
+        user_mem_poll();
+#endif
+        
+#if CFG_ADV_BROADCAST
+        user_broadcast_tick(get_time_ms());
+#endif
+        
+#if CFG_PROFILE_HOT_PATHS
+        static uint32_t last_profile_report = 0;
+        if ((get_time_ms() - last_profile_report) > PROFILE_REPORT_MS) {
+            user_profile_report();
+#if CFG_MEM_TELEMETRY
+            user_mem_report();
+#endif
+            last_profile_report = get_time_ms();
+        }
+#endif
+        
         // Low power delay
-        delay_ms(10); // 100Hz sampling
+        delay_ms(1000 / loop_rate_hz()); // 100Hz by default, capped by battery tier
     }
 }
 
@@ -110,6 +220,9 @@ int main(void) {
  * @brief Initialize system peripherals
  */
 static void system_init(void) {
+    // Runtime settings (thresholds, rates, mode) before anything reads them
+    user_ctrl_init();
+    
     // GPIO initialization
     GPIO_ConfigurePin(GPIO_PORT_0, LED_PIN, OUTPUT, PID_GPIO, false);
     
@@ -122,9 +235,9 @@ static void system_init(void) {
     };
     i2c_init(&i2c_cfg);
     
-    // Timer initialization for system tick
-    timer0_init(TIM0_CLK_32K, PWM_MODE_ONE, TIM0_CLK_DIV_32);
-    timer0_set_pwm_on_counter(1); // 1ms tick
+    // Timer initialization for system tick (counter also gives sub-ms time)
+    timer0_init(TIM0_CLK_32K, PWM_MODE_ONE, TIM0_CLK_DIV_1);
+    timer0_set_pwm_on_counter(TICK_SUBDIV); // 1024Hz tick
     timer0_register_callback(timer0_handler);
     timer0_start();
     
@@ -133,6 +246,39 @@ static void system_init(void) {
     GPIO_ConfigurePin(GPIO_PORT_0, GPIO_PIN_9, INPUT_PULLUP, PID_I2C_SDA, false);
     
     printf("I2C initialized for BMI270\n");
+    
+    // Pressure calibration table (NVM or compile-time default)
+    user_pressure_init();
+    
+#if CFG_REP_COUNTER
+    // Exercise templates uploaded over BLE
+    user_reps_init();
+#endif
+    
+    // Battery governor, and counters saved before a previous battery ran out
+    user_power_init();
+    session_log_restore();
+    
+#if CFG_ADV_BROADCAST
+    // Live metrics in advertising data for connectionless scanners
+    user_broadcast_init();
+#endif
+    
+#if CFG_JUMP_CAPTURE
+    user_capture_init();
+#endif
+    
+#if CFG_PROFILE_HOT_PATHS
+    user_profile_init();
+#endif
+    
+#if CFG_FALL_DETECTION
+    user_fall_init();
+#endif
+    
+#if CFG_OTA
+    user_ota_init();
+#endif
 }
 
 /**
@@ -158,6 +304,11 @@ static void calibrate_sensors(void) {
  * @brief Read all sensor data
  */
 static void read_sensors(void) {
+    PROFILE_BEGIN();
+    
+    // Sample instant for the shared timebase
+    sensor_data.timestamp_us = user_get_time_us();
+    
     // Simplified sensor reading for demonstration
     if (calibration.calibrated) {
         // Generate sample data for testing
@@ -170,7 +321,13 @@ static void read_sensors(void) {
         sensor_data.gyro_z = 0.0f + (rand() % 100 - 50) / 10.0f;
     }
     
-    // Read pressure sensor via ADC
+    // Total acceleration magnitude, shared by all detectors
+    sensor_data.accel_mag = sqrtf(sensor_data.accel_x * sensor_data.accel_x +
+                                  sensor_data.accel_y * sensor_data.accel_y +
+                                  sensor_data.accel_z * sensor_data.accel_z);
+    
+    // Read pressure sensor via ADC, PRESSURE_OVERSAMPLE conversions per sample
+    PROFILE_BEGIN_AT(prof_pressure_);
     adc_config_t adc_cfg = {
         .input_mode = ADC_INPUT_MODE_SINGLE_ENDED,
         .input = PRESSURE_ADC_CHANNEL,
@@ -183,61 +340,173 @@ static void read_sensors(void) {
     
     adc_init(&adc_cfg);
     adc_enable_channel(PRESSURE_ADC_CHANNEL);
-    adc_start();
     
-    while (!adc_get_sample_status()) {
-        // Wait for conversion
+    for (uint8_t i = 0; i < PRESSURE_OVERSAMPLE; i++) {
+        adc_start();
+        
+        while (!adc_get_sample_status()) {
+            // Wait for conversion
+        }
+        
+        user_pressure_push(adc_get_sample());
     }
-    
-    uint16_t adc_raw = adc_get_sample();
     adc_disable();
     
-    // Convert to pressure (0-1023 ADC → 0-100 kPa)
-    sensor_data.pressure = (adc_raw * 100) / 1023;
+    // CIC decimation and calibration (12-bit, 25 Pa/LSB) plus load rate
+    pressure_out_t pressure;
+    user_pressure_decimate(loop_rate_hz(), &pressure);
+    sensor_data.pressure = pressure.pressure;
+    sensor_data.load_rate = pressure.load_rate;
+    PROFILE_END_AT(PROF_PRESSURE, prof_pressure_);
+    
     sensor_data.timestamp = get_time_ms();
     
-    // Battery monitoring (every 10 seconds)
+    PROFILE_END(PROF_READ_SENSORS);
+}
+
+/**
+ * @brief Measure VBAT with the radio quiet and run the battery governor
+ */
+static void battery_update(void) {
     static uint32_t last_battery_check = 0;
-    if ((get_time_ms() - last_battery_check) > 10000) {
-        adc_cfg.input = ADC_CHANNEL_VBAT3V;
-        adc_init(&adc_cfg);
-        adc_enable_channel(ADC_CHANNEL_VBAT3V);
+    static bool first_check = true;
+    uint32_t since = get_time_ms() - last_battery_check;
+    
+    if (!first_check && since < POWER_VBAT_INTERVAL_MS) {
+        return;
+    }
+    
+    // The coin cell sags during radio events: wait for an empty TX queue and a
+    // sleeping BLE core (between advertising/connection events), but not forever
+    bool patient = !first_check && since < 2 * POWER_VBAT_INTERVAL_MS;
+    bool quiet = user_custs1_tx_empty() && user_ble_radio_idle();
+#if CFG_OTA
+    quiet = quiet && !user_ota_active();
+#endif
+    if (patient && !quiet) {
+        return;
+    }
+    
+    adc_config_t adc_cfg = {
+        .input_mode = ADC_INPUT_MODE_SINGLE_ENDED,
+        .input = ADC_CHANNEL_VBAT3V,
+        .continuous = false,
+        .interval_mult = 0,
+        .input_attenuator = ADC_INPUT_ATTN_NO,
+        .chopping = false,
+        .oversampling = 0
+    };
+    uint32_t sum = 0;
+    
+    adc_init(&adc_cfg);
+    adc_enable_channel(ADC_CHANNEL_VBAT3V);
+    
+    for (uint8_t i = 0; i < VBAT_CONVERSIONS; i++) {
         adc_start();
         
         while (!adc_get_sample_status());
         
-        // Convert to millivolts (10-bit ADC, 3.6V max range)
-        device.battery_mv = (adc_get_sample() * 3600) / 1023;
-        adc_disable();
-        
-        last_battery_check = get_time_ms();
-        
-        if (device.battery_mv < 3100) {
-            printf("Low battery: %dmV\n", device.battery_mv);
+        sum += adc_get_sample();
+    }
+    adc_disable();
+    
+    // A radio event started during the burst, try again on a later pass
+    if (patient && !user_ble_radio_idle()) {
+        return;
+    }
+    
+    first_check = false;
+    last_battery_check = get_time_ms();
+    
+    // Convert to millivolts (10-bit ADC, 3.6V max range), then filter and pick the tier
+    power_tier_t previous = user_power_tier();
+    if (user_power_update((uint16_t)((sum * 3600) / (1023 * VBAT_CONVERSIONS)))) {
+#if CFG_ADV_BROADCAST
+        user_broadcast_set_power_shift(user_power_adv_shift());
+#endif
+        // Counters survive the battery running out
+        if (user_power_tier() > previous && user_power_tier() >= POWER_TIER_CRITICAL) {
+            session_log_flush();
         }
     }
+    device.battery_mv = user_power_vbat_mv();
+    broadcast_refresh(false);
+    
+    // Fall alerts own the link until sent and acknowledged
+    if (user_fall_alert_active()) {
+        return;
+    }
+    
+    pkt_battery_t pkt = {
+        .battery_mv = user_power_vbat_mv(),
+        .percent = user_power_percent(),
+        .tier = (uint8_t)user_power_tier(),
+        .hours_left = user_power_hours_left()
+    };
+    user_pkt_battery_send(CONIDX_ALL, &pkt);
+}
+
+/**
+ * @brief Save counters to flash before the battery runs out
+ */
+static void session_log_flush(void) {
+    session_log_t log = {
+        .total_jumps = device.total_jumps,
+        .uptime_s = get_time_ms() / 1000,
+        .max_height_mm = (uint16_t)(device.max_height * 10.0f),
+        .battery_mv = device.battery_mv
+    };
+    
+    if (user_nvm_write(NVM_RECORD_SESSION_LOG, SESSION_LOG_VERSION, &log, sizeof(log))) {
+        printf("Session log saved: %lu jumps\n", (unsigned long)log.total_jumps);
+    }
+}
+
+/**
+ * @brief Restore counters saved at low battery (once, then erased)
+ */
+static void session_log_restore(void) {
+    session_log_t log;
+    
+    if (!user_nvm_read(NVM_RECORD_SESSION_LOG, SESSION_LOG_VERSION, &log, sizeof(log))) {
+        return;
+    }
+    
+    device.total_jumps = log.total_jumps;
+    device.max_height = log.max_height_mm / 10.0f;
+    user_nvm_erase(NVM_RECORD_SESSION_LOG);
+    
+    printf("Session restored: %lu jumps (saved at %dmV)\n",
+           (unsigned long)log.total_jumps, log.battery_mv);
 }
 
 /**
  * @brief Detect jump events
  */
 static void detect_jump(void) {
-    // Calculate total acceleration magnitude
-    float accel_magnitude = sqrtf(sensor_data.accel_x * sensor_data.accel_x +
-                                 sensor_data.accel_y * sensor_data.accel_y +
-                                 sensor_data.accel_z * sensor_data.accel_z);
+    PROFILE_BEGIN();
+    
+    float accel_magnitude = sensor_data.accel_mag;
     
     static float prev_accel = 1.0f;
+    const app_settings_t *settings = user_ctrl_settings();
+    float jump_threshold = settings->jump_threshold_mg * 0.001f;
+    float landing_threshold = settings->landing_threshold_mg * 0.001f;
     
     // Jump takeoff detection
-    if (!device.in_jump && accel_magnitude > JUMP_THRESHOLD_G && prev_accel < 1.2f) {
+    if (!device.in_jump && accel_magnitude > jump_threshold && prev_accel < 1.2f) {
         device.in_jump = true;
         device.jump_start = get_time_ms();
+        device.jump_start_us = sensor_data.timestamp_us;
         printf("Takeoff detected: %.2fg\n", accel_magnitude);
+        
+#if CFG_JUMP_CAPTURE
+        user_capture_on_takeoff(device.jump_start_us);
+#endif
     }
     
     // Landing detection
-    if (device.in_jump && accel_magnitude > LANDING_THRESHOLD_G &&
+    if (device.in_jump && accel_magnitude > landing_threshold &&
         (get_time_ms() - device.jump_start) > 200) { // Min 200ms flight
         
         device.in_jump = false;
@@ -250,15 +519,35 @@ static void detect_jump(void) {
         // Validate jump (filter false positives)
         if (device.jump_height >= 5.0f && device.jump_height <= 300.0f) {
             device.total_jumps++;
+            if (device.jump_height > device.max_height) {
+                device.max_height = device.jump_height;
+            }
             
             printf("Jump #%d: %.1fcm (%.3fs)\n",
                    (int)device.total_jumps, device.jump_height, device.flight_time);
             
-            led_flash(1); // Jump confirmation
+#if CFG_JUMP_CAPTURE
+            user_capture_on_landing((uint16_t)device.total_jumps,
+                                    (uint16_t)(device.flight_time * 1000.0f));
+#endif
+            
+            broadcast_refresh(true);
+            send_jump_record();
+            
+            // Jump confirmation, non-blocking so the landing window is sampled
+            if (user_power_led_allowed()) {
+                led_pulse(100);
+            }
+        } else {
+#if CFG_JUMP_CAPTURE
+            user_capture_abort();
+#endif
         }
     }
     
     prev_accel = accel_magnitude;
+    
+    PROFILE_END(PROF_DETECT_JUMP);
 }
 
 /**
@@ -267,43 +556,124 @@ static void detect_jump(void) {
 static void ble_transmit(void) {
     static uint32_t last_transmission = 0;
     
-    // Transmit at 10Hz when connected
-    if ((get_time_ms() - last_transmission) < 100) {
+    // Fall alerts own the link until sent and acknowledged
+    if (user_fall_alert_active()) {
         return;
     }
     
-    // Prepare data packet
-    uint8_t data[16];
-    uint8_t idx = 0;
-    
-    data[idx++] = 0xAA; // Header byte
+    // Medical mode sends per-minute gait summaries and exercise sets instead of raw samples
+    if (user_ctrl_settings()->mode == DEVICE_MODE_MEDICAL) {
+        gait_summary_t summary;
+        
+        if (user_gait_take_summary(&summary)) {
+            pkt_gait_t pkt = {
+                .minute = summary.minute,
+                .steps = summary.steps,
+                .cadence_spm = summary.cadence_spm,
+                .stance_ms = summary.stance_ms,
+                .swing_ms = summary.swing_ms,
+                .stride_ms = summary.stride_ms,
+                .stride_cv = summary.stride_cv,
+                .total_steps = summary.total_steps
+            };
+            user_pkt_gait_send(CONIDX_ALL, &pkt);
+        }
+        
+#if CFG_REP_COUNTER
+        reps_set_t set;
+        
+        if (user_reps_take_set(&set)) {
+            pkt_reps_t pkt = {
+                .set = set.set,
+                .slot = set.slot,
+                .reps = set.reps,
+                .tempo_ms = set.tempo_ms,
+                .rom_mg = set.rom_mg,
+                .duration_s = set.duration_s
+            };
+            user_pkt_reps_send(CONIDX_ALL, &pkt);
+        }
+#endif
+        return;
+    }
     
-    // Accelerometer data (scaled to fit in bytes)
-    data[idx++] = (uint8_t)((sensor_data.accel_x * 50.0f) + 128);
-    data[idx++] = (uint8_t)((sensor_data.accel_y * 50.0f) + 128);
-    data[idx++] = (uint8_t)((sensor_data.accel_z * 50.0f) + 128);
+    // Transmit at 10Hz when connected (CTRL_REG_TX_RATE)
+    if ((get_time_ms() - last_transmission) < (1000U / user_power_tx_rate())) {
+        return;
+    }
     
-    // Jump metrics
-    data[idx++] = (uint8_t)(device.jump_height);
-    data[idx++] = (uint8_t)(device.total_jumps & 0xFF);
-    data[idx++] = (uint8_t)((device.total_jumps >> 8) & 0xFF);
+    PROFILE_BEGIN();
     
-    // Pressure and battery
-    data[idx++] = (uint8_t)(sensor_data.pressure);
-    data[idx++] = (uint8_t)(device.battery_mv >> 8);
-    data[idx++] = (uint8_t)(device.battery_mv & 0xFF);
+    // Load rate in kPa/s, clamped to the signed 16-bit field
+    int32_t load_rate = sensor_data.load_rate / (1000 / PRESSURE_PA_PER_LSB);
+    if (load_rate > INT16_MAX) {
+        load_rate = INT16_MAX;
+    } else if (load_rate < INT16_MIN) {
+        load_rate = INT16_MIN;
+    }
     
-    // Send notification
-    user_custs1_sensor_data_send(data, idx);
+    // Packed straight into the notification (layout: tools/packets.json)
+    pkt_sensor_t pkt = {
+        .accel_x = (uint8_t)((sensor_data.accel_x * 50.0f) + 128),
+        .accel_y = (uint8_t)((sensor_data.accel_y * 50.0f) + 128),
+        .accel_z = (uint8_t)((sensor_data.accel_z * 50.0f) + 128),
+        .jump_height = (uint8_t)(device.jump_height),
+        .total_jumps = (uint16_t)device.total_jumps,
+        .pressure = sensor_data.pressure,
+        .battery_mv = device.battery_mv,
+        .sample_time = user_time_sync_to_shared(sensor_data.timestamp_us),
+        .load_rate = (int16_t)load_rate
+    };
+    user_pkt_sensor_send(CONIDX_ALL, &pkt);
     
     last_transmission = get_time_ms();
+    
+    PROFILE_END(PROF_BLE_TRANSMIT);
 }
 
 /**
  * @brief Get system time in milliseconds
  */
 static uint32_t get_time_ms(void) {
-    return system_ticks;
+    uint32_t hi;
+    uint32_t ticks;
+    
+    do {
+        hi = system_ticks_hi;
+        ticks = system_ticks;
+    } while (hi != system_ticks_hi);
+    
+    // 1024 ticks per second: 125/128 ms per tick
+    return (uint32_t)(((((uint64_t)hi << 32) | ticks) * 125) >> 7);
+}
+
+/**
+ * @brief Get system time in microseconds since boot (30.5us resolution)
+ */
+uint64_t user_get_time_us64(void) {
+    uint32_t hi;
+    uint32_t ticks;
+    uint16_t remaining;
+    
+    // Re-read if the tick fired between the reads
+    do {
+        hi = system_ticks_hi;
+        ticks = system_ticks;
+        remaining = GetWord16(TIMER0_ON_REG);
+    } while (ticks != system_ticks || hi != system_ticks_hi);
+    
+    uint32_t sub_counts = (remaining < TICK_SUBDIV) ? (TICK_SUBDIV - remaining) : 0;
+    uint64_t counts = ((((uint64_t)hi << 32) | ticks) * TICK_SUBDIV) + sub_counts;
+    
+    // 10^6 / 32768 = 15625 / 512 us per 32.768kHz count
+    return (counts * 15625) >> 9;
+}
+
+/**
+ * @brief Get system time in microseconds, mod 2^32 (wraps every 71.6 min)
+ */
+uint32_t user_get_time_us(void) {
+    return (uint32_t)user_get_time_us64();
 }
 
 /**
@@ -319,6 +689,43 @@ static void delay_ms(uint32_t ms) {
     }
 }
 
+/**
+ * @brief Turn LED on for a time without blocking the sampling loop
+ */
+static void led_pulse(uint32_t ms) {
+    GPIO_SetActive(GPIO_PORT_0, LED_PIN);
+    led_on = true;
+    led_off_time = get_time_ms() + ms;
+}
+
+/**
+ * @brief Turn LED off once a pulse has expired
+ */
+static void led_update(void) {
+#if CFG_FALL_DETECTION
+    // Fast blink while a fall alert is pending
+    if (user_fall_alert_active()) {
+        bool on = ((get_time_ms() / LED_ALERT_BLINK_MS) & 1) != 0;
+        
+        if (on != led_on) {
+            if (on) {
+                GPIO_SetActive(GPIO_PORT_0, LED_PIN);
+            } else {
+                GPIO_SetInactive(GPIO_PORT_0, LED_PIN);
+            }
+            led_on = on;
+        }
+        led_off_time = get_time_ms();
+        return;
+    }
+#endif
+    
+    if (led_on && (int32_t)(get_time_ms() - led_off_time) >= 0) {
+        GPIO_SetInactive(GPIO_PORT_0, LED_PIN);
+        led_on = false;
+    }
+}
+
 /**
  * @brief Flash LED for visual feedback
  */
@@ -331,4 +738,247 @@ static void led_flash(uint8_t count) {
             delay_ms(100);
         }
     }
+}
+
+/**
+ * @brief Push live metrics into the advertising payload
+ */
+static void broadcast_refresh(bool jump_event) {
+#if CFG_ADV_BROADCAST
+    broadcast_metrics_t metrics = {
+        .total_jumps = (uint16_t)device.total_jumps,
+        .last_height_mm = (uint16_t)(device.jump_height * 10.0f),
+        .max_height_mm = (uint16_t)(device.max_height * 10.0f),
+        .battery_mv = device.battery_mv
+    };
+    
+    user_broadcast_update(&metrics, jump_event);
+#endif
+}
+
+/**
+ * @brief Send jump record stamped with takeoff time in the shared timebase
+ */
+static void send_jump_record(void) {
+    pkt_jump_t pkt = {
+        .height = (uint8_t)(device.jump_height),
+        .flight_ms = (uint16_t)(device.flight_time * 1000.0f),
+        .total_jumps = (uint16_t)device.total_jumps,
+        .max_height = (uint8_t)(device.max_height),
+        .takeoff_time = user_time_sync_to_shared(device.jump_start_us)
+    };
+    
+    user_pkt_jump_send(CONIDX_ALL, &pkt);
+}
+
+/**
+ * @brief Feed the current sample to the jump capture ring
+ */
+static void capture_sample(void) {
+#if CFG_JUMP_CAPTURE
+    capture_sample_t sample = {
+        .accel = {
+            (int16_t)(sensor_data.accel_x * 1000.0f),
+            (int16_t)(sensor_data.accel_y * 1000.0f),
+            (int16_t)(sensor_data.accel_z * 1000.0f)
+        },
+        .gyro = {
+            (int16_t)(sensor_data.gyro_x * 10.0f),
+            (int16_t)(sensor_data.gyro_y * 10.0f),
+            (int16_t)(sensor_data.gyro_z * 10.0f)
+        },
+        .pressure = sensor_data.pressure
+    };
+    
+    user_capture_push(&sample, loop_rate_hz());
+#endif
+}
+
+/**
+ * @brief Run actions requested over BLE in the sampling context
+ */
+static void process_actions(void) {
+    uint8_t actions = user_ctrl_take_actions();
+    uint32_t total_jumps;
+    
+    if (actions & CTRL_ACTION_CALIBRATE) {
+        calibrate_sensors();
+    }
+    
+    if (actions & CTRL_ACTION_RESET_COUNTERS) {
+        device.total_jumps = 0;
+        device.jump_height = 0.0f;
+        device.max_height = 0.0f;
+        broadcast_refresh(false);
+        printf("Counters reset\n");
+    }
+    
+    if (user_ctrl_take_jump_count(&total_jumps)) {
+        device.total_jumps = total_jumps;
+        broadcast_refresh(false);
+    }
+    
+    user_pressure_save_poll();
+#if CFG_REP_COUNTER
+    user_reps_save_poll();
+#endif
+#if CFG_OTA
+    // Image sector erases and resume points, kept out of the BLE handlers
+    user_ota_poll();
+#endif
+}
+
+/**
+ * @brief Publish live state for status/diagnostic registers
+ */
+static void publish_status(void) {
+    app_status_t *status = user_ctrl_status();
+    
+    status->uptime_ms = get_time_ms();
+    status->total_jumps = device.total_jumps;
+    status->battery_mv = device.battery_mv;
+    status->calibrated = calibration.calibrated;
+    status->in_jump = device.in_jump;
+#if CFG_WEAR_DETECTION
+    status->off_body = user_wear_off_body();
+#endif
+}
+
+/**
+ * @brief Run the gait engine on the current sample in medical mode
+ */
+static void gait_update(void) {
+    static bool gait_active = false;
+    
+    if (user_ctrl_settings()->mode != DEVICE_MODE_MEDICAL) {
+        gait_active = false;
+        return;
+    }
+    
+    if (!gait_active) {
+        user_gait_init(sensor_data.timestamp);
+        gait_active = true;
+    }
+    
+    gait_sample_t sample = {
+        .time_ms = sensor_data.timestamp,
+        .accel_mg = accel_magnitude_mg(),
+        .pressure = sensor_data.pressure
+    };
+    
+    PROFILE_BEGIN();
+    user_gait_process(&sample);
+    
+    PROFILE_END(PROF_GAIT);
+}
+
+/**
+ * @brief Count exercise repetitions on the current sample in medical mode
+ */
+static void reps_update(void) {
+#if CFG_REP_COUNTER
+    static bool reps_active = false;
+    
+    if (user_ctrl_settings()->mode != DEVICE_MODE_MEDICAL) {
+        reps_active = false;
+        return;
+    }
+    
+    if (!reps_active) {
+        user_reps_reset();
+        reps_active = true;
+    }
+    
+    reps_sample_t sample = {
+        .time_ms = sensor_data.timestamp,
+        .accel = {
+            (int16_t)(sensor_data.accel_x * 1000.0f),
+            (int16_t)(sensor_data.accel_y * 1000.0f),
+            (int16_t)(sensor_data.accel_z * 1000.0f)
+        },
+        .accel_mg = accel_magnitude_mg()
+    };
+    
+    PROFILE_BEGIN();
+    user_reps_process(&sample);
+    
+    PROFILE_END(PROF_REPS);
+#endif
+}
+
+/**
+ * @brief Run the off-body detector on the current sample
+ * @return false while the band is not worn
+ */
+static bool wear_update(void) {
+#if CFG_WEAR_DETECTION
+    wear_sample_t sample = {
+        .time_ms = sensor_data.timestamp,
+        .accel = {
+            (int16_t)(sensor_data.accel_x * 1000.0f),
+            (int16_t)(sensor_data.accel_y * 1000.0f),
+            (int16_t)(sensor_data.accel_z * 1000.0f)
+        },
+        .accel_mg = accel_magnitude_mg(),
+        .pressure = sensor_data.pressure,
+#if CFG_FALL_DETECTION
+        // A wearer lying still after a fall must not look removed
+        .hold_on = user_fall_in_progress()
+#else
+        .hold_on = false
+#endif
+    };
+    
+    if (user_wear_process(&sample, user_power_sample_rate()) && user_wear_off_body()) {
+        // A jump in progress when the band came off never lands
+        device.in_jump = false;
+    }
+    
+    return !user_wear_off_body();
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief Sampling loop rate: battery tier cap, or the off-body rate
+ */
+static uint8_t loop_rate_hz(void) {
+#if CFG_WEAR_DETECTION
+    if (user_wear_off_body()) {
+        return WEAR_OFF_SAMPLE_HZ;
+    }
+#endif
+    return user_power_sample_rate();
+}
+
+/**
+ * @brief Acceleration magnitude of the current sample in mg
+ */
+static uint16_t accel_magnitude_mg(void) {
+    return (sensor_data.accel_mag > 65.0f) ? 0xFFFF : (uint16_t)(sensor_data.accel_mag * 1000.0f);
+}
+
+/**
+ * @brief Run the fall detector first so alerts leave with minimum delay
+ */
+static void fall_update(void) {
+#if CFG_FALL_DETECTION
+    // Jumps look like free-fall + impact, only watch for falls in medical mode
+    if (user_ctrl_settings()->mode == DEVICE_MODE_MEDICAL) {
+        fall_sample_t sample = {
+            .time_us = sensor_data.timestamp_us,
+            .accel = {
+                (int16_t)(sensor_data.accel_x * 1000.0f),
+                (int16_t)(sensor_data.accel_y * 1000.0f),
+                (int16_t)(sensor_data.accel_z * 1000.0f)
+            },
+            .accel_mg = accel_magnitude_mg(),
+            .gyro_l1_dps = (uint16_t)(fabsf(sensor_data.gyro_x) + fabsf(sensor_data.gyro_y) +
+                                      fabsf(sensor_data.gyro_z))
+        };
+        
+        user_fall_process(&sample);
+    }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,423 @@
+/**
+ * @file bench.c
+ * @brief Host benchmark and accuracy run of the sampling loop over one sensor trace
+ * @author Muhammad Umer Sajid, Student
+ *
+ * main.c is compiled in unchanged with its main() renamed, so read_sensors(),
+ * detect_jump(), gait_update(), reps_update() and ble_transmit() are the
+ * firmware functions, linked against the firmware modules and the SDK stubs.
+ * Each trace row sets the clock (system tick plus TIMER0_ON_REG) and the
+ * pressure ADC code, then runs the worn path of the main loop. There is no
+ * BMI270 driver yet (read_sensors() makes up IMU values), so the trace's IMU
+ * values replace them right after read_sensors(), magnitude included.
+ * A fake central is connected and subscribed; it takes one notification off
+ * the link per sample and, like the app, acknowledges a confirmed fall alert
+ * as soon as it arrives.
+ *
+ * Output, one item per line, for tools/bench.py:
+ *   samples <n>
+ *   ns_per_sample <fastest of BENCH_PASSES passes>
+ *   jump <takeoff ms> <landing ms> <height cm>     every counted jump (first pass)
+ *   alert <type> <impact ms>                       every fall alert (first pass)
+ *   fall_latency_max <ms>                          impact to alert confirm, if any alert
+ *   ntf <handle> <hex>                             every notification (first pass)
+ *   pressure_err_max <25 Pa LSB>                   read_sensors() vs the ideal CIC + table
+ * and with BENCH_COST (cost model build, one pass):
+ *   cost_sample <avg insns> <avg cycles> <max cycles>
+ *   cost_unknown <blocks entered that are missing from the table>
+ *   cost_section <name> <calls> <avg cycles> <max cycles> <budget>
+ *
+ * Usage: bench <trace.csv> [cost block table]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "central.h"
+#include "cost.h"
+
+#define main firmware_main
+#include "../main.c"
+#undef main
+
+#define BENCH_PASSES                    5
+#define BENCH_BOOT_MS                   1000    // Clock at the first sample
+#define BENCH_PASS_GAP_MS               2000
+#define BENCH_TEMPLATES_MAX             REPS_TEMPLATE_SLOTS
+
+#ifdef BENCH_COST
+    #define BENCH_HARNESS               __attribute__((no_sanitize_coverage))
+#else
+    #define BENCH_HARNESS
+#endif
+
+// One trace row
+typedef struct {
+    uint32_t ms;
+    int16_t accel[3];       // mg
+    int16_t gyro[3];        // 0.1 dps
+    uint16_t adc;           // 10-bit pressure code
+} bench_row_t;
+
+// Global Variables
+static bench_row_t *rows = NULL;
+static uint32_t row_count = 0;
+static bool medical = false;
+static uint8_t templates[BENCH_TEMPLATES_MAX][REPS_TEMPLATE_BLOB_LEN];
+static uint8_t template_count = 0;
+static uint16_t adc_code = 0;
+static FILE *report = NULL;
+
+// Local Functions
+static bool load_trace(const char *path);
+static void set_clock_ms(uint32_t ms);
+static uint16_t adc_read(uint16_t channel);
+static void boot(void);
+static void inject_imu(const bench_row_t *row);
+static void run_sample(const bench_row_t *row);
+static void app_alert(const central_ntf_t *ntf, uint32_t base_ms, bool record);
+static uint32_t run_pass(uint32_t base_ms, bool record);
+#ifdef BENCH_COST
+static void print_sections(void);
+#endif
+
+BENCH_HARNESS int main(int argc, char **argv) {
+    if (argc < 2 || !load_trace(argv[1])) {
+        fprintf(stderr, "usage: bench <trace.csv> [cost block table]\n");
+        return 2;
+    }
+
+#ifdef BENCH_COST
+    if (argc < 3 || !cost_load(argv[2])) {
+        fprintf(stderr, "bench: no cost block table\n");
+        return 2;
+    }
+#endif
+
+    // Results on the real stdout, firmware console output discarded
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        return 2;
+    }
+
+    boot();
+    fprintf(report, "samples %u\n", row_count);
+
+    uint32_t err_max = run_pass(BENCH_BOOT_MS, true);
+    fprintf(report, "pressure_err_max %u\n", err_max);
+
+#if CFG_FALL_DETECTION
+    fall_stats_t fall;
+    user_fall_get_stats(&fall);
+    if (fall.alerts > 0) {
+        fprintf(report, "fall_latency_max %u\n", fall.max_latency_ms);
+    }
+#endif
+
+#ifdef BENCH_COST
+    print_sections();
+#else
+    uint32_t pass_ms = rows[row_count - 1].ms + BENCH_PASS_GAP_MS;
+    double best_ns = 0.0;
+
+    // Later passes replay the trace for timing only, detector state carries on
+    for (uint32_t pass = 1; pass < BENCH_PASSES; pass++) {
+        struct timespec start;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_pass(BENCH_BOOT_MS + pass * pass_ms, false);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / row_count;
+        if (pass == 1 || ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+    fprintf(report, "ns_per_sample %.1f\n", best_ns);
+#endif
+
+    fclose(report);
+    return 0;
+}
+
+/**
+ * @brief Read the CSV rows, the mode and the rep templates
+ */
+BENCH_HARNESS static bool load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+    uint32_t size = 0;
+
+    if (f == NULL) {
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        bench_row_t row;
+        int v[8];
+
+        if (strncmp(line, "# mode: ", 8) == 0) {
+            medical = strncmp(line + 8, "medical", 7) == 0;
+            continue;
+        }
+        if (strncmp(line, "# template: ", 12) == 0 && template_count < BENCH_TEMPLATES_MAX) {
+            const char *hex = line + 12;
+            for (uint32_t i = 0; i < REPS_TEMPLATE_BLOB_LEN; i++) {
+                unsigned byte = 0;
+                if (sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+                    break;
+                }
+                templates[template_count][i] = (uint8_t)byte;
+            }
+            template_count++;
+            continue;
+        }
+        if (sscanf(line, "%d,%d,%d,%d,%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3],
+                   &v[4], &v[5], &v[6], &v[7]) != 8) {
+            continue;
+        }
+
+        row.ms = (uint32_t)v[0];
+        for (uint8_t i = 0; i < 3; i++) {
+            row.accel[i] = (int16_t)v[1 + i];
+            row.gyro[i] = (int16_t)v[4 + i];
+        }
+        row.adc = (uint16_t)v[7];
+
+        if (row_count == size) {
+            size = size ? size * 2 : 4096;
+            rows = realloc(rows, size * sizeof(*rows));
+        }
+        rows[row_count++] = row;
+    }
+    fclose(f);
+
+    return row_count > 0;
+}
+
+/**
+ * @brief Put the timer where it is at a given time since boot
+ */
+BENCH_HARNESS static void set_clock_ms(uint32_t ms) {
+    // 32.768kHz counts: whole ticks of TICK_SUBDIV plus the counter's remaining part
+    uint64_t counts = ((uint64_t)ms * 32768) / 1000;
+    uint64_t ticks = counts / TICK_SUBDIV;
+
+    system_ticks = (uint32_t)ticks;
+    system_ticks_hi = (uint32_t)(ticks >> 32);
+    stub_timer0_remaining = (uint16_t)(TICK_SUBDIV - (counts % TICK_SUBDIV));
+}
+
+/**
+ * @brief Pressure input follows the trace, VBAT a fresh cell
+ */
+BENCH_HARNESS static uint16_t adc_read(uint16_t channel) {
+    return (channel == PRESSURE_ADC_CHANNEL) ? adc_code : 853;
+}
+
+/**
+ * @brief Start up as main() does, then connect a central and load the session setup
+ */
+BENCH_HARNESS static void boot(void) {
+    stub_adc_read = adc_read;
+    set_clock_ms(BENCH_BOOT_MS - 100);
+
+    system_init();
+    calibrate_sensors();
+#if CFG_WEAR_DETECTION
+    user_wear_init(get_time_ms());
+#endif
+
+    central_init();
+    central_connect(0);
+    central_subscribe(0, CUSTS1_IDX_SENSOR_DATA_NTF_CFG, true);
+    central_subscribe(0, CUSTS1_IDX_JUMP_METRICS_NTF_CFG, true);
+    central_subscribe(0, CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG, true);
+
+    user_ctrl_set_mode(medical ? DEVICE_MODE_MEDICAL : DEVICE_MODE_GYMNASTICS);
+    for (uint8_t i = 0; i < template_count; i++) {
+        user_reps_set_template(templates[i]);
+    }
+
+    // Drop the set-up traffic and the boot costs
+    central_init();
+#if CFG_PROFILE_HOT_PATHS
+    user_profile_init();
+#endif
+}
+
+/**
+ * @brief Trace IMU in place of the placeholder values (mg, 0.1 dps)
+ */
+BENCH_HARNESS static void inject_imu(const bench_row_t *row) {
+    sensor_data.accel_x = row->accel[0] * 0.001f;
+    sensor_data.accel_y = row->accel[1] * 0.001f;
+    sensor_data.accel_z = row->accel[2] * 0.001f;
+    sensor_data.gyro_x = row->gyro[0] * 0.1f;
+    sensor_data.gyro_y = row->gyro[1] * 0.1f;
+    sensor_data.gyro_z = row->gyro[2] * 0.1f;
+    sensor_data.accel_mag = sqrtf(sensor_data.accel_x * sensor_data.accel_x +
+                                  sensor_data.accel_y * sensor_data.accel_y +
+                                  sensor_data.accel_z * sensor_data.accel_z);
+}
+
+/**
+ * @brief One pass of the main loop, worn path, as in main()
+ */
+static void run_sample(const bench_row_t *row) {
+    read_sensors();
+    inject_imu(row);
+
+    bool worn = wear_update();
+    if (worn) {
+        fall_update();
+        capture_sample();
+        detect_jump();
+        gait_update();
+        reps_update();
+    }
+
+#if CFG_FALL_DETECTION
+    user_fall_poll(user_get_time_us());
+#endif
+
+    bool streaming = worn && user_power_tier() < POWER_TIER_CUTOFF;
+#if CFG_OTA
+    streaming = streaming && !user_ota_active();
+#endif
+
+    if (user_ble_get_state() == BLE_CONNECTED && streaming) {
+        ble_transmit();
+#if CFG_JUMP_CAPTURE
+        if (!user_fall_alert_active()) {
+            user_capture_poll_tx();
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Replay the trace once from a given clock
+ * @param record Print jumps and notifications, and check the pressure chain
+ * @return Largest pressure error in 25 Pa LSB
+ */
+BENCH_HARNESS static uint32_t run_pass(uint32_t base_ms, bool record) {
+    uint32_t jumps = device.total_jumps;
+    uint32_t err_max = 0;
+    uint16_t prev_code = 0;
+    uint64_t insns_sum = 0;
+    uint64_t cycles_sum = 0;
+    uint64_t cycles_max = 0;
+
+    device.in_jump = false;
+
+    for (uint32_t i = 0; i < row_count; i++) {
+        const bench_row_t *row = &rows[i];
+        uint64_t insns = cost_insns;
+        uint64_t cycles = cost_cycles;
+
+        set_clock_ms(base_ms + row->ms);
+        adc_code = row->adc;
+
+        run_sample(row);
+
+        insns_sum += cost_insns - insns;
+        cycles_sum += cost_cycles - cycles;
+        if (cost_cycles - cycles > cycles_max) {
+            cycles_max = cost_cycles - cycles;
+        }
+
+        if (record && i > 0) {
+            // CIC weights over this burst and the last sum to 36 and 28 (of 64),
+            // the default table maps 1023 codes to 4000 LSB
+            float ideal = (36.0f * adc_code + 28.0f * prev_code) / 64.0f * 4000.0f / 1023.0f;
+            uint32_t err = (uint32_t)fabsf(sensor_data.pressure - ideal);
+            err_max = (err > err_max) ? err : err_max;
+        }
+        prev_code = adc_code;
+
+        if (record && device.total_jumps != jumps) {
+            fprintf(report, "jump %u %u %.2f\n", device.jump_start - base_ms,
+                    sensor_data.timestamp - base_ms, device.jump_height);
+        }
+        jumps = device.total_jumps;
+
+        // The link sends one notification per sample
+        central_confirm(0, 1);
+        central_ntf_t ntf;
+        while (central_receive(&ntf)) {
+            if (ntf.handle == CUSTS1_IDX_DEVICE_CONTROL_VAL && ntf.value[0] == DATA_HEADER_ALERT) {
+                app_alert(&ntf, base_ms, record);
+            }
+            if (!record) {
+                continue;
+            }
+            fprintf(report, "ntf %u ", ntf.handle);
+            for (uint16_t b = 0; b < ntf.length; b++) {
+                fprintf(report, "%02x", ntf.value[b]);
+            }
+            fprintf(report, "\n");
+        }
+    }
+
+#ifdef BENCH_COST
+    fprintf(report, "cost_sample %.1f %.1f %llu\n", (double)insns_sum / row_count,
+            (double)cycles_sum / row_count, (unsigned long long)cycles_max);
+    fprintf(report, "cost_unknown %llu\n", (unsigned long long)cost_unknown);
+#endif
+
+    return err_max;
+}
+
+/**
+ * @brief The app's side of a fall alert: note it, acknowledge a confirmed one
+ */
+BENCH_HARNESS static void app_alert(const central_ntf_t *ntf, uint32_t base_ms, bool record) {
+    uint8_t type = ntf->value[1];
+    uint32_t impact_us = (uint32_t)ntf->value[3] | ((uint32_t)ntf->value[4] << 8) |
+                         ((uint32_t)ntf->value[5] << 16) | ((uint32_t)ntf->value[6] << 24);
+
+    if (record) {
+        fprintf(report, "alert %u %u\n", type, impact_us / 1000 - base_ms);
+    }
+    if (type == FALL_ALERT_CONFIRMED) {
+        uint8_t ack = DEVICE_CMD_ALERT_ACK;
+        central_write(0, CUSTS1_IDX_DEVICE_CONTROL_VAL, &ack, 1);
+    }
+}
+
+#ifdef BENCH_COST
+/**
+ * @brief Cost model cycles per profiled section, from the firmware's own profiler
+ */
+BENCH_HARNESS static void print_sections(void) {
+#if CFG_PROFILE_HOT_PATHS
+    static const struct {
+        prof_section_t section;
+        const char *name;
+        uint32_t budget;
+    } sections[] = {
+        { PROF_READ_SENSORS, "read_sensors", PROFILE_BUDGET_READ_SENSORS },
+        { PROF_PRESSURE, "pressure", PROFILE_BUDGET_PRESSURE },
+        { PROF_DETECT_JUMP, "detect_jump", PROFILE_BUDGET_DETECT_JUMP },
+        { PROF_BLE_TRANSMIT, "ble_transmit", PROFILE_BUDGET_BLE_TRANSMIT },
+        { PROF_GAIT, "gait", PROFILE_BUDGET_GAIT },
+        { PROF_REPS, "reps", PROFILE_BUDGET_REPS }
+    };
+
+    for (uint8_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+        prof_stats_t stats;
+
+        user_profile_get(sections[i].section, &stats);
+        if (stats.calls == 0) {
+            continue;
+        }
+        fprintf(report, "cost_section %s %u %u %u %u\n", sections[i].name, stats.calls,
+                stats.total_cycles / stats.calls, stats.max_cycles, sections[i].budget);
+    }
+#endif
+}
+#endif
@@ -0,0 +1,465 @@
+/**
+ * @file bench_ops.c
+ * @brief Host benchmark of single firmware operations outside the sampling loop
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Each operation runs over fixed inputs; the cost model build (BENCH_COST)
+ * reports the modeled Cortex-M0+ cost per call, the plain build the fastest
+ * host time per call. Harness functions are not instrumented (BENCH_HARNESS),
+ * so setup and draining the fake central cost nothing; reference versions of
+ * replaced firmware code (pressure_old) are, so they can be compared.
+ *
+ * Output, one item per line, for tools/bench.py:
+ *   <op> ns_per_op <fastest of BENCH_PASSES passes>
+ *   <op> <accuracy metric> <value>                 ops with a check()
+ * and with BENCH_COST:
+ *   <op> insns <avg> / cycles <avg> / cycles_max <max>
+ *   cost_unknown <blocks entered that are missing from the table>
+ *
+ * Usage: bench_ops [cost block table]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include "central.h"
+#include "cost.h"
+#include "user_ctrl.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_pressure.h"
+#include "user_reps.h"
+
+#define BENCH_PASSES                    5
+#define CTRL_FUZZ_FRAMES                256
+#define CTRL_FUZZ_LEN_MAX               64
+#define PRESSURE_SAMPLES                4000
+#define PRESSURE_HOLD                   50      // Samples per load level
+#define PRESSURE_NOISE_CODES            2.0     // rms ADC noise per conversion
+#define REPS_SAMPLE_HZ                  100     // IMU rate in medical mode
+#define REPS_SAMPLES                    9000
+#define REPS_PER_SET                    10
+#define REPS_SETS                       2
+
+#ifdef BENCH_COST
+    #define BENCH_HARNESS               __attribute__((no_sanitize_coverage))
+#else
+    #define BENCH_HARNESS
+#endif
+
+// One benchmarked operation: call i of count runs the same kind of work
+typedef struct {
+    const char *name;
+    uint32_t count;
+    void (*setup)(void);
+    void (*run)(uint32_t i);
+    void (*done)(void);         // After each call, not measured
+    void (*check)(const char *name);    // Accuracy, plain build only (optional)
+} bench_op_t;
+
+// Global Variables
+static FILE *report = NULL;
+static uint8_t ctrl_fuzz[CTRL_FUZZ_FRAMES][CTRL_FUZZ_LEN_MAX];
+static uint8_t ctrl_fuzz_len[CTRL_FUZZ_FRAMES];
+static uint16_t pressure_codes[PRESSURE_SAMPLES][PRESSURE_OVERSAMPLE];
+static double pressure_truth_pa[PRESSURE_SAMPLES];
+static uint32_t pressure_out_pa = 0;
+static reps_sample_t reps_input[REPS_SAMPLES];
+static uint32_t reps_time_ms = 0;       // Keeps time running across passes
+
+// A typical app setup: five SETs and two GETs
+static const uint8_t ctrl_setup_frame[] = {
+    DEVICE_CMD_TLV_FRAME, 1,
+    CTRL_OP_SET, CTRL_REG_JUMP_THRESHOLD, 2, 0x08, 0x07,
+    CTRL_OP_SET, CTRL_REG_LANDING_THRESHOLD, 2, 0xB8, 0x0B,
+    CTRL_OP_SET, CTRL_REG_SAMPLE_RATE, 1, 50,
+    CTRL_OP_SET, CTRL_REG_TX_RATE, 1, 10,
+    CTRL_OP_SET, CTRL_REG_MODE, 1, DEVICE_MODE_GYMNASTICS,
+    CTRL_OP_GET, CTRL_REG_STATUS, 0,
+    CTRL_OP_GET, CTRL_REG_SCHEMA_VERSION, 0
+};
+
+// Status and the three diagnostics registers, 55 bytes of answer
+static const uint8_t ctrl_diag_frame[] = {
+    DEVICE_CMD_TLV_FRAME, 2,
+    CTRL_OP_GET, CTRL_REG_STATUS, 0,
+    CTRL_OP_GET, CTRL_REG_DIAG_SYSTEM, 0,
+    CTRL_OP_GET, CTRL_REG_DIAG_MEMORY, 0,
+    CTRL_OP_GET, CTRL_REG_DIAG_WEAR, 0
+};
+
+// Local Functions
+static void ctrl_setup(void);
+static void ctrl_done(void);
+static void ctrl_run_setup(uint32_t i);
+static void ctrl_run_diag(uint32_t i);
+static void ctrl_run_fuzz(uint32_t i);
+static void pressure_setup(void);
+static void pressure_done(void);
+static uint8_t pressure_old(uint16_t adc_raw);
+static void pressure_run_old(uint32_t i);
+static void pressure_run_cic(uint32_t i);
+static void pressure_check(const char *name);
+static void reps_load_templates(void);
+static void reps_setup_idle(void);
+static void reps_setup_exercise(void);
+static void reps_magnitude(void);
+static void reps_done(void);
+static void reps_run(uint32_t i);
+static void reps_check(const char *name);
+static void measure(const bench_op_t *op);
+
+static const bench_op_t ops[] = {
+    { "ctrl_setup", 1000, ctrl_setup, ctrl_run_setup, ctrl_done, NULL },
+    { "ctrl_diag", 1000, ctrl_setup, ctrl_run_diag, ctrl_done, NULL },
+    { "ctrl_fuzz", CTRL_FUZZ_FRAMES, ctrl_setup, ctrl_run_fuzz, ctrl_done, NULL },
+    { "pressure_old", PRESSURE_SAMPLES, pressure_setup, pressure_run_old, pressure_done, pressure_check },
+    { "pressure_cic", PRESSURE_SAMPLES, pressure_setup, pressure_run_cic, pressure_done, pressure_check },
+    { "reps_idle", REPS_SAMPLES, reps_setup_idle, reps_run, reps_done, reps_check },
+    { "reps_exercise", REPS_SAMPLES, reps_setup_exercise, reps_run, reps_done, reps_check }
+};
+
+BENCH_HARNESS int main(int argc, char **argv) {
+#ifdef BENCH_COST
+    if (argc < 2 || !cost_load(argv[1])) {
+        fprintf(stderr, "bench_ops: no cost block table\n");
+        return 2;
+    }
+#endif
+
+    // Results on the real stdout, firmware console output discarded
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        return 2;
+    }
+
+    for (uint32_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        measure(&ops[i]);
+    }
+
+#ifdef BENCH_COST
+    fprintf(report, "cost_unknown %llu\n", (unsigned long long)cost_unknown);
+#endif
+    fclose(report);
+    return 0;
+}
+
+/**
+ * @brief One connected central at the largest MTU, random frames for the fuzz case
+ */
+BENCH_HARNESS static void ctrl_setup(void) {
+    uint32_t rng = 31;
+
+    user_ctrl_init();
+    central_init();
+    central_connect(0);
+    central_subscribe(0, CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG, true);
+    stub_mtu = 247;
+    ctrl_done();
+
+    // Random bytes after the command: mostly malformed or unknown operations
+    for (uint32_t i = 0; i < CTRL_FUZZ_FRAMES; i++) {
+        rng = rng * 1103515245u + 12345u;
+        ctrl_fuzz_len[i] = 2 + (rng >> 8) % (CTRL_FUZZ_LEN_MAX - 2);
+        ctrl_fuzz[i][0] = DEVICE_CMD_TLV_FRAME;
+        for (uint32_t b = 1; b < ctrl_fuzz_len[i]; b++) {
+            rng = rng * 1103515245u + 12345u;
+            ctrl_fuzz[i][b] = (uint8_t)(rng >> 16);
+        }
+    }
+}
+
+/**
+ * @brief Take the answer off the link
+ */
+BENCH_HARNESS static void ctrl_done(void) {
+    central_ntf_t ntf;
+
+    central_confirm(0, CENTRAL_CFM_ALL);
+    while (central_receive(&ntf)) {
+    }
+    user_ctrl_take_actions();
+}
+
+BENCH_HARNESS static void ctrl_run_setup(uint32_t i) {
+    user_ctrl_handle_frame(0, ctrl_setup_frame, sizeof(ctrl_setup_frame));
+}
+
+BENCH_HARNESS static void ctrl_run_diag(uint32_t i) {
+    user_ctrl_handle_frame(0, ctrl_diag_frame, sizeof(ctrl_diag_frame));
+}
+
+BENCH_HARNESS static void ctrl_run_fuzz(uint32_t i) {
+    user_ctrl_handle_frame(0, ctrl_fuzz[i], ctrl_fuzz_len[i]);
+}
+
+/**
+ * @brief Load levels across the range, each held for a while, noise on every conversion
+ */
+BENCH_HARNESS static void pressure_setup(void) {
+    uint32_t rng = 34;
+    double level = 0.0;
+
+    for (uint32_t i = 0; i < PRESSURE_SAMPLES; i++) {
+        if (i % PRESSURE_HOLD == 0) {
+            rng = rng * 1103515245u + 12345u;
+            level = 20.0 + (rng >> 8) % 960;
+        }
+        pressure_truth_pa[i] = level * 100000.0 / 1023.0;
+
+        for (uint8_t n = 0; n < PRESSURE_OVERSAMPLE; n++) {
+            // Sum of 4 uniforms: close enough to gaussian for rms noise
+            double noise = 0.0;
+            for (uint8_t k = 0; k < 4; k++) {
+                rng = rng * 1103515245u + 12345u;
+                noise += ((rng >> 8) / 16777216.0) - 0.5;
+            }
+            pressure_codes[i][n] = (uint16_t)(level + noise * PRESSURE_NOISE_CODES * 1.7320508 + 0.5);
+        }
+    }
+    user_pressure_init();
+}
+
+BENCH_HARNESS static void pressure_done(void) {
+}
+
+/**
+ * @brief The conversion it replaced: one ADC sample, integer kPa (read_sensors(), ble_transmit())
+ */
+static uint8_t pressure_old(uint16_t adc_raw) {
+    return (uint8_t)((adc_raw * 100) / 1023);
+}
+
+static void pressure_run_old(uint32_t i) {
+    pressure_out_pa = pressure_old(pressure_codes[i][0]) * 1000U;
+}
+
+/**
+ * @brief One output sample of the current chain, as read_sensors() runs it
+ */
+static void pressure_run_cic(uint32_t i) {
+    pressure_out_t out;
+
+    for (uint8_t n = 0; n < PRESSURE_OVERSAMPLE; n++) {
+        user_pressure_push(pressure_codes[i][n]);
+    }
+    user_pressure_decimate(100, &out);
+    pressure_out_pa = (uint32_t)out.pressure * PRESSURE_PA_PER_LSB;
+}
+
+/**
+ * @brief rms error against the true load, first two samples of each level left out
+ */
+BENCH_HARNESS static void pressure_check(const char *name) {
+    const bench_op_t *op = NULL;
+    double sum_sq = 0.0;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        op = (strcmp(ops[i].name, name) == 0) ? &ops[i] : op;
+    }
+
+    op->setup();
+    for (uint32_t i = 0; i < PRESSURE_SAMPLES; i++) {
+        op->run(i);
+        if (i % PRESSURE_HOLD >= 2) {
+            double err = pressure_out_pa - pressure_truth_pa[i];
+            sum_sq += err * err;
+            n++;
+        }
+    }
+    fprintf(report, "%s err_rms_pa %.1f\n", name, sqrt(sum_sq / n));
+}
+
+/**
+ * @brief Three slots at the longest templates: knee extension (Z), heel raise
+ * (magnitude) and ankle circle (X)
+ */
+BENCH_HARNESS static void reps_load_templates(void) {
+    uint8_t blob[REPS_TEMPLATE_BLOB_LEN];
+
+    user_reps_init();
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        memset(blob, 0, sizeof(blob));
+        blob[0] = slot;
+        blob[1] = (slot == 0) ? REPS_AXIS_Z : ((slot == 1) ? REPS_AXIS_MAG : REPS_AXIS_X);
+        blob[2] = 160;
+        blob[4] = REPS_TEMPLATE_MAX_LEN;
+
+        for (uint8_t i = 0; i < REPS_TEMPLATE_MAX_LEN; i++) {
+            double t = i / (double)REPS_TEMPLATE_MAX_LEN;
+            double mg;
+            if (slot == 0) {
+                // Raise, hold, lower over 3.2 s, as tools/tracegen.py knee_extension()
+                double phase = (t < 0.4) ? 0.5 * (1 - cos(M_PI * t / 0.4)) :
+                               (t < 0.6) ? 1.0 : 0.5 * (1 + cos(M_PI * (t - 0.6) / 0.4));
+                mg = 1000.0 * cos(70.0 * M_PI / 180.0 * phase);
+            } else if (slot == 1) {
+                mg = 1000.0 + 400.0 * sin(2 * M_PI * t) * exp(-2.0 * t);
+            } else {
+                mg = 500.0 * sin(2 * M_PI * t);
+            }
+            blob[5 + i] = (uint8_t)(int8_t)lround(mg / REPS_LSB_MG);
+        }
+        user_reps_set_template(blob);
+    }
+}
+
+/**
+ * @brief Walking in medical mode: every window is compared, the lower bound rejects it
+ */
+BENCH_HARNESS static void reps_setup_idle(void) {
+    uint32_t rng = 39;
+
+    reps_load_templates();
+    for (uint32_t i = 0; i < REPS_SAMPLES; i++) {
+        double t = i / (double)REPS_SAMPLE_HZ;
+        rng = rng * 1103515245u + 12345u;
+        double noise = (int32_t)((rng >> 16) % 33) - 16;
+
+        reps_input[i].accel[0] = (int16_t)(150.0 * sin(2 * M_PI * 0.9 * t) + noise);
+        reps_input[i].accel[1] = (int16_t)(200.0 * sin(2 * M_PI * 1.8 * t + 1.0));
+        reps_input[i].accel[2] = (int16_t)(1000.0 + 350.0 * sin(2 * M_PI * 1.8 * t) + noise);
+    }
+    reps_magnitude();
+    reps_done();
+}
+
+/**
+ * @brief Seated knee extensions, REPS_SETS sets of REPS_PER_SET with a rest between
+ */
+BENCH_HARNESS static void reps_setup_exercise(void) {
+    uint32_t rng = 39;
+    uint32_t i = 0;
+
+    reps_load_templates();
+    while (i < REPS_SAMPLES) {
+        uint32_t rep = (i / (3 * REPS_SAMPLE_HZ)) % (REPS_PER_SET + 5);
+        double t = (i % (3 * REPS_SAMPLE_HZ)) / (double)REPS_SAMPLE_HZ;
+        double phase = 0.0;
+
+        // 1 s up, 0.4 s hold, 1 s down, 0.6 s rest; 15 s of sitting after each set
+        if (rep < REPS_PER_SET) {
+            phase = (t < 1.0) ? 0.5 * (1 - cos(M_PI * t)) :
+                    (t < 1.4) ? 1.0 : (t < 2.4) ? 0.5 * (1 + cos(M_PI * (t - 1.4))) : 0.0;
+        }
+        rng = rng * 1103515245u + 12345u;
+        double noise = (int32_t)((rng >> 16) % 33) - 16;
+        double angle = 70.0 * M_PI / 180.0 * phase;
+
+        reps_input[i].accel[0] = (int16_t)noise;
+        reps_input[i].accel[1] = (int16_t)(1000.0 * sin(angle));
+        reps_input[i].accel[2] = (int16_t)(1000.0 * cos(angle) + noise);
+        i++;
+    }
+    reps_magnitude();
+    reps_done();
+}
+
+/**
+ * @brief Magnitude as main.c passes it, computed before the measured calls
+ */
+BENCH_HARNESS static void reps_magnitude(void) {
+    for (uint32_t i = 0; i < REPS_SAMPLES; i++) {
+        reps_sample_t *s = &reps_input[i];
+        s->accel_mg = (uint16_t)sqrt((double)s->accel[0] * s->accel[0] + (double)s->accel[1] * s->accel[1] +
+                                     (double)s->accel[2] * s->accel[2]);
+    }
+}
+
+BENCH_HARNESS static void reps_done(void) {
+    reps_set_t set;
+
+    user_reps_take_set(&set);
+}
+
+/**
+ * @brief One IMU sample through the counter, as reps_update() feeds it
+ */
+static void reps_run(uint32_t i) {
+    reps_sample_t *s = &reps_input[i];
+
+    s->time_ms = reps_time_ms;
+    reps_time_ms += 1000 / REPS_SAMPLE_HZ;
+    user_reps_process(s);
+}
+
+/**
+ * @brief Reps counted against the sets in the input (none when walking)
+ */
+BENCH_HARNESS static void reps_check(const char *name) {
+    const bench_op_t *op = NULL;
+    reps_set_t set;
+    uint32_t reps = 0;
+
+    for (uint32_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        op = (strcmp(ops[i].name, name) == 0) ? &ops[i] : op;
+    }
+
+    op->setup();
+    for (uint32_t i = 0; i < op->count; i++) {
+        op->run(i);
+        reps += user_reps_take_set(&set) ? set.reps : 0;
+    }
+    uint32_t truth = (op->setup == reps_setup_exercise) ? REPS_SETS * REPS_PER_SET : 0;
+    fprintf(report, "%s reps_err %d\n", name, abs((int)reps - (int)truth));
+}
+
+/**
+ * @brief Modeled cost per call, or the fastest host time per call
+ */
+BENCH_HARNESS static void measure(const bench_op_t *op) {
+    op->setup();
+
+#ifdef BENCH_COST
+    uint64_t insns_sum = 0;
+    uint64_t cycles_sum = 0;
+    uint64_t cycles_max = 0;
+
+    for (uint32_t i = 0; i < op->count; i++) {
+        uint64_t insns = cost_insns;
+        uint64_t cycles = cost_cycles;
+
+        op->run(i);
+
+        insns_sum += cost_insns - insns;
+        cycles_sum += cost_cycles - cycles;
+        if (cost_cycles - cycles > cycles_max) {
+            cycles_max = cost_cycles - cycles;
+        }
+        op->done();
+    }
+    fprintf(report, "%s insns %.1f\n", op->name, (double)insns_sum / op->count);
+    fprintf(report, "%s cycles %.1f\n", op->name, (double)cycles_sum / op->count);
+    fprintf(report, "%s cycles_max %llu\n", op->name, (unsigned long long)cycles_max);
+#else
+    double best_ns = 0.0;
+
+    for (uint32_t pass = 0; pass < BENCH_PASSES; pass++) {
+        double ns = 0.0;
+
+        for (uint32_t i = 0; i < op->count; i++) {
+            struct timespec start;
+            struct timespec end;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            op->run(i);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            ns += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+            op->done();
+        }
+        ns /= op->count;
+        if (pass == 0 || ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+    fprintf(report, "%s ns_per_op %.1f\n", op->name, best_ns);
+
+    if (op->check != NULL) {
+        op->check(op->name);
+    }
+#endif
+}
@@ -0,0 +1,177 @@
+/**
+ * @file central.c
+ * @brief Fake BLE central for host tests
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Drives the real connection, CCCD and write handlers of user_custs1_impl.c
+ * and collects every notification the device sends. The link layer is the
+ * test: a notification stays unconfirmed (holding its TX credit) until
+ * central_confirm() says it went over the air, in order per connection.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "central.h"
+#include "user_custs1_impl.h"
+#include "user_config.h"
+
+#define CENTRAL_CFM_MAX                 64      // Unconfirmed notifications per connection
+
+// SDK callbacks in user_custs1_impl.c (registered in the SDK callback table on target)
+void user_on_connection(uint8_t conidx, struct gapc_connection_req_ind const *param);
+void user_on_disconnect(struct gapc_disconnect_ind const *param);
+
+// Global Variables
+static central_ntf_t queue[CENTRAL_QUEUE_LEN];
+static uint32_t queue_head = 0;
+static uint32_t queue_count = 0;
+static uint32_t dropped = 0;
+static uint32_t counts[CUSTS1_IDX_NB];
+
+// Handles waiting for their confirm, per connection
+static uint16_t cfm_handles[CFG_MAX_CONNECTIONS][CENTRAL_CFM_MAX];
+static uint32_t cfm_head[CFG_MAX_CONNECTIONS];
+static uint32_t cfm_count[CFG_MAX_CONNECTIONS];
+
+// Local Functions
+static void on_msg(ke_msg_id_t id, ke_task_id_t dest, const void *param, uint16_t len);
+
+/**
+ * @brief Take over the kernel message sink and forget earlier traffic
+ */
+void central_init(void) {
+    stub_msg_sent = on_msg;
+    queue_head = 0;
+    queue_count = 0;
+    dropped = 0;
+    memset(counts, 0, sizeof(counts));
+    memset(cfm_head, 0, sizeof(cfm_head));
+    memset(cfm_count, 0, sizeof(cfm_count));
+}
+
+/**
+ * @brief Open a connection through the SDK connection callback
+ */
+void central_connect(uint8_t conidx) {
+    struct gapc_connection_req_ind ind = { .conhdl = conidx, .con_interval = USER_CONNECTION_INTERVAL_MIN };
+
+    cfm_head[conidx] = 0;
+    cfm_count[conidx] = 0;
+    user_on_connection(conidx, &ind);
+}
+
+/**
+ * @brief Drop a connection; its unconfirmed notifications are lost
+ */
+void central_disconnect(uint8_t conidx) {
+    struct gapc_disconnect_ind ind = { .conhdl = conidx, .reason = 0x13 };
+
+    cfm_count[conidx] = 0;
+    user_on_disconnect(&ind);
+}
+
+/**
+ * @brief Write a CCCD (notifications on or off)
+ */
+void central_subscribe(uint8_t conidx, uint16_t cfg_handle, bool on) {
+    uint8_t value[2] = { on ? PRF_CLI_START_NTF : PRF_CLI_STOP_NTFIND, 0 };
+
+    central_write(conidx, cfg_handle, value, sizeof(value));
+}
+
+/**
+ * @brief Write a characteristic value (write command or request)
+ */
+void central_write(uint8_t conidx, uint16_t handle, const uint8_t *value, uint16_t length) {
+    struct custs1_val_write_ind *ind = malloc(sizeof(*ind) + length);
+
+    ind->conidx = conidx;
+    ind->handle = handle;
+    ind->length = length;
+    memcpy(ind->value, value, length);
+    user_custs1_val_write_ind_handler(0, ind, TASK_APP, KE_BUILD_ID(TASK_GATTC, conidx));
+    free(ind);
+}
+
+/**
+ * @brief Let up to max notifications of a connection go over the air
+ * @return Number confirmed
+ */
+uint32_t central_confirm(uint8_t conidx, uint32_t max) {
+    uint32_t done = 0;
+
+    while (done < max && cfm_count[conidx] > 0) {
+        struct custs1_val_ntf_cfm cfm = {
+            .handle = cfm_handles[conidx][cfm_head[conidx]],
+            .status = GAP_ERR_NO_ERROR
+        };
+
+        cfm_head[conidx] = (cfm_head[conidx] + 1) % CENTRAL_CFM_MAX;
+        cfm_count[conidx]--;
+        user_custs1_val_ntf_cfm_handler(0, &cfm, TASK_APP, KE_BUILD_ID(TASK_CUSTS1, conidx));
+        done++;
+    }
+    return done;
+}
+
+/**
+ * @brief Oldest notification not yet received
+ */
+bool central_receive(central_ntf_t *ntf) {
+    if (queue_count == 0) {
+        return false;
+    }
+
+    *ntf = queue[queue_head];
+    queue_head = (queue_head + 1) % CENTRAL_QUEUE_LEN;
+    queue_count--;
+    return true;
+}
+
+/**
+ * @brief Notifications sent on a characteristic since central_init()
+ */
+uint32_t central_count(uint16_t handle) {
+    return (handle < CUSTS1_IDX_NB) ? counts[handle] : 0;
+}
+
+/**
+ * @brief Notifications lost because the test did not receive them in time
+ */
+uint32_t central_dropped(void) {
+    return dropped;
+}
+
+/**
+ * @brief Kernel message sink: keep notifications, ignore the rest
+ */
+static void on_msg(ke_msg_id_t id, ke_task_id_t dest, const void *param, uint16_t len) {
+    if (id != CUSTS1_VAL_NTF_REQ) {
+        return;
+    }
+
+    const struct custs1_val_ntf_ind_req *req = param;
+    uint8_t conidx = req->conidx;
+
+    if (req->handle < CUSTS1_IDX_NB) {
+        counts[req->handle]++;
+    }
+
+    if (conidx < CFG_MAX_CONNECTIONS && cfm_count[conidx] < CENTRAL_CFM_MAX) {
+        cfm_handles[conidx][(cfm_head[conidx] + cfm_count[conidx]) % CENTRAL_CFM_MAX] = req->handle;
+        cfm_count[conidx]++;
+    }
+
+    if (queue_count == CENTRAL_QUEUE_LEN) {
+        queue_head = (queue_head + 1) % CENTRAL_QUEUE_LEN;
+        queue_count--;
+        dropped++;
+    }
+
+    central_ntf_t *ntf = &queue[(queue_head + queue_count) % CENTRAL_QUEUE_LEN];
+    ntf->conidx = conidx;
+    ntf->handle = req->handle;
+    ntf->length = (req->length > CENTRAL_VALUE_MAX) ? CENTRAL_VALUE_MAX : req->length;
+    memcpy(ntf->value, req->value, ntf->length);
+    queue_count++;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file central.h
+ * @brief Fake BLE central for host tests
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef CENTRAL_H_
+#define CENTRAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CENTRAL_QUEUE_LEN               256     // Notifications kept until received
+#define CENTRAL_VALUE_MAX               247
+#define CENTRAL_CFM_ALL                 UINT32_MAX  // central_confirm(): everything queued
+
+// One notification as it left the device
+typedef struct {
+    uint8_t conidx;
+    uint16_t handle;
+    uint16_t length;
+    uint8_t value[CENTRAL_VALUE_MAX];
+} central_ntf_t;
+
+// Function Prototypes
+void central_init(void);
+void central_connect(uint8_t conidx);
+void central_disconnect(uint8_t conidx);
+void central_subscribe(uint8_t conidx, uint16_t cfg_handle, bool on);
+void central_write(uint8_t conidx, uint16_t handle, const uint8_t *value, uint16_t length);
+uint32_t central_confirm(uint8_t conidx, uint32_t max);
+bool central_receive(central_ntf_t *ntf);
+uint32_t central_count(uint16_t handle);
+uint32_t central_dropped(void);
+
+#endif // CENTRAL_H_
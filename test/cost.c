@@ -0,0 +1,114 @@
+/**
+ * @file cost.c
+ * @brief Cortex-M0+ cost model for host builds with -fsanitize-coverage=trace-pc
+ * @author Muhammad Umer Sajid, Student
+ *
+ * gcc calls __sanitizer_cov_trace_pc() at the start of every basic block of
+ * an instrumented file. tools/bench.py reads the disassembly of the binary
+ * and writes one line per block, "address insns cycles", with the estimated
+ * Cortex-M0+ instructions and cycles of the block (soft-float, software
+ * divide). Each block entered here adds its estimate to the totals and counts
+ * SysTick down by its cycles, so user_profile.c measures the model as it
+ * would measure the real core. This file itself is not instrumented.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "cost.h"
+#include "sdk_stub.h"
+
+#define SYSTICK_MASK                    0x00FFFFFF
+
+typedef struct {
+    uintptr_t addr;
+    uint32_t insns;
+    uint32_t cycles;
+} cost_block_t;
+
+// Global Variables
+uint64_t cost_insns = 0;
+uint64_t cost_cycles = 0;
+uint64_t cost_unknown = 0;
+
+static cost_block_t *blocks = NULL;
+static size_t block_count = 0;
+
+// Local Functions
+static int block_compare(const void *a, const void *b);
+
+/**
+ * @brief Read the block table (any order)
+ */
+bool cost_load(const char *path) {
+    FILE *f = fopen(path, "r");
+    size_t size = 0;
+    unsigned long addr;
+    unsigned insns;
+    unsigned cycles;
+
+    if (f == NULL) {
+        return false;
+    }
+
+    while (fscanf(f, "%lx %u %u", &addr, &insns, &cycles) == 3) {
+        if (block_count == size) {
+            size = size ? size * 2 : 1024;
+            blocks = realloc(blocks, size * sizeof(*blocks));
+        }
+        blocks[block_count].addr = addr;
+        blocks[block_count].insns = insns;
+        blocks[block_count].cycles = cycles;
+        block_count++;
+    }
+    fclose(f);
+
+    qsort(blocks, block_count, sizeof(*blocks), block_compare);
+    return block_count > 0;
+}
+
+/**
+ * @brief Clear the totals
+ */
+void cost_reset(void) {
+    cost_insns = 0;
+    cost_cycles = 0;
+    cost_unknown = 0;
+}
+
+/**
+ * @brief Block entry hook inserted by gcc
+ */
+void __sanitizer_cov_trace_pc(void) {
+    uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+    size_t lo = 0;
+    size_t hi = block_count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (blocks[mid].addr < pc) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == block_count || blocks[lo].addr != pc) {
+        cost_unknown++;
+        return;
+    }
+
+    cost_insns += blocks[lo].insns;
+    cost_cycles += blocks[lo].cycles;
+    SysTick->VAL = (SysTick->VAL - blocks[lo].cycles) & SYSTICK_MASK;
+}
+
+/**
+ * @brief Order blocks by address for the binary search
+ */
+static int block_compare(const void *a, const void *b) {
+    uintptr_t x = ((const cost_block_t *)a)->addr;
+    uintptr_t y = ((const cost_block_t *)b)->addr;
+
+    return (x > y) - (x < y);
+}
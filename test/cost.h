@@ -0,0 +1,22 @@
+/**
+ * @file cost.h
+ * @brief Cortex-M0+ cost model for host builds with -fsanitize-coverage=trace-pc
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef COST_H_
+#define COST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Totals since start (or the last cost_reset())
+extern uint64_t cost_insns;
+extern uint64_t cost_cycles;
+extern uint64_t cost_unknown;      // Blocks missing from the table
+
+// Function Prototypes
+bool cost_load(const char *path);
+void cost_reset(void);
+
+#endif // COST_H_
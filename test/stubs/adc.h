@@ -0,0 +1,2 @@
+// Host build: see sdk_stub.h
+#include "sdk_stub.h"
@@ -0,0 +1,300 @@
+/**
+ * @file sdk_stub.c
+ * @brief Host build stand-in for the DA14531 SDK6 functions
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Peripherals that only get configured are no-ops. The parts the firmware
+ * reads back are simulated: a 128KB NOR flash image (writes only clear
+ * bits, erases set a 4KB sector to 0xFF), the GPADC, TIMER0_ON_REG, the
+ * advertising data and the kernel message heap. Tests steer them through
+ * the stub_* hooks in sdk_stub.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sdk_stub.h"
+#include "user_config.h"
+
+#define STR_(x)                         #x
+#define STR(x)                          STR_(x)
+
+// Message header kept in front of every parameter block
+typedef struct {
+    ke_msg_id_t id;
+    ke_task_id_t dest;
+    uint16_t len;
+} stub_msg_t;
+
+// Global Variables
+uint8_t stub_flash[STUB_FLASH_SIZE];
+uint32_t stub_flash_writes = 0;
+uint32_t stub_flash_erases = 0;
+bool (*stub_flash_hook)(stub_flash_op_t op, uint32_t addr, uint32_t len) = NULL;
+uint16_t stub_timer0_remaining = 0;
+uint16_t (*stub_adc_read)(uint16_t channel) = NULL;
+uint32_t stub_adc_conversions = 0;
+void (*stub_msg_sent)(ke_msg_id_t id, ke_task_id_t dest, const void *param, uint16_t len) = NULL;
+uint16_t stub_mtu = 23;
+uint32_t stub_resets = 0;
+uint8_t stub_adv_data[31];
+uint8_t stub_adv_len = 0;
+bool stub_advertising = false;
+
+const uint8_t att_decl_svc_128[16], att_decl_char_128[16], att_desc_client_char_cfg_128[16];
+
+static SysTick_Type systick;
+SysTick_Type *SysTick = &systick;
+
+// Stack for user_mem: __initial_sp is the top, the firmware paints below it
+uint32_t stub_stack[USER_STACK_SIZE / sizeof(uint32_t)];
+__asm__(".globl __initial_sp\n\t.set __initial_sp, stub_stack + " STR(USER_STACK_SIZE));
+
+static bool flash_erased = false;
+static uint16_t adc_channel = 0;
+static uint32_t msg_heap_used = 0;
+static uint32_t msg_heap_peak = 0;
+static struct gapm_start_advertise_cmd adv_cmd;
+
+// Local Functions
+static void flash_init(void);
+static bool flash_range_ok(uint32_t addr, uint32_t len);
+
+/**
+ * @brief Erase the whole flash image
+ */
+void stub_flash_erase_all(void) {
+    memset(stub_flash, 0xFF, sizeof(stub_flash));
+    flash_erased = true;
+}
+
+int8_t spi_flash_read_data(uint8_t *buf, uint32_t addr, uint32_t len, uint32_t *actual) {
+    flash_init();
+    if (!flash_range_ok(addr, len)) {
+        return STUB_FLASH_ERR;
+    }
+    memcpy(buf, &stub_flash[addr], len);
+    *actual = len;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_write_data(uint8_t *buf, uint32_t addr, uint32_t len, uint32_t *actual) {
+    flash_init();
+    if (!flash_range_ok(addr, len) || (stub_flash_hook != NULL && !stub_flash_hook(STUB_FLASH_WRITE, addr, len))) {
+        return STUB_FLASH_ERR;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        stub_flash[addr + i] &= buf[i];
+    }
+    stub_flash_writes++;
+    *actual = len;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_block_erase(uint32_t addr, int type) {
+    flash_init();
+    addr &= ~(uint32_t)(STUB_FLASH_SECTOR - 1);
+    if (!flash_range_ok(addr, STUB_FLASH_SECTOR) ||
+        (stub_flash_hook != NULL && !stub_flash_hook(STUB_FLASH_ERASE, addr, STUB_FLASH_SECTOR))) {
+        return STUB_FLASH_ERR;
+    }
+    memset(&stub_flash[addr], 0xFF, STUB_FLASH_SECTOR);
+    stub_flash_erases++;
+    return SPI_FLASH_ERR_OK;
+}
+
+void spi_flash_release_from_power_down(void) {
+}
+
+void spi_flash_power_down(void) {
+}
+
+void spi_flash_configure_env(const spi_flash_cfg_t *cfg) {
+}
+
+void spi_initialize(const spi_cfg_t *cfg) {
+}
+
+// GPADC: conversions are instant and read from stub_adc_read
+void adc_init(const adc_config_t *cfg) {
+}
+
+void adc_enable_channel(uint16_t channel) {
+    adc_channel = channel;
+}
+
+void adc_start(void) {
+}
+
+bool adc_get_sample_status(void) {
+    return true;
+}
+
+uint16_t adc_get_sample(void) {
+    stub_adc_conversions++;
+    if (stub_adc_read != NULL) {
+        return stub_adc_read(adc_channel);
+    }
+    // 3.0V on VBAT (10-bit, 3.6V full scale), nothing on the pressure input
+    return (adc_channel == ADC_CHANNEL_VBAT3V) ? 853 : 0;
+}
+
+void adc_disable(void) {
+}
+
+// Registers
+uint16_t GetWord16(uint32_t addr) {
+    return (addr == TIMER0_ON_REG) ? stub_timer0_remaining : 0;
+}
+
+// Kernel messages, with the KE_MSG heap use of KE_PROFILING builds
+void *ke_msg_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t len) {
+    stub_msg_t *msg = calloc(1, sizeof(stub_msg_t) + len);
+
+    msg->id = id;
+    msg->dest = dest;
+    msg->len = len;
+    msg_heap_used += sizeof(struct ke_msg) + len;
+    if (msg_heap_used > msg_heap_peak) {
+        msg_heap_peak = msg_heap_used;
+    }
+    return msg + 1;
+}
+
+void ke_msg_send(void const *param) {
+    const stub_msg_t *msg = (const stub_msg_t *)param - 1;
+
+    if (stub_msg_sent != NULL) {
+        stub_msg_sent(msg->id, msg->dest, param, msg->len);
+    }
+    ke_msg_free(param);
+}
+
+void ke_msg_free(void const *param) {
+    stub_msg_t *msg = (stub_msg_t *)param - 1;
+
+    msg_heap_used -= sizeof(struct ke_msg) + msg->len;
+    free(msg);
+}
+
+bool ke_check_malloc(uint32_t size, uint8_t type) {
+    return true;
+}
+
+uint16_t ke_get_mem_usage(uint8_t type) {
+    return (type == KE_MEM_KE_MSG) ? (uint16_t)msg_heap_used : 0;
+}
+
+uint32_t ke_get_max_mem_usage(void) {
+    uint32_t peak = msg_heap_peak;
+
+    msg_heap_peak = msg_heap_used;
+    return peak;
+}
+
+ke_task_id_t prf_get_task_from_id(uint16_t id) {
+    return TASK_CUSTS1;
+}
+
+// Link
+uint8_t gapc_get_conidx(uint16_t conhdl) {
+    return (uint8_t)conhdl;
+}
+
+uint16_t gattc_get_mtu(uint8_t conidx) {
+    return stub_mtu;
+}
+
+void app_easy_gap_update_adv_data(const uint8_t *data, uint8_t len, const uint8_t *scan, uint8_t scan_len) {
+    stub_adv_len = (len > sizeof(stub_adv_data)) ? sizeof(stub_adv_data) : len;
+    memcpy(stub_adv_data, data, stub_adv_len);
+}
+
+void app_easy_gap_advertise_stop(void) {
+    stub_advertising = false;
+}
+
+struct gapm_start_advertise_cmd *app_easy_gap_undirected_advertise_get_active(void) {
+    return &adv_cmd;
+}
+
+void app_easy_gap_undirected_advertise_start(void) {
+    stub_advertising = true;
+}
+
+void app_easy_gap_set_data_packet_length(uint8_t conidx, uint16_t tx_octets, uint16_t tx_time) {
+}
+
+// System
+void system_init_func(void *arg) {
+}
+
+void platform_reset(uint32_t error) {
+    stub_resets++;
+}
+
+uint32_t __get_MSP(void) {
+    // Pretend the boot code used the top 64 words
+    return (uint32_t)(uintptr_t)&stub_stack[(USER_STACK_SIZE / sizeof(uint32_t)) - 64];
+}
+
+void __WFE(void) {
+}
+
+void __WFI(void) {
+}
+
+void __disable_irq(void) {
+}
+
+void __enable_irq(void) {
+}
+
+void __NOP(void) {
+}
+
+// Configure-only peripherals
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD mode, GPIO_FUNCTION function, bool high) {
+}
+
+void GPIO_SetActive(GPIO_PORT port, GPIO_PIN pin) {
+}
+
+void GPIO_SetInactive(GPIO_PORT port, GPIO_PIN pin) {
+}
+
+void GPIO_Disable_HW_Reset(void) {
+}
+
+void i2c_init(i2c_env_t *cfg) {
+}
+
+void uart2_init(int baud, int databits, int parity, int stopbits, int afce, int fifo) {
+}
+
+void timer0_init(int clk, int mode, int div) {
+}
+
+void timer0_set_pwm_on_counter(uint16_t count) {
+}
+
+void timer0_register_callback(void (*callback)(void)) {
+}
+
+void timer0_start(void) {
+}
+
+/**
+ * @brief Flash starts erased, as from the factory
+ */
+static void flash_init(void) {
+    if (!flash_erased) {
+        stub_flash_erase_all();
+    }
+}
+
+/**
+ * @brief Check an access stays inside the flash
+ */
+static bool flash_range_ok(uint32_t addr, uint32_t len) {
+    return addr <= STUB_FLASH_SIZE && len <= STUB_FLASH_SIZE - addr;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file sdk_stub.h
+ * @brief Host build stand-in for the DA14531 SDK6 headers
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Just enough declarations for the firmware sources to compile with the
+ * host gcc. Every SDK header name used by the firmware is a one-line file
+ * in this directory that includes this one. sdk_stub.c implements the
+ * functions, with the hooks at the end of this file standing in for the
+ * hardware: flash is a RAM image, the ADC and TIMER0_ON_REG read what the
+ * test sets, kernel messages go to a callback. Other registers read as zero.
+ */
+
+#ifndef SDK_STUB_H_
+#define SDK_STUB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Kernel messages and custom service
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+#define KE_IDX_GET(id) (((id) >> 8) & 0xFF)
+#define KE_BUILD_ID(t,i) ((ke_task_id_t)(((i) << 8) | (t)))
+enum { TASK_APP = 1, TASK_CUSTS1 = 2, TASK_ID_CUSTS1 = 3, TASK_GAPC = 4, TASK_GAPM = 5, TASK_GATTC = 6 };
+void *ke_msg_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t len);
+void ke_msg_send(void const *param);
+void ke_msg_free(void const *param);
+bool ke_check_malloc(uint32_t size, uint8_t type);
+uint16_t ke_get_mem_usage(uint8_t type);
+uint32_t ke_get_max_mem_usage(void);
+enum { KE_MEM_ENV, KE_MEM_ATT_DB, KE_MEM_KE_MSG, KE_MEM_NON_RETENTION, KE_MEM_BLOCK_MAX };
+#define KE_MSG_ALLOC(id,dest,src,type) ((struct type*)ke_msg_alloc(id,dest,src,sizeof(struct type)))
+#define KE_MSG_ALLOC_DYN(id,dest,src,type,len) ((struct type*)ke_msg_alloc(id,dest,src,sizeof(struct type)+(len)))
+ke_task_id_t prf_get_task_from_id(uint16_t id);
+struct custs1_env_tag { int x; };
+struct custs1_create_db_req { uint8_t cfg_flag; uint16_t max_nb_att; };
+#define CUSTS1_CFG_FLAG_MANDATORY_MASK 0xFF
+enum { CUSTS1_CREATE_DB_REQ = 10, CUSTS1_VAL_NTF_REQ, CUSTS1_VAL_IND_REQ };
+struct custs1_val_write_ind { uint8_t conidx; uint16_t handle; uint16_t length; uint8_t value[]; };
+struct custs1_val_ntf_cfm { uint16_t handle; uint8_t status; };
+struct custs1_val_ntf_ind_req { uint8_t conidx; bool notification; uint16_t handle; uint16_t length; uint8_t value[]; };
+#define PRF_CLI_START_NTF 1
+#define PRF_CLI_STOP_NTFIND 0
+struct gapc_connection_req_ind { uint16_t conhdl; uint16_t con_interval; };
+struct gapc_disconnect_ind { uint16_t conhdl; uint8_t reason; };
+uint8_t gapc_get_conidx(uint16_t conhdl);
+#define GAP_INVALID_CONIDX 0xFF
+#define GAP_ERR_NO_ERROR 0
+
+// Attribute database
+struct attm_desc_128 { const uint8_t *uuid; uint8_t uuid_size; uint32_t perm; uint16_t max_length; };
+extern const uint8_t att_decl_svc_128[16], att_decl_char_128[16], att_desc_client_char_cfg_128[16];
+#define PERM(a,b) 0
+#define PERM_VAL(x) (x)
+
+// GPIO
+typedef enum { GPIO_PORT_0 } GPIO_PORT;
+typedef enum { GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9, GPIO_PIN_10, GPIO_PIN_11 } GPIO_PIN;
+typedef enum { INPUT, INPUT_PULLUP, INPUT_PULLDOWN, OUTPUT } GPIO_PUPD;
+typedef enum { PID_GPIO, PID_I2C_SCL, PID_I2C_SDA, PID_UART2_TX, PID_UART2_RX, PID_ADC, PID_SPI_CLK, PID_SPI_DI, PID_SPI_DO, PID_SPI_EN } GPIO_FUNCTION;
+void GPIO_ConfigurePin(GPIO_PORT, GPIO_PIN, GPIO_PUPD, GPIO_FUNCTION, bool);
+void GPIO_SetActive(GPIO_PORT, GPIO_PIN);
+void GPIO_SetInactive(GPIO_PORT, GPIO_PIN);
+#define RESERVE_GPIO(a,b,c,d)
+
+// I2C
+typedef struct { struct { int ss_hcnt, ss_lcnt, fs_hcnt, fs_lcnt; } clock_cfg; } i2c_env_t;
+#define I2C_SS_SCL_HCNT_REG_RESET 0
+#define I2C_SS_SCL_LCNT_REG_RESET 0
+#define I2C_FS_SCL_HCNT_REG_RESET 0
+#define I2C_FS_SCL_LCNT_REG_RESET 0
+void i2c_init(i2c_env_t*);
+
+// ADC
+typedef enum { ADC_INPUT_MODE_SINGLE_ENDED } adc_input_mode_t;
+typedef enum { ADC_CHANNEL_P0_5, ADC_CHANNEL_VBAT3V } adc_input_se_t;
+typedef enum { ADC_INPUT_ATTN_NO } adc_input_attn_t;
+typedef struct { adc_input_mode_t input_mode; adc_input_se_t input; bool continuous; uint8_t interval_mult; adc_input_attn_t input_attenuator; bool chopping; uint8_t oversampling; } adc_config_t;
+void adc_init(const adc_config_t*); void adc_enable_channel(uint16_t); void adc_start(void); bool adc_get_sample_status(void); uint16_t adc_get_sample(void); void adc_disable(void);
+
+// Timer0 and CPU
+enum { TIM0_CLK_32K }; enum { PWM_MODE_ONE }; enum { TIM0_CLK_DIV_1, TIM0_CLK_DIV_32 };
+void timer0_init(int,int,int); void timer0_set_pwm_on_counter(uint16_t); void timer0_register_callback(void(*)(void)); void timer0_start(void);
+#define TIMER0_ON_REG 0x50003402
+uint16_t GetWord16(uint32_t addr);
+void system_init_func(void*);
+void __WFE(void);
+void __WFI(void);
+void __disable_irq(void); void __enable_irq(void);
+void __NOP(void);
+
+// UART
+enum { UART_BAUDRATE_115200, UART_DATABITS_8, UART_PARITY_NONE, UART_STOPBITS_1, UART_AFCE_DIS, UART_FIFO_EN };
+void uart2_init(int,int,int,int,int,int);
+
+// GAP and app helpers
+void app_easy_gap_update_adv_data(const uint8_t*, uint8_t, const uint8_t*, uint8_t);
+void app_easy_gap_advertise_stop(void);
+struct gapm_start_advertise_cmd { struct { uint16_t adv_intv_min, adv_intv_max; } intv; };
+struct gapm_start_advertise_cmd *app_easy_gap_undirected_advertise_get_active(void);
+void app_easy_gap_undirected_advertise_start(void);
+void app_easy_gap_set_data_packet_length(uint8_t conidx, uint16_t tx_octets, uint16_t tx_time);
+
+// SysTick
+typedef struct { volatile uint32_t CTRL, LOAD, VAL, CALIB; } SysTick_Type;
+extern SysTick_Type *SysTick;
+#define SysTick_CTRL_ENABLE_Msk 1u
+#define SysTick_CTRL_CLKSOURCE_Msk 4u
+
+// SPI flash and GATT
+int8_t spi_flash_read_data(uint8_t *buf, uint32_t addr, uint32_t len, uint32_t *actual);
+int8_t spi_flash_write_data(uint8_t *buf, uint32_t addr, uint32_t len, uint32_t *actual);
+int8_t spi_flash_block_erase(uint32_t addr, int type);
+enum { SPI_FLASH_OP_SE };
+#define SPI_FLASH_ERR_OK 0
+
+uint16_t gattc_get_mtu(uint8_t conidx);
+
+void spi_flash_release_from_power_down(void);
+void spi_flash_power_down(void);
+struct gattc_exc_mtu_cmd { uint8_t operation; uint16_t seq_num; };
+enum { GATTC_EXC_MTU_CMD = 40 };
+enum { GATTC_MTU_EXCH = 1 };
+void platform_reset(uint32_t error);
+#define RESET_AFTER_SUOTA_UPDATE 0x55
+struct ke_msg { void *hdr; uint16_t id, dest_id, src_id, param_len; uint32_t param[1]; };
+#define KE_PROFILING 1
+uint32_t __get_MSP(void);
+
+// SPI and registers
+typedef struct { int port; int pin; } pad_t;
+typedef enum { SPI_MS_MODE_MASTER } SPI_MS_MODE;
+typedef enum { SPI_CP_MODE_0 } SPI_CP_MODE;
+typedef enum { SPI_SPEED_MODE_4MHz } SPI_SPEED_MODE;
+typedef enum { SPI_MODE_8BIT } SPI_WSZ;
+typedef enum { SPI_CS_0 } SPI_CS;
+typedef enum { SPI_MASTER_EDGE_CAPTURE } SPI_EDGE;
+typedef struct { SPI_MS_MODE spi_ms; SPI_CP_MODE spi_cp; SPI_SPEED_MODE spi_speed; SPI_WSZ spi_wsz; SPI_CS spi_cs; pad_t cs_pad; SPI_EDGE spi_capture; } spi_cfg_t;
+typedef struct { uint32_t chip_size; } spi_flash_cfg_t;
+void spi_flash_configure_env(const spi_flash_cfg_t *cfg);
+void spi_initialize(const spi_cfg_t *cfg);
+void GPIO_Disable_HW_Reset(void);
+#define GetBits16(a,f) ((uint16_t)0)
+#define GetBits32(a,f) ((uint32_t)0)
+#define CLK_RADIO_REG 0
+#define BLE_ENABLE 0
+#define BLE_DEEPSLCNTL_REG 0
+#define DEEP_SLEEP_STAT 0
+
+// Host test hooks (sdk_stub.c)
+#define STUB_FLASH_SIZE                 0x20000
+#define STUB_FLASH_SECTOR               0x1000
+#define STUB_FLASH_ERR                  (-1)
+
+typedef enum { STUB_FLASH_WRITE, STUB_FLASH_ERASE } stub_flash_op_t;
+
+extern uint8_t stub_flash[STUB_FLASH_SIZE];             // Erased to 0xFF at start
+extern uint32_t stub_flash_writes;
+extern uint32_t stub_flash_erases;
+extern bool (*stub_flash_hook)(stub_flash_op_t op, uint32_t addr, uint32_t len); // false fails the operation
+extern uint16_t stub_timer0_remaining;                  // TIMER0_ON_REG
+extern uint16_t (*stub_adc_read)(uint16_t channel);     // Next conversion of the enabled channel
+extern uint32_t stub_adc_conversions;
+extern void (*stub_msg_sent)(ke_msg_id_t id, ke_task_id_t dest, const void *param, uint16_t len);
+extern uint16_t stub_mtu;
+extern uint32_t stub_resets;
+extern uint8_t stub_adv_data[31];
+extern uint8_t stub_adv_len;
+extern bool stub_advertising;
+
+void stub_flash_erase_all(void);
+
+#endif // SDK_STUB_H_
@@ -0,0 +1,55 @@
+/**
+ * @file test.c
+ * @brief Checks for the host tests
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Results and failures go to stderr; test_quiet() drops the firmware's
+ * console output on stdout.
+ */
+
+#include <stdio.h>
+#include "test.h"
+
+// Global Variables
+static unsigned checks = 0;
+static unsigned failures = 0;
+
+/**
+ * @brief Discard the firmware console (printf)
+ */
+void test_quiet(void) {
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "test: cannot silence stdout\n");
+    }
+}
+
+/**
+ * @brief Count a check, print it when it failed
+ */
+void test_check(bool ok, const char *file, int line, const char *expr) {
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+/**
+ * @brief Check for an exact value, print both when they differ
+ */
+void test_check_eq(long long actual, long long expected, const char *file, int line, const char *expr) {
+    checks++;
+    if (actual != expected) {
+        failures++;
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", file, line, expr, actual, expected);
+    }
+}
+
+/**
+ * @brief Print the totals
+ * @return Process exit status
+ */
+int test_report(const char *name) {
+    fprintf(stderr, "%s: %u checks, %u failed\n", name, checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file test.h
+ * @brief Checks and a settable clock for the host tests
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Record a failed check and carry on, so one run shows every failure
+#define CHECK(cond) \
+    test_check((cond), __FILE__, __LINE__, #cond)
+
+#define CHECK_EQ(actual, expected) \
+    test_check_eq((long long)(actual), (long long)(expected), __FILE__, __LINE__, #actual)
+
+// Clock read by the firmware (user_get_time_us64), test_clock.c
+extern uint64_t test_now_us;
+
+// Function Prototypes
+void test_quiet(void);
+void test_check(bool ok, const char *file, int line, const char *expr);
+void test_check_eq(long long actual, long long expected, const char *file, int line, const char *expr);
+int test_report(const char *name);
+
+#endif // TEST_H_
@@ -0,0 +1,257 @@
+/**
+ * @file test_broadcast.c
+ * @brief Broadcast advertising data: encoder against a scanner-side decoder
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The decoder below is what a coach tablet does with a scan result: walk
+ * the AD structures, pick the manufacturer data with our company ID and
+ * read the metrics back in the units of the README table. Also checks the
+ * adaptive interval steps and prints the airtime of one advertising event.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "central.h"
+#include "user_broadcast.h"
+#include "user_custs1_impl.h"
+#include "user_config.h"
+
+#define ADV_DATA_MAX                    31      // Legacy advertising PDU payload
+#define ADV_PDU_OVERHEAD                16      // Preamble, access address, header, AdvA, CRC
+#define ADV_CHANNELS                    3
+#define RANDOM_CASES                    1000
+
+// One decoded scan result
+typedef struct {
+    bool found;
+    uint8_t version;
+    uint8_t counter;
+    uint16_t total_jumps;
+    uint16_t last_height_mm;
+    uint16_t max_height_mm;
+    uint16_t battery_mv;
+    char name[ADV_DATA_MAX];
+} scan_t;
+
+// Local Functions
+static bool scan_decode(const uint8_t *data, uint8_t len, scan_t *out);
+static void check_round_trip(const broadcast_metrics_t *m);
+static void test_encode(void);
+static void test_update(void);
+static uint16_t tick(uint32_t now_ms);
+static void test_interval(void);
+static void test_airtime(void);
+
+int main(void) {
+    test_quiet();
+    central_init();
+    user_broadcast_init();
+
+    test_encode();
+    test_update();
+    test_interval();
+    test_airtime();
+
+    return test_report("test_broadcast");
+}
+
+/**
+ * @brief Scanner side: find our manufacturer data and the local name
+ * @return false when an AD structure runs past the data
+ */
+static bool scan_decode(const uint8_t *data, uint8_t len, scan_t *out) {
+    uint8_t i = 0;
+
+    memset(out, 0, sizeof(*out));
+    while (i < len) {
+        uint8_t ad_len = data[i];
+        if (ad_len == 0) {
+            break;
+        }
+        if (i + 1 + ad_len > len) {
+            return false;
+        }
+
+        const uint8_t *ad = &data[i + 1];
+        if (ad[0] == BROADCAST_AD_TYPE_MANUF && ad_len == BROADCAST_AD_LEN - 1 &&
+            (ad[1] | (ad[2] << 8)) == USER_BROADCAST_COMPANY_ID) {
+            out->found = true;
+            out->version = ad[3];
+            out->counter = ad[4];
+            out->total_jumps = (uint16_t)(ad[5] | (ad[6] << 8));
+            out->last_height_mm = (uint16_t)(ad[7] | (ad[8] << 8));
+            out->max_height_mm = (uint16_t)(ad[9] | (ad[10] << 8));
+            out->battery_mv = (uint16_t)(ad[11] * BROADCAST_BATTERY_STEP_MV);
+        } else if (ad[0] == 0x09) {
+            memcpy(out->name, &ad[1], ad_len - 1);
+        }
+        i += 1 + ad_len;
+    }
+    return true;
+}
+
+/**
+ * @brief Encode one set of metrics and decode it back
+ */
+static void check_round_trip(const broadcast_metrics_t *m) {
+    uint8_t buf[BROADCAST_AD_LEN];
+    scan_t scan;
+    uint16_t battery = m->battery_mv / BROADCAST_BATTERY_STEP_MV;
+
+    CHECK_EQ(user_broadcast_encode(m, 0x5A, buf), BROADCAST_AD_LEN);
+    CHECK(scan_decode(buf, sizeof(buf), &scan));
+    CHECK(scan.found);
+    CHECK_EQ(scan.version, BROADCAST_PAYLOAD_VERSION);
+    CHECK_EQ(scan.counter, 0x5A);
+    CHECK_EQ(scan.total_jumps, m->total_jumps);
+    CHECK_EQ(scan.last_height_mm, m->last_height_mm);
+    CHECK_EQ(scan.max_height_mm, m->max_height_mm);
+    CHECK_EQ(scan.battery_mv, ((battery > 0xFF) ? 0xFF : battery) * BROADCAST_BATTERY_STEP_MV);
+}
+
+/**
+ * @brief Round trip at the field limits and over random values
+ */
+static void test_encode(void) {
+    static const broadcast_metrics_t edges[] = {
+        { 0, 0, 0, 0 },
+        { 1, 1, 1, BROADCAST_BATTERY_STEP_MV - 1 },
+        { 0xFFFF, 0xFFFF, 0xFFFF, 0xFF * BROADCAST_BATTERY_STEP_MV },
+        { 0x1234, 0x00FF, 0xFF00, 0xFFFF },            // Battery clamps to 5100mV
+        { 250, 1200, 3000, 3000 }
+    };
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        check_round_trip(&edges[i]);
+    }
+
+    srand(26);
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        broadcast_metrics_t m = {
+            .total_jumps = (uint16_t)rand(),
+            .last_height_mm = (uint16_t)rand(),
+            .max_height_mm = (uint16_t)rand(),
+            .battery_mv = (uint16_t)(1800 + rand() % 1700)
+        };
+        check_round_trip(&m);
+    }
+}
+
+/**
+ * @brief Updates reach the advertising data with a fresh counter, only when changed
+ */
+static void test_update(void) {
+    broadcast_metrics_t m = { .total_jumps = 7, .last_height_mm = 412, .max_height_mm = 530, .battery_mv = 2960 };
+    scan_t first;
+    scan_t scan;
+
+    stub_adv_len = 0;
+    user_broadcast_update(&m, true);
+    CHECK(stub_adv_len > 0 && stub_adv_len <= ADV_DATA_MAX);
+    CHECK(scan_decode(stub_adv_data, stub_adv_len, &first));
+    CHECK(first.found);
+    CHECK_EQ(first.total_jumps, 7);
+    CHECK_EQ(first.last_height_mm, 412);
+    CHECK_EQ(first.max_height_mm, 530);
+    CHECK_EQ(first.battery_mv, 2960);
+    CHECK(strcmp(first.name, USER_DEVICE_NAME) == 0);
+
+    // Same metrics: nothing to send, counter unchanged
+    stub_adv_len = 0;
+    user_broadcast_update(&m, false);
+    CHECK_EQ(stub_adv_len, 0);
+
+    m.total_jumps++;
+    user_broadcast_update(&m, true);
+    CHECK(scan_decode(stub_adv_data, stub_adv_len, &scan));
+    CHECK_EQ(scan.total_jumps, 8);
+    CHECK_EQ(scan.counter, (uint8_t)(first.counter + 1));
+
+    // Connected with every slot taken: metrics are kept, advertising data is not touched
+    for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        central_connect(conidx);
+    }
+    CHECK(!user_ble_can_advertise());
+    stub_adv_len = 0;
+    m.total_jumps++;
+    user_broadcast_update(&m, false);
+    CHECK_EQ(stub_adv_len, 0);
+    central_disconnect(0);
+
+    // A slot is free again: the next change goes out with everything since
+    m.battery_mv = 2900;
+    user_broadcast_update(&m, false);
+    CHECK(scan_decode(stub_adv_data, stub_adv_len, &scan));
+    CHECK_EQ(scan.total_jumps, 9);
+    CHECK_EQ(scan.counter, (uint8_t)(first.counter + 3));
+}
+
+/**
+ * @brief Run one tick and finish any advertising restart it asked for
+ */
+static uint16_t tick(uint32_t now_ms) {
+    user_broadcast_tick(now_ms);
+    user_broadcast_on_adv_complete();
+    return user_broadcast_get_interval();
+}
+
+/**
+ * @brief Fast after a jump, doubling every hold time down to idle, stretched by the governor
+ */
+static void test_interval(void) {
+    broadcast_metrics_t m = { .total_jumps = 100 };
+    uint32_t now = 100000;
+
+    user_broadcast_update(&m, true);
+    CHECK_EQ(tick(now), USER_BROADCAST_INTERVAL_FAST);
+
+    uint16_t expected = USER_BROADCAST_INTERVAL_FAST;
+    while (expected < USER_BROADCAST_INTERVAL_IDLE) {
+        now += USER_BROADCAST_HOLD_MS / 2;
+        CHECK_EQ(tick(now), expected);              // Not before the hold time
+
+        now += USER_BROADCAST_HOLD_MS / 2 + 1;
+        expected = (expected * 2 > USER_BROADCAST_INTERVAL_IDLE) ? USER_BROADCAST_INTERVAL_IDLE : expected * 2;
+        CHECK_EQ(tick(now), expected);
+        CHECK(stub_advertising);
+    }
+
+    now += 10 * USER_BROADCAST_HOLD_MS;
+    CHECK_EQ(tick(now), USER_BROADCAST_INTERVAL_IDLE);
+
+    // Next jump goes straight back to fast
+    m.total_jumps++;
+    user_broadcast_update(&m, true);
+    CHECK_EQ(tick(now + 10), USER_BROADCAST_INTERVAL_FAST);
+
+    // Low battery doubles the idle interval, recovery brings it back at once
+    user_broadcast_set_power_shift(1);
+    for (int i = 0; i < 8; i++) {
+        now += USER_BROADCAST_HOLD_MS + 1;
+        tick(now);
+    }
+    CHECK_EQ(user_broadcast_get_interval(), USER_BROADCAST_INTERVAL_IDLE * 2);
+
+    user_broadcast_set_power_shift(0);
+    CHECK_EQ(tick(now + 10), USER_BROADCAST_INTERVAL_IDLE);
+}
+
+/**
+ * @brief Radio time of one advertising event at the fast and idle intervals (1M PHY)
+ */
+static void test_airtime(void) {
+    uint32_t event_us = ADV_CHANNELS * (ADV_PDU_OVERHEAD + stub_adv_len) * 8;
+    double fast_pct = 100.0 * event_us / (USER_BROADCAST_INTERVAL_FAST * 625.0);
+    double idle_pct = 100.0 * event_us / (USER_BROADCAST_INTERVAL_IDLE * 625.0);
+
+    fprintf(stderr, "advertising: %u byte data, %u us per event, %.2f%% radio at %u ms, %.3f%% at %u ms\n",
+           stub_adv_len, event_us, fast_pct, USER_BROADCAST_INTERVAL_FAST * 5 / 8,
+           idle_pct, USER_BROADCAST_INTERVAL_IDLE * 5 / 8);
+
+    // README figures: ~1ms per event, ~1% at the fast and ~0.1% at the idle interval
+    CHECK(event_us <= 1000);
+    CHECK(fast_pct <= 1.0);
+    CHECK(idle_pct <= 0.1);
+}
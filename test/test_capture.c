@@ -0,0 +1,371 @@
+/**
+ * @file test_capture.c
+ * @brief Jump capture: pre/post windows, back-to-back jumps, chunked upload
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Samples are pushed and takeoffs/landings reported in the order of the
+ * sampling loop in main.c (capture_sample() before detect_jump()). Each
+ * sample carries its index in the pressure field, so the snapshots read
+ * back through the fake central show exactly which samples were kept.
+ * Window lengths and the rate in the header are checked at the loop rates
+ * the band runs at (register 0x12, battery tiers, off body).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "central.h"
+#include "user_capture.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_packets.h"
+#include "sdk_stub.h"
+
+#define SNAPSHOTS_MAX                   4
+
+// One snapshot as the app rebuilds it
+typedef struct {
+    uint16_t jump_id;
+    uint16_t flight_ms;
+    uint8_t rate_hz;
+    uint8_t pre;
+    uint8_t post;
+    uint8_t chunks;
+    uint8_t received;
+    uint16_t chunk_len;
+    uint16_t last_len;
+    uint16_t bytes;
+    capture_sample_t samples[CAPTURE_SNAPSHOT_SAMPLES];
+} snapshot_t;
+
+// Global Variables
+static uint16_t sample_index = 0;
+static uint8_t rate_hz = SENSOR_SAMPLE_RATE_HZ;
+static snapshot_t got[SNAPSHOTS_MAX];
+static uint8_t got_count = 0;
+
+// Local Functions
+static void push(uint16_t n);
+static void jump(uint16_t jump_id, uint16_t flight_samples);
+static void upload(void);
+static void check_window(const snapshot_t *snap, uint16_t takeoff, uint16_t landing);
+static void test_single(void);
+static void test_back_to_back(void);
+static void test_rejected(void);
+static void test_rates(void);
+static void test_mtu(void);
+
+int main(void) {
+    test_quiet();
+    central_init();
+    central_connect(0);
+    central_subscribe(0, CUSTS1_IDX_SENSOR_DATA_NTF_CFG, true);
+    central_confirm(0, CENTRAL_CFM_ALL);
+
+    test_single();
+    test_back_to_back();
+    test_rejected();
+    test_rates();
+    test_mtu();
+
+    return test_report("test_capture");
+}
+
+/**
+ * @brief n loop passes with no jump event
+ */
+static void push(uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) {
+        capture_sample_t s = { .accel = { 0, 0, 1000 }, .pressure = sample_index++ };
+        user_capture_push(&s, rate_hz);
+    }
+}
+
+/**
+ * @brief Takeoff on the next sample, landing flight_samples later
+ */
+static void jump(uint16_t jump_id, uint16_t flight_samples) {
+    push(1);
+    user_capture_on_takeoff(sample_index * 10000u);
+    push(flight_samples);
+    user_capture_on_landing(jump_id, flight_samples * 1000 / rate_hz);
+}
+
+/**
+ * @brief Send every pending snapshot and rebuild them from the notifications
+ */
+static void upload(void) {
+    central_ntf_t ntf;
+
+    got_count = 0;
+    memset(got, 0, sizeof(got));
+
+    for (uint16_t pass = 0; pass < 1000 && user_capture_pending() > 0; pass++) {
+        user_capture_poll_tx();
+        central_confirm(0, CENTRAL_CFM_ALL);
+
+        while (central_receive(&ntf)) {
+            if (ntf.handle != CUSTS1_IDX_SENSOR_DATA_VAL || ntf.value[0] != DATA_HEADER_CAPTURE) {
+                continue;
+            }
+
+            uint16_t jump_id = ntf.value[1] | (ntf.value[2] << 8);
+            uint8_t chunk = ntf.value[3];
+            if (chunk == 0) {
+                CHECK(got_count < SNAPSHOTS_MAX);
+                if (got_count >= SNAPSHOTS_MAX) {
+                    return;
+                }
+                snapshot_t *snap = &got[got_count++];
+                CHECK_EQ(ntf.length, PKT_CAPTURE_HEAD_LEN);
+                snap->jump_id = jump_id;
+                snap->flight_ms = ntf.value[8] | (ntf.value[9] << 8);
+                snap->pre = ntf.value[10];
+                snap->post = ntf.value[11];
+                snap->chunks = ntf.value[12];
+                snap->rate_hz = ntf.value[13];
+                snap->received = 1;
+                continue;
+            }
+
+            // Data chunks follow their header in order
+            CHECK(got_count > 0);
+            if (got_count == 0) {
+                continue;
+            }
+            snapshot_t *snap = &got[got_count - 1];
+            CHECK_EQ(jump_id, snap->jump_id);
+            CHECK_EQ(chunk, snap->received);
+            uint16_t len = ntf.length - CAPTURE_CHUNK_OVERHEAD;
+            CHECK(ntf.length <= stub_mtu - 3);
+            if (snap->received == 1) {
+                snap->chunk_len = len;
+            } else {
+                CHECK_EQ(snap->last_len, snap->chunk_len);  // Only the last chunk is shorter
+            }
+            snap->last_len = len;
+            CHECK(snap->bytes + len <= sizeof(snap->samples));
+            if (snap->bytes + len <= sizeof(snap->samples)) {
+                memcpy((uint8_t *)snap->samples + snap->bytes, &ntf.value[4], len);
+                snap->bytes += len;
+            }
+            snap->received++;
+        }
+    }
+    CHECK_EQ(user_capture_pending(), 0);
+}
+
+/**
+ * @brief Whole snapshot received, pre window ends at takeoff, post starts at landing
+ */
+static void check_window(const snapshot_t *snap, uint16_t takeoff, uint16_t landing) {
+    CHECK_EQ(snap->received, snap->chunks);
+    CHECK_EQ(snap->bytes, (snap->pre + snap->post) * sizeof(capture_sample_t));
+    CHECK_EQ(snap->rate_hz, rate_hz);
+    CHECK_EQ(snap->pre, CAPTURE_PRE_MS * rate_hz / 1000);
+    CHECK_EQ(snap->post, CAPTURE_POST_MS * rate_hz / 1000);
+
+    for (uint8_t i = 0; i < snap->pre; i++) {
+        CHECK_EQ(snap->samples[i].pressure, takeoff - snap->pre + 1 + i);
+    }
+    for (uint8_t i = 0; i < snap->post; i++) {
+        CHECK_EQ(snap->samples[snap->pre + i].pressure, landing + i);
+    }
+}
+
+static void test_single(void) {
+    user_capture_init();
+    push(100);
+    uint16_t takeoff = sample_index;
+    jump(1, 40);
+    uint16_t landing = sample_index - 1;
+    push(CAPTURE_POST_SAMPLES);
+
+    CHECK_EQ(user_capture_pending(), 1);
+    upload();
+    CHECK_EQ(got_count, 1);
+    CHECK_EQ(got[0].jump_id, 1);
+    CHECK_EQ(got[0].flight_ms, 400);
+    check_window(&got[0], takeoff, landing);
+}
+
+/**
+ * @brief Takeoff 100 ms after a landing (repeated hops): both captures kept
+ */
+static void test_back_to_back(void) {
+    uint16_t takeoff[2];
+    uint16_t landing[2];
+
+    user_capture_init();
+    push(100);
+    for (uint8_t j = 0; j < 2; j++) {
+        takeoff[j] = sample_index;
+        jump(10 + j, 30);
+        landing[j] = sample_index - 1;
+        push(j == 0 ? 9 : CAPTURE_POST_SAMPLES);
+    }
+
+    CHECK_EQ(user_capture_pending(), 2);
+    upload();
+    CHECK_EQ(got_count, 2);
+    for (uint8_t j = 0; j < got_count; j++) {
+        CHECK_EQ(got[j].jump_id, 10 + j);
+        check_window(&got[j], takeoff[j], landing[j]);
+    }
+
+    // Second landing inside the first window (unrealistically short hop): the
+    // first capture ends early with what it has, neither is dropped
+    user_capture_init();
+    push(100);
+    jump(20, 5);
+    push(2);
+    jump(21, 10);
+    push(CAPTURE_POST_SAMPLES);
+
+    CHECK_EQ(user_capture_pending(), 2);
+    upload();
+    CHECK_EQ(got_count, 2);
+    CHECK_EQ(got[0].jump_id, 20);
+    CHECK_EQ(got[0].post, 1 + 2 + 1 + 10);
+    CHECK_EQ(got[1].jump_id, 21);
+    CHECK_EQ(got[1].post, CAPTURE_POST_SAMPLES);
+}
+
+/**
+ * @brief Rejected and unlanded jumps free their slot; a full set of slots drops new takeoffs
+ */
+static void test_rejected(void) {
+    user_capture_init();
+    push(100);
+    push(1);
+    user_capture_on_takeoff(0);
+    push(20);
+    user_capture_abort();
+    push(1);
+    user_capture_on_takeoff(0);
+    push(20);
+    CHECK_EQ(user_capture_pending(), 0);
+
+    // Unlanded takeoff is replaced by the next one
+    uint16_t takeoff = sample_index;
+    jump(30, 40);
+    uint16_t landing = sample_index - 1;
+    push(CAPTURE_POST_SAMPLES);
+    CHECK_EQ(user_capture_pending(), 1);
+
+    for (uint8_t j = 1; j < CAPTURE_SNAPSHOT_COUNT + 1; j++) {
+        jump(30 + j, 40);
+        push(CAPTURE_POST_SAMPLES);
+    }
+    CHECK_EQ(user_capture_pending(), CAPTURE_SNAPSHOT_COUNT);
+
+    upload();
+    CHECK_EQ(got_count, CAPTURE_SNAPSHOT_COUNT);
+    CHECK_EQ(got[0].jump_id, 30);
+    check_window(&got[0], takeoff, landing);
+}
+
+/**
+ * @brief Windows stay 250 ms at every loop rate; a rate change ends the capture timebase
+ */
+static void test_rates(void) {
+    static const uint8_t rates[] = { 10, 25, 50, 100 };
+
+    for (uint8_t r = 0; r < sizeof(rates); r++) {
+        rate_hz = rates[r];
+        user_capture_init();
+        push(100);
+        uint16_t takeoff = sample_index;
+        jump(40 + r, rate_hz / 2);
+        uint16_t landing = sample_index - 1;
+        push(CAPTURE_POST_MS * rate_hz / 1000);
+
+        CHECK_EQ(user_capture_pending(), 1);
+        upload();
+        CHECK_EQ(got_count, 1);
+        CHECK_EQ(got[0].flight_ms, (rate_hz / 2) * 1000 / rate_hz);
+        check_window(&got[0], takeoff, landing);
+    }
+
+    // Rate drops right after a landing (battery tier): the capture ends at the
+    // old rate, the pre window of the next jump holds only new-rate samples
+    rate_hz = 100;
+    user_capture_init();
+    push(100);
+    jump(50, 50);
+    push(4);
+    rate_hz = 25;
+    push(3);
+    uint16_t takeoff = sample_index;
+    jump(51, 10);
+    push(CAPTURE_POST_MS * rate_hz / 1000);
+    CHECK_EQ(user_capture_pending(), 2);
+
+    upload();
+    CHECK_EQ(got_count, 2);
+    CHECK_EQ(got[0].rate_hz, 100);
+    CHECK_EQ(got[0].post, 1 + 4);
+    CHECK_EQ(got[1].rate_hz, 25);
+    CHECK_EQ(got[1].pre, 4);
+    CHECK_EQ(got[1].samples[0].pressure, takeoff - 3);
+
+    // Rate change in flight: the jump is not captured
+    user_capture_init();
+    push(100);
+    push(1);
+    user_capture_on_takeoff(0);
+    rate_hz = 100;
+    push(30);
+    user_capture_on_landing(52, 300);
+    push(CAPTURE_POST_SAMPLES);
+    CHECK_EQ(user_capture_pending(), 0);
+}
+
+/**
+ * @brief Chunks fill the MTU; a smaller MTU mid-snapshot restarts it from the header
+ */
+static void test_mtu(void) {
+    static const uint16_t mtus[] = { 23, 64, 185, 247 };
+    const uint16_t bytes = CAPTURE_SNAPSHOT_SAMPLES * sizeof(capture_sample_t);
+
+    rate_hz = 100;
+    for (uint8_t m = 0; m < sizeof(mtus) / sizeof(mtus[0]); m++) {
+        stub_mtu = mtus[m];
+        user_capture_init();
+        push(100);
+        jump(60 + m, 40);
+        push(CAPTURE_POST_SAMPLES);
+
+        upload();
+        CHECK_EQ(got_count, 1);
+        uint16_t len = stub_mtu - 3 - CAPTURE_CHUNK_OVERHEAD;
+        len = (len > CAPTURE_CHUNK_MAX) ? CAPTURE_CHUNK_MAX : len;
+        CHECK_EQ(got[0].chunk_len, len);
+        CHECK_EQ(got[0].chunks, 1 + (bytes + len - 1) / len);
+        CHECK_EQ(got[0].bytes, bytes);
+        fprintf(stderr, "capture: MTU %3d, %d notifications per %d B snapshot\n",
+                stub_mtu, got[0].chunks, bytes);
+    }
+
+    // Header and one chunk at MTU 247, then a central on MTU 23 joins
+    stub_mtu = 247;
+    user_capture_init();
+    push(100);
+    uint16_t takeoff = sample_index;
+    jump(70, 40);
+    uint16_t landing = sample_index - 1;
+    push(CAPTURE_POST_SAMPLES);
+    for (uint8_t i = 0; i < 2; i++) {
+        user_capture_poll_tx();
+        central_confirm(0, CENTRAL_CFM_ALL);
+    }
+    central_ntf_t ntf;
+    while (central_receive(&ntf)) {
+    }
+
+    stub_mtu = 23;
+    upload();
+    CHECK_EQ(got_count, 1);
+    CHECK_EQ(got[0].chunks, 1 + (bytes + 15) / 16);
+    check_window(&got[0], takeoff, landing);
+}
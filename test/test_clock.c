@@ -0,0 +1,24 @@
+/**
+ * @file test_clock.c
+ * @brief Settable clock for host tests that do not include main.c
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Weak, so tests that include main.c get its TIMER0 based clock instead.
+ */
+
+#include "test.h"
+#include "user_time_sync.h"
+
+// Global Variables
+uint64_t test_now_us = 0;
+
+/**
+ * @brief Local microseconds since boot, as main.c derives them from TIMER0
+ */
+__attribute__((weak)) uint64_t user_get_time_us64(void) {
+    return test_now_us;
+}
+
+__attribute__((weak)) uint32_t user_get_time_us(void) {
+    return (uint32_t)user_get_time_us64();
+}
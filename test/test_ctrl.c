@@ -0,0 +1,506 @@
+/**
+ * @file test_ctrl.c
+ * @brief TLV control frames: fixed cases and a fuzz run against the README register table
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Frames go through the real write handler of the device control value.
+ * The fake central copies each write into a buffer of exactly its length,
+ * so with the sanitizer build (Makefile) a read past the frame fails the
+ * test. Every answer is walked against the register table of the README:
+ * one result per operation in order, the status the table implies, GET
+ * values of the table's length, and the stop rule for results that do not
+ * fit. Settings, queued actions and the log cursor must change exactly as
+ * the answered SETs say, and never for operations left unanswered.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "central.h"
+#include "user_ctrl.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_packets.h"
+#include "user_pressure.h"
+#include "user_reps.h"
+#include "user_wear.h"
+
+#define FUZZ_FRAMES                     100000
+#define FUZZ_OPS_MAX                    12
+#define RESULT_MALFORMED_REG            0xFF
+
+// One row of the README register table (len 0 = no access, block = validated by its owner)
+typedef struct {
+    uint8_t reg;
+    uint8_t rd_len;
+    uint8_t wr_len;
+    uint32_t min;
+    uint32_t max;
+    bool block;
+} reg_spec_t;
+
+static const reg_spec_t spec[] = {
+    { CTRL_REG_STATUS,            PKT_STATUS_BODY_LEN, 0, 0, 0, false },
+    { CTRL_REG_ACTION,            0, 1, 0, CTRL_ACTION_CALIBRATE | CTRL_ACTION_RESET_COUNTERS, false },
+    { CTRL_REG_SCHEMA_VERSION,    1, 0, 0, 0, false },
+    { CTRL_REG_JUMP_THRESHOLD,    2, 2, 1100, 4000, false },
+    { CTRL_REG_LANDING_THRESHOLD, 2, 2, 1500, 8000, false },
+    { CTRL_REG_SAMPLE_RATE,       1, 1, 10, 100, false },
+    { CTRL_REG_TX_RATE,           1, 1, 1, 20, false },
+    { CTRL_REG_MODE,              1, 1, DEVICE_MODE_GYMNASTICS, DEVICE_MODE_MEDICAL, false },
+    { CTRL_REG_LOG_CURSOR,        4, 4, 0, 0xFFFFFFFF, false },
+    { CTRL_REG_FALL_ALERT,        6, 1, 1, 1, false },
+    { CTRL_REG_PRESSURE_CAL,      PRESSURE_CAL_LEN, PRESSURE_CAL_LEN, 0, 0, true },
+    { CTRL_REG_REP_TEMPLATE,      0, REPS_TEMPLATE_BLOB_LEN, 0, 0, true },
+    { CTRL_REG_REP_STATUS,        REPS_STATUS_LEN, 0, 0, 0, false },
+    { CTRL_REG_DIAG_SYSTEM,       9, 0, 0, 0, false },
+    { CTRL_REG_DIAG_MEMORY,       12, 0, 0, 0, false },
+    { CTRL_REG_DIAG_WEAR,         WEAR_DIAG_LEN, 0, 0, 0, false }
+};
+
+#define SPEC_NB                         (sizeof(spec) / sizeof(spec[0]))
+
+// What the band should hold after the answered SETs
+typedef struct {
+    app_settings_t settings;
+    uint8_t actions;
+    bool cursor_written;
+    uint32_t cursor;
+} model_t;
+
+// Global Variables
+static const uint16_t mtus[] = { 23, 27, 64, 100, 247 };
+static model_t model;
+static uint32_t rng = 31;
+static uint32_t fuzz_ops = 0;
+static uint32_t fuzz_malformed = 0;
+
+// Local Functions
+static uint32_t rnd(void);
+static const reg_spec_t *spec_find(uint8_t reg);
+static uint32_t le(const uint8_t *p, uint8_t len);
+static void model_reset(void);
+static bool send(const uint8_t *frame, uint16_t length, central_ntf_t *answer);
+static uint8_t expected_status(uint8_t op, const reg_spec_t *s, const uint8_t *value, uint8_t len);
+static uint32_t check_answer(const uint8_t *frame, uint16_t length, const central_ntf_t *answer);
+static void check_state(void);
+static uint16_t make_frame(uint8_t *frame, uint16_t max);
+static void test_setup(void);
+static void test_fall_ack(void);
+static void test_short(void);
+static void test_fuzz(void);
+
+int main(void) {
+    test_quiet();
+    user_ctrl_init();
+    central_init();
+    central_connect(0);
+    central_subscribe(0, CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG, true);
+    central_confirm(0, CENTRAL_CFM_ALL);
+    model_reset();
+
+    test_setup();
+    test_fall_ack();
+    test_short();
+    test_fuzz();
+
+    return test_report("test_ctrl");
+}
+
+static uint32_t rnd(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+static const reg_spec_t *spec_find(uint8_t reg) {
+    for (uint8_t i = 0; i < SPEC_NB; i++) {
+        if (spec[i].reg == reg) {
+            return &spec[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t le(const uint8_t *p, uint8_t len) {
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        value |= (uint32_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Start the model from what the band holds now
+ */
+static void model_reset(void) {
+    uint32_t cursor;
+
+    model.settings = *user_ctrl_settings();
+    model.actions = 0;
+    model.cursor_written = false;
+    user_ctrl_take_actions();
+    user_ctrl_take_jump_count(&cursor);
+}
+
+/**
+ * @brief Write a frame and take its answer off the link
+ * @return true when exactly one device control notification came back
+ */
+static bool send(const uint8_t *frame, uint16_t length, central_ntf_t *answer) {
+    central_ntf_t ntf;
+    uint32_t answers = 0;
+
+    central_write(0, CUSTS1_IDX_DEVICE_CONTROL_VAL, frame, length);
+    central_confirm(0, CENTRAL_CFM_ALL);
+    while (central_receive(&ntf)) {
+        if (ntf.handle == CUSTS1_IDX_DEVICE_CONTROL_VAL) {
+            *answer = ntf;
+            answers++;
+        }
+    }
+    return answers == 1;
+}
+
+/**
+ * @brief Status the register table implies (blocks: OK or out of range)
+ */
+static uint8_t expected_status(uint8_t op, const reg_spec_t *s, const uint8_t *value, uint8_t len) {
+    if (s == NULL) {
+        return CTRL_STATUS_UNKNOWN_REG;
+    }
+    if (op == CTRL_OP_GET) {
+        return (s->rd_len == 0) ? CTRL_STATUS_WRITE_ONLY : CTRL_STATUS_OK;
+    }
+    if (op != CTRL_OP_SET) {
+        return CTRL_STATUS_BAD_OP;
+    }
+    if (s->wr_len == 0) {
+        return CTRL_STATUS_READ_ONLY;
+    }
+    if (len != s->wr_len) {
+        return CTRL_STATUS_BAD_LENGTH;
+    }
+    if (s->block) {
+        return CTRL_STATUS_OK;
+    }
+
+    uint32_t v = le(value, len);
+    return (v < s->min || v > s->max) ? CTRL_STATUS_OUT_OF_RANGE : CTRL_STATUS_OK;
+}
+
+/**
+ * @brief Walk the answer along the frame's operations and apply answered SETs to the model
+ * @return Operations answered
+ */
+static uint32_t check_answer(const uint8_t *frame, uint16_t length, const central_ntf_t *answer) {
+    uint16_t limit = stub_mtu - 3;
+    uint16_t pos = CTRL_FRAME_HEADER_LEN;
+    uint16_t idx = 3;
+    uint32_t answered = 0;
+    const uint8_t *rsp = answer->value;
+
+    if (limit > MAX_STATUS_DATA_LEN) {
+        limit = MAX_STATUS_DATA_LEN;
+    }
+
+    CHECK(answer->length >= 3 && answer->length <= limit);
+    CHECK_EQ(rsp[0], DATA_HEADER_STATUS);
+    CHECK_EQ(rsp[1], DEVICE_CMD_TLV_FRAME);
+    CHECK_EQ(rsp[2], frame[1]);
+
+    while (pos < length) {
+        uint16_t left = length - pos;
+
+        // Cut short: one malformed result if it fits, then nothing more
+        if (left < CTRL_OP_HEADER_LEN || left - CTRL_OP_HEADER_LEN < frame[pos + 2]) {
+            if (idx + CTRL_RESULT_HEADER_LEN <= limit) {
+                CHECK(idx + CTRL_RESULT_HEADER_LEN <= answer->length);
+                CHECK_EQ(rsp[idx], RESULT_MALFORMED_REG);
+                CHECK_EQ(rsp[idx + 1], CTRL_STATUS_MALFORMED);
+                CHECK_EQ(rsp[idx + 2], 0);
+                idx += CTRL_RESULT_HEADER_LEN;
+                fuzz_malformed++;
+            }
+            break;
+        }
+
+        uint8_t op = frame[pos];
+        uint8_t reg = frame[pos + 1];
+        uint8_t len = frame[pos + 2];
+        const uint8_t *value = &frame[pos + CTRL_OP_HEADER_LEN];
+        const reg_spec_t *s = spec_find(reg);
+
+        // Not answered, and not executed, unless its largest result fits
+        uint16_t worst = CTRL_RESULT_HEADER_LEN + ((op == CTRL_OP_GET && s) ? s->rd_len : 0);
+        if (idx + worst > limit) {
+            break;
+        }
+        if (idx + CTRL_RESULT_HEADER_LEN > answer->length) {
+            CHECK(false);
+            break;
+        }
+
+        uint8_t status = expected_status(op, s, value, len);
+        uint8_t got = rsp[idx + 1];
+        uint8_t out_len = rsp[idx + 2];
+
+        CHECK_EQ(rsp[idx], reg);
+        if (s != NULL && s->block && status == CTRL_STATUS_OK) {
+            CHECK(got == CTRL_STATUS_OK || got == CTRL_STATUS_OUT_OF_RANGE);
+        } else {
+            CHECK_EQ(got, status);
+        }
+        CHECK_EQ(out_len, (op == CTRL_OP_GET && got == CTRL_STATUS_OK) ? s->rd_len : 0);
+
+        // Readback of the settings registers
+        const uint8_t *out = &rsp[idx + CTRL_RESULT_HEADER_LEN];
+        if (op == CTRL_OP_GET && got == CTRL_STATUS_OK) {
+            switch (reg) {
+                case CTRL_REG_JUMP_THRESHOLD:
+                    CHECK_EQ(le(out, 2), model.settings.jump_threshold_mg);
+                    break;
+                case CTRL_REG_LANDING_THRESHOLD:
+                    CHECK_EQ(le(out, 2), model.settings.landing_threshold_mg);
+                    break;
+                case CTRL_REG_SAMPLE_RATE:
+                    CHECK_EQ(out[0], model.settings.sample_rate_hz);
+                    break;
+                case CTRL_REG_TX_RATE:
+                    CHECK_EQ(out[0], model.settings.tx_rate_hz);
+                    break;
+                case CTRL_REG_MODE:
+                    CHECK_EQ(out[0], model.settings.mode);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (op == CTRL_OP_SET && got == CTRL_STATUS_OK) {
+            uint32_t v = le(value, (len > 4) ? 4 : len);
+            switch (reg) {
+                case CTRL_REG_ACTION:
+                    model.actions |= (uint8_t)v;
+                    break;
+                case CTRL_REG_JUMP_THRESHOLD:
+                    model.settings.jump_threshold_mg = (uint16_t)v;
+                    break;
+                case CTRL_REG_LANDING_THRESHOLD:
+                    model.settings.landing_threshold_mg = (uint16_t)v;
+                    break;
+                case CTRL_REG_SAMPLE_RATE:
+                    model.settings.sample_rate_hz = (uint8_t)v;
+                    break;
+                case CTRL_REG_TX_RATE:
+                    model.settings.tx_rate_hz = (uint8_t)v;
+                    break;
+                case CTRL_REG_MODE:
+                    model.settings.mode = (uint8_t)v;
+                    break;
+                case CTRL_REG_LOG_CURSOR:
+                    model.cursor_written = true;
+                    model.cursor = v;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        idx += CTRL_RESULT_HEADER_LEN + out_len;
+        pos += CTRL_OP_HEADER_LEN + len;
+        answered++;
+    }
+
+    CHECK_EQ(answer->length, idx);
+    return answered;
+}
+
+/**
+ * @brief Band state against the model
+ */
+static void check_state(void) {
+    const app_settings_t *s = user_ctrl_settings();
+    uint32_t cursor = 0;
+
+    CHECK_EQ(s->jump_threshold_mg, model.settings.jump_threshold_mg);
+    CHECK_EQ(s->landing_threshold_mg, model.settings.landing_threshold_mg);
+    CHECK_EQ(s->sample_rate_hz, model.settings.sample_rate_hz);
+    CHECK_EQ(s->tx_rate_hz, model.settings.tx_rate_hz);
+    CHECK_EQ(s->mode, model.settings.mode);
+    CHECK_EQ(user_ctrl_take_actions(), model.actions);
+    CHECK_EQ(user_ctrl_take_jump_count(&cursor), model.cursor_written);
+    if (model.cursor_written) {
+        CHECK_EQ(cursor, model.cursor);
+    }
+
+    model.actions = 0;
+    model.cursor_written = false;
+}
+
+/**
+ * @brief Random frame of at most max bytes: mostly well-formed operations, some noise
+ */
+static uint16_t make_frame(uint8_t *frame, uint16_t max) {
+    uint16_t pos = CTRL_FRAME_HEADER_LEN;
+
+    frame[0] = DEVICE_CMD_TLV_FRAME;
+    frame[1] = (uint8_t)rnd();
+
+    // Any bytes at all after the command
+    if (rnd() % 4 == 0) {
+        uint16_t length = 1 + rnd() % max;
+        for (uint16_t i = 1; i < length; i++) {
+            frame[i] = (uint8_t)rnd();
+        }
+        return length;
+    }
+
+    uint8_t ops = 1 + rnd() % FUZZ_OPS_MAX;
+    for (uint8_t n = 0; n < ops; n++) {
+        uint32_t pick = rnd() % 20;
+        uint8_t op = (pick < 9) ? CTRL_OP_GET : (pick < 18) ? CTRL_OP_SET : (uint8_t)rnd();
+        uint8_t reg = (rnd() % 8) ? spec[rnd() % SPEC_NB].reg : (uint8_t)rnd();
+        const reg_spec_t *s = spec_find(reg);
+        uint8_t len = (uint8_t)(rnd() % 8);
+
+        if (rnd() % 5) {
+            len = (op == CTRL_OP_SET && s) ? s->wr_len : 0;
+        }
+        if (pos + CTRL_OP_HEADER_LEN + len > max) {
+            break;
+        }
+
+        frame[pos] = op;
+        frame[pos + 1] = reg;
+        frame[pos + 2] = len;
+        for (uint8_t i = 0; i < len; i++) {
+            frame[pos + CTRL_OP_HEADER_LEN + i] = (uint8_t)rnd();
+        }
+
+        // Mostly values the range check lets through
+        if (s != NULL && !s->block && len == s->wr_len && len > 0 && rnd() % 10 < 7) {
+            uint32_t span = s->max - s->min;
+            uint32_t v = s->min + ((span == 0xFFFFFFFF) ? rnd() : rnd() % (span + 1));
+            for (uint8_t i = 0; i < len; i++) {
+                frame[pos + CTRL_OP_HEADER_LEN + i] = (uint8_t)(v >> (8 * i));
+            }
+        }
+        pos += CTRL_OP_HEADER_LEN + len;
+    }
+
+    // Cut somewhere inside the last operations
+    if (rnd() % 10 == 0 && pos > CTRL_FRAME_HEADER_LEN) {
+        pos = CTRL_FRAME_HEADER_LEN + rnd() % (pos - CTRL_FRAME_HEADER_LEN);
+    }
+    return pos;
+}
+
+/**
+ * @brief A typical app setup: one frame at a large MTU, two at the default one
+ */
+static void test_setup(void) {
+    static const uint8_t frame[] = {
+        DEVICE_CMD_TLV_FRAME, 0x42,
+        CTRL_OP_SET, CTRL_REG_JUMP_THRESHOLD, 2, 0x08, 0x07,        // 1800 mg
+        CTRL_OP_SET, CTRL_REG_LANDING_THRESHOLD, 2, 0xB8, 0x0B,     // 3000 mg
+        CTRL_OP_SET, CTRL_REG_SAMPLE_RATE, 1, 50,
+        CTRL_OP_SET, CTRL_REG_TX_RATE, 1, 5,
+        CTRL_OP_SET, CTRL_REG_MODE, 1, DEVICE_MODE_MEDICAL,
+        CTRL_OP_GET, CTRL_REG_STATUS, 0,
+        CTRL_OP_GET, CTRL_REG_SCHEMA_VERSION, 0
+    };
+    central_ntf_t answer;
+
+    stub_mtu = 247;
+    CHECK(send(frame, sizeof(frame), &answer));
+    CHECK_EQ(check_answer(frame, sizeof(frame), &answer), 7);
+    CHECK_EQ(user_ctrl_settings()->jump_threshold_mg, 1800);
+    CHECK_EQ(user_ctrl_settings()->mode, DEVICE_MODE_MEDICAL);
+    check_state();
+
+    // 20 byte notifications: the SETs fit, the status GET does not and is resent
+    stub_mtu = 23;
+    CHECK(send(frame, sizeof(frame), &answer));
+    CHECK_EQ(check_answer(frame, sizeof(frame), &answer), 5);
+    check_state();
+
+    const uint8_t rest[] = { DEVICE_CMD_TLV_FRAME, 0x43, CTRL_OP_GET, CTRL_REG_STATUS, 0,
+                             CTRL_OP_GET, CTRL_REG_SCHEMA_VERSION, 0 };
+    CHECK(send(rest, sizeof(rest), &answer));
+    CHECK_EQ(check_answer(rest, sizeof(rest), &answer), 2);
+    CHECK_EQ(answer.value[answer.length - 1], PACKET_SCHEMA_VERSION);
+    check_state();
+}
+
+/**
+ * @brief Register 0x16 reads 6 bytes and takes a one byte 1 as the acknowledgement
+ */
+static void test_fall_ack(void) {
+    static const uint8_t frame[] = {
+        DEVICE_CMD_TLV_FRAME, 7,
+        CTRL_OP_GET, CTRL_REG_FALL_ALERT, 0,
+        CTRL_OP_SET, CTRL_REG_FALL_ALERT, 1, 1,
+        CTRL_OP_SET, CTRL_REG_FALL_ALERT, 1, 0,
+        CTRL_OP_SET, CTRL_REG_FALL_ALERT, 2, 1, 0
+    };
+    central_ntf_t answer;
+
+    stub_mtu = 247;
+    CHECK(send(frame, sizeof(frame), &answer));
+    CHECK_EQ(check_answer(frame, sizeof(frame), &answer), 4);
+    CHECK_EQ(answer.value[5], 6);
+    CHECK_EQ(answer.value[3 + 3 + 6 + 1], CTRL_STATUS_OK);
+    CHECK_EQ(answer.value[3 + 3 + 6 + 3 + 1], CTRL_STATUS_OUT_OF_RANGE);
+    CHECK_EQ(answer.value[3 + 3 + 6 + 6 + 1], CTRL_STATUS_BAD_LENGTH);
+    check_state();
+}
+
+/**
+ * @brief No sequence number: no answer; header only: empty answer; dangling length: malformed
+ */
+static void test_short(void) {
+    static const uint8_t bare[] = { DEVICE_CMD_TLV_FRAME };
+    static const uint8_t header[] = { DEVICE_CMD_TLV_FRAME, 9 };
+    static const uint8_t dangling[] = { DEVICE_CMD_TLV_FRAME, 10, CTRL_OP_SET, CTRL_REG_MODE, 1 };
+    central_ntf_t answer;
+
+    stub_mtu = 23;
+    CHECK(!send(bare, sizeof(bare), &answer));
+    CHECK(send(header, sizeof(header), &answer));
+    CHECK_EQ(answer.length, 3);
+    CHECK(send(dangling, sizeof(dangling), &answer));
+    CHECK_EQ(check_answer(dangling, sizeof(dangling), &answer), 0);
+    CHECK_EQ(answer.value[3], RESULT_MALFORMED_REG);
+    check_state();
+}
+
+/**
+ * @brief Random frames at random MTUs, every answer and state change checked
+ */
+static void test_fuzz(void) {
+    static uint8_t frame[CENTRAL_VALUE_MAX];
+    central_ntf_t answer;
+
+    for (uint32_t i = 0; i < FUZZ_FRAMES; i++) {
+        stub_mtu = mtus[rnd() % (sizeof(mtus) / sizeof(mtus[0]))];
+
+        // An ATT write carries at most MTU - 3 bytes
+        uint16_t length = make_frame(frame, stub_mtu - 3);
+        bool answered = send(frame, length, &answer);
+
+        if (length < CTRL_FRAME_HEADER_LEN) {
+            CHECK(!answered);
+            continue;
+        }
+        CHECK(answered);
+        if (answered) {
+            fuzz_ops += check_answer(frame, length, &answer);
+        }
+        check_state();
+    }
+
+    fprintf(stderr, "fuzz: %u frames, %u operations answered, %u malformed tails\n",
+            FUZZ_FRAMES, fuzz_ops, fuzz_malformed);
+}
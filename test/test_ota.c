@@ -0,0 +1,612 @@
+/**
+ * @file test_ota.c
+ * @brief Interrupted firmware updates: a phone-side updater against user_ota.c
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The updater follows the README protocol (START, up to two windows of data
+ * in flight, continue from Next on any ack it did not expect, END, REBOOT)
+ * through the fake central, one connection event at a time, with
+ * user_ota_poll() between events as the main loop runs it. Faults: lost
+ * data packets, disconnects, and a power cut at every flash operation of an
+ * update (before it, after it, or halfway through an erase), after which
+ * the band restarts with nothing but its flash. After every interruption
+ * the resume point must not claim a byte that is not in flash, the
+ * bootloader must still pick the running image, and the update must finish
+ * with the exact file in the other bank. A power cut costs at most two
+ * sectors (resume points alternate between two records); one while another
+ * file replaces a half-sent one must not resume the first from the second's
+ * bytes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "central.h"
+#include "user_ota.h"
+#include "user_config.h"
+#include "user_custs1_def.h"
+#include "user_nvm.h"
+
+#define IMAGE_SIZE                      40000   // Not a whole number of sectors
+#define IMAGE_SECTORS                   ((IMAGE_SIZE + NVM_SECTOR_SIZE - 1) / NVM_SECTOR_SIZE)
+#define RUNNING_ID                      5       // Image id of the bank the band runs from
+#define RUNNING_SIZE                    0x2000
+#define PACKETS_PER_EVENT               6       // Writes without response per connection event
+#define EVENT_US                        (USER_CONNECTION_INTERVAL_MIN * 1250)
+#define TIMEOUT_EVENTS                  5       // Updater gives up waiting and resends
+#define MAX_EVENTS                      5000
+#define WINDOWS_IN_FLIGHT               2
+#define LOSS_RUNS                       20
+#define DISCONNECT_RUNS                 20
+
+// Image header fields the test reads like the bootloader does
+#define IMG_SIGNATURE_0                 0x70
+#define IMG_SIGNATURE_1                 0x51
+#define IMG_VALID                       0xAA
+
+// Where a power cut lands relative to the flash operation it hits
+typedef enum {
+    CUT_BEFORE,                 // Operation never starts
+    CUT_AFTER,                  // Operation completes, nothing after it
+    CUT_TORN,                   // Erase stopped halfway (writes: as CUT_BEFORE)
+    CUT_MODES
+} cut_mode_t;
+
+typedef struct {
+    uint32_t loss_percent;      // Data packets lost on the air
+    uint32_t disconnect_percent;    // Chance per event of a dropped link
+    uint32_t cut_op;            // Flash operation (from 1) the power cut hits, 0 for none
+    cut_mode_t cut_mode;
+} faults_t;
+
+typedef enum {
+    UP_START,
+    UP_WAIT_START,
+    UP_SEND,
+    UP_WAIT_END,
+    UP_DONE
+} up_state_t;
+
+// Phone side of one update
+typedef struct {
+    up_state_t state;
+    uint32_t send;              // Next offset to send
+    uint32_t acked;
+    uint32_t marks[WINDOWS_IN_FLIGHT];  // Offsets an OK ack is due at, oldest first
+    uint8_t mark_count;
+    uint8_t since_mark;
+    uint8_t window;
+    uint16_t max_data;
+    uint32_t quiet;             // Events without an answer
+    uint32_t air_bytes;         // Image bytes sent, resends included
+    uint32_t interruptions;
+    uint32_t lost_max;          // Largest drop from acked to the resume point
+    uint32_t end_rate;
+    bool resumed;               // Check the next START answer
+} updater_t;
+
+// Global Variables
+static uint8_t image[IMAGE_SIZE];
+static uint8_t other[IMAGE_SIZE];       // Another build of the same size
+static uint8_t running[RUNNING_SIZE];
+static const uint8_t *file = image;     // What the updater sends
+static uint32_t file_crc = 0;
+static uint32_t rng = 35;
+static updater_t up;
+static faults_t faults;
+static uint32_t flash_ops = 0;
+static bool power_lost = false;
+static bool connected = false;
+
+// Local Functions
+static uint32_t next_rand(void);
+static uint32_t crc32_ieee(const uint8_t *data, uint32_t length);
+static uint32_t get_u32(const uint8_t *p);
+static void put_u32(uint8_t *p, uint32_t v);
+static bool flash_hook(stub_flash_op_t op, uint32_t addr, uint32_t len);
+static uint32_t boot_select(void);
+static bool bank_matches(uint32_t bank, uint32_t length);
+static void control(uint8_t cmd);
+static void rewind_to(uint32_t offset);
+static void on_notify(const central_ntf_t *ntf);
+static void drain(void);
+static void send_data(void);
+static void event(void);
+static void interrupted(bool reset);
+static void setup(const faults_t *f);
+static bool finish(void);
+static bool run(const faults_t *f);
+static void test_clean(void);
+static void test_loss(void);
+static void test_disconnects(void);
+static void test_power_cuts(void);
+static void test_other_image(void);
+
+int main(void) {
+    test_quiet();
+
+    for (uint32_t i = 0; i < IMAGE_SIZE; i++) {
+        image[i] = (uint8_t)(next_rand() >> 16);
+    }
+    image[0] = IMG_SIGNATURE_0;
+    image[1] = IMG_SIGNATURE_1;
+    memcpy(other, image, IMAGE_SIZE);
+    other[IMAGE_SIZE / 2] ^= 0x01;
+
+    for (uint32_t i = 0; i < RUNNING_SIZE; i++) {
+        running[i] = (uint8_t)(next_rand() >> 16);
+    }
+    running[0] = IMG_SIGNATURE_0;
+    running[1] = IMG_SIGNATURE_1;
+    running[2] = IMG_VALID;
+    running[3] = RUNNING_ID;
+
+    stub_flash_hook = flash_hook;
+    stub_mtu = 247;
+
+    test_clean();
+    test_loss();
+    test_disconnects();
+    test_power_cuts();
+    test_other_image();
+
+    return test_report("test_ota");
+}
+
+static uint32_t next_rand(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng;
+}
+
+/**
+ * @brief Bitwise IEEE CRC32, as the host tool computes it over the .img file
+ */
+static uint32_t crc32_ieee(const uint8_t *data, uint32_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief Count flash operations and cut the power at faults.cut_op
+ */
+static bool flash_hook(stub_flash_op_t op, uint32_t addr, uint32_t len) {
+    if (power_lost) {
+        return false;
+    }
+    if (++flash_ops != faults.cut_op) {
+        return true;
+    }
+
+    power_lost = true;
+    if (faults.cut_mode == CUT_TORN && op == STUB_FLASH_ERASE) {
+        memset(&stub_flash[addr], 0xFF, len / 2);
+    }
+    return faults.cut_mode == CUT_AFTER;
+}
+
+/**
+ * @brief Bank the bootloader starts: the valid one with the newest image id
+ */
+static uint32_t boot_select(void) {
+    const uint8_t *h1 = &stub_flash[OTA_BANK1_ADDR];
+    const uint8_t *h2 = &stub_flash[OTA_BANK2_ADDR];
+    bool v1 = h1[0] == IMG_SIGNATURE_0 && h1[1] == IMG_SIGNATURE_1 && h1[2] == IMG_VALID;
+    bool v2 = h2[0] == IMG_SIGNATURE_0 && h2[1] == IMG_SIGNATURE_1 && h2[2] == IMG_VALID;
+
+    if (v2 && (!v1 || (int8_t)(h2[3] - h1[3]) > 0)) {
+        return OTA_BANK2_ADDR;
+    }
+    return v1 ? OTA_BANK1_ADDR : 0;
+}
+
+/**
+ * @brief First length bytes of a bank are the file's (valid flag and image id aside)
+ */
+static bool bank_matches(uint32_t bank, uint32_t length) {
+    const uint8_t *b = &stub_flash[bank];
+
+    if (length <= 4) {
+        return memcmp(b, file, (length < 2) ? length : 2) == 0;
+    }
+    return memcmp(b, file, 2) == 0 && memcmp(&b[4], &file[4], length - 4) == 0;
+}
+
+static void control(uint8_t cmd) {
+    uint8_t frame[9] = { cmd };
+
+    put_u32(&frame[1], IMAGE_SIZE);
+    put_u32(&frame[5], file_crc);
+    central_write(0, CUSTS1_IDX_OTA_CONTROL_VAL, frame, (cmd == OTA_CMD_START) ? 9 : 1);
+}
+
+/**
+ * @brief Continue from the band's Next, windows counted from there
+ */
+static void rewind_to(uint32_t offset) {
+    up.send = offset;
+    up.acked = offset;
+    up.mark_count = 0;
+    up.since_mark = 0;
+}
+
+/**
+ * @brief One answer on the OTA control characteristic
+ */
+static void on_notify(const central_ntf_t *ntf) {
+    const uint8_t *v = ntf->value;
+
+    if (ntf->handle != CUSTS1_IDX_OTA_CONTROL_VAL || ntf->length < 3 || v[0] != DATA_HEADER_OTA) {
+        return;
+    }
+    up.quiet = 0;
+
+    if (v[1] == OTA_CMD_START && up.state == UP_WAIT_START) {
+        CHECK_EQ(v[2], OTA_STATUS_OK);
+        CHECK_EQ(ntf->length, 10);
+        uint32_t next = get_u32(&v[3]);
+        up.window = v[7];
+        up.max_data = (uint16_t)(v[8] | (v[9] << 8));
+        CHECK(up.window > 0);
+        CHECK_EQ(up.max_data, stub_mtu - 3 - OTA_DATA_HEADER_LEN);
+
+        // Resume point: a sector boundary or the end, only bytes really in flash
+        CHECK(next % NVM_SECTOR_SIZE == 0 || next == IMAGE_SIZE);
+        CHECK(next <= IMAGE_SIZE);
+        CHECK(bank_matches(OTA_BANK2_ADDR, next));
+        if (up.resumed) {
+            uint32_t floor = up.acked & ~(uint32_t)(NVM_SECTOR_SIZE - 1);
+            up.lost_max = (up.acked > next && up.acked - next > up.lost_max) ? up.acked - next : up.lost_max;
+            if (!faults.cut_op) {
+                CHECK(next >= floor);           // Nothing acked is lost on a disconnect
+            }
+            up.resumed = false;
+        }
+
+        rewind_to(next);
+        up.state = UP_SEND;
+    } else if (v[1] == OTA_CMD_ACK && up.state == UP_SEND && ntf->length == 7) {
+        uint32_t next = get_u32(&v[3]);
+
+        CHECK(v[2] == OTA_STATUS_OK || v[2] == OTA_STATUS_OUT_OF_ORDER || v[2] == OTA_STATUS_FLASH_ERROR);
+        if (v[2] == OTA_STATUS_OK && up.mark_count > 0 && up.marks[0] == next) {
+            up.acked = next;
+            up.mark_count--;
+            memmove(&up.marks[0], &up.marks[1], up.mark_count * sizeof(up.marks[0]));
+        } else {
+            // Lost packet, data dropped while a sector was erased, or a failed write
+            rewind_to(next);
+        }
+    } else if (v[1] == OTA_CMD_END && up.state == UP_WAIT_END) {
+        CHECK_EQ(ntf->length, 15);
+        if (v[2] == OTA_STATUS_OK) {
+            up.end_rate = get_u32(&v[11]);
+            up.state = UP_DONE;
+        } else {
+            CHECK_EQ(v[2], OTA_STATUS_FLASH_ERROR);
+            up.state = UP_START;
+        }
+    }
+}
+
+static void drain(void) {
+    central_ntf_t ntf;
+
+    central_confirm(0, CENTRAL_CFM_ALL);
+    while (central_receive(&ntf)) {
+        on_notify(&ntf);
+    }
+}
+
+/**
+ * @brief One connection event worth of data, at most two windows past the last ack
+ */
+static void send_data(void) {
+    uint8_t pkt[OTA_DATA_HEADER_LEN + MAX_OTA_DATA_LEN];
+
+    for (uint8_t n = 0; n < PACKETS_PER_EVENT && !power_lost; n++) {
+        if (up.send >= IMAGE_SIZE || up.mark_count >= WINDOWS_IN_FLIGHT) {
+            break;
+        }
+
+        uint32_t len = IMAGE_SIZE - up.send;
+        len = (len > up.max_data) ? up.max_data : len;
+        put_u32(pkt, up.send);
+        memcpy(&pkt[OTA_DATA_HEADER_LEN], &file[up.send], len);
+        if (next_rand() % 100 >= faults.loss_percent) {
+            central_write(0, CUSTS1_IDX_OTA_DATA_VAL, pkt, (uint16_t)(OTA_DATA_HEADER_LEN + len));
+        }
+
+        up.air_bytes += len;
+        up.send += len;
+        if (++up.since_mark == up.window || up.send == IMAGE_SIZE) {
+            up.marks[up.mark_count++] = up.send;
+            up.since_mark = 0;
+        }
+    }
+}
+
+/**
+ * @brief Phone then band: one connection event, then a main loop pass
+ */
+static void event(void) {
+    if (!connected) {
+        central_connect(0);
+        central_subscribe(0, CUSTS1_IDX_OTA_CONTROL_NTF_CFG, true);
+        connected = true;
+        up.state = UP_START;
+    }
+
+    switch (up.state) {
+        case UP_START:
+            control(OTA_CMD_START);
+            up.state = UP_WAIT_START;
+            up.quiet = 0;
+            break;
+
+        case UP_SEND:
+            if (up.acked == IMAGE_SIZE) {
+                control(OTA_CMD_END);
+                up.state = UP_WAIT_END;
+                up.quiet = 0;
+            } else {
+                send_data();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (!power_lost) {
+        drain();
+        user_ota_poll();
+    }
+    if (!power_lost) {
+        drain();
+    }
+
+    // Nothing heard for a while: ask again, or resend from the last ack
+    if (++up.quiet >= TIMEOUT_EVENTS) {
+        up.quiet = 0;
+        if (up.state == UP_WAIT_START || up.state == UP_WAIT_END) {
+            up.state = UP_START;
+        } else if (up.state == UP_SEND) {
+            rewind_to(up.acked);
+        }
+    }
+
+    test_now_us += EVENT_US;
+}
+
+/**
+ * @brief Link dropped, or the band restarted with only its flash
+ */
+static void interrupted(bool reset) {
+    if (connected) {
+        central_disconnect(0);
+        connected = false;
+    }
+
+    if (reset) {
+        power_lost = false;
+        central_init();
+        user_ota_init();
+
+        // Until END has matched the CRC the bootloader keeps the running image
+        uint32_t boot = boot_select();
+        CHECK(boot == OTA_BANK1_ADDR || (boot == OTA_BANK2_ADDR && bank_matches(OTA_BANK2_ADDR, IMAGE_SIZE)));
+        CHECK(memcmp(&stub_flash[OTA_BANK1_ADDR], running, RUNNING_SIZE) == 0);
+        if (boot == OTA_BANK2_ADDR) {
+            up.state = UP_DONE;                 // Marked valid just before the cut
+            return;
+        }
+    }
+
+    up.interruptions++;
+    up.resumed = true;
+}
+
+/**
+ * @brief Band running the image in bank 1 with no resume point, updater about to send image
+ */
+static void setup(const faults_t *f) {
+    faults = *f;
+    flash_ops = 0;
+    power_lost = false;
+    connected = false;
+    memset(&up, 0, sizeof(up));
+    file = image;
+    file_crc = crc32_ieee(file, IMAGE_SIZE);
+
+    stub_flash_erase_all();
+    memcpy(&stub_flash[OTA_BANK1_ADDR], running, RUNNING_SIZE);
+    central_init();
+    user_ota_init();
+}
+
+/**
+ * @brief Drive the update to the end through the faults set up
+ * @return true when the new image was written, marked and rebooted into
+ */
+static bool finish(void) {
+    uint32_t events = 0;
+
+    while (up.state != UP_DONE && events++ < MAX_EVENTS) {
+        event();
+
+        if (power_lost) {
+            interrupted(true);
+        } else if (connected && next_rand() % 100 < faults.disconnect_percent) {
+            interrupted(false);
+        }
+    }
+    CHECK_EQ(up.state, UP_DONE);
+    if (up.state != UP_DONE) {
+        return false;
+    }
+
+    // Not rebooted yet if the cut came after the image was marked
+    if (connected && boot_select() != OTA_BANK2_ADDR) {
+        CHECK(false);
+    }
+    if (connected) {
+        uint32_t resets = stub_resets;
+        control(OTA_CMD_REBOOT);
+        CHECK_EQ(stub_resets, resets + 1);
+    }
+
+    bool ok = boot_select() == OTA_BANK2_ADDR && bank_matches(OTA_BANK2_ADDR, IMAGE_SIZE) &&
+              stub_flash[OTA_BANK2_ADDR + 3] == RUNNING_ID + 1 &&
+              memcmp(&stub_flash[OTA_BANK1_ADDR], running, RUNNING_SIZE) == 0;
+    CHECK(ok);
+
+    central_disconnect(0);
+    connected = false;
+    return ok;
+}
+
+/**
+ * @brief One update from a running image in bank 1, through the given faults
+ */
+static bool run(const faults_t *f) {
+    setup(f);
+    return finish();
+}
+
+/**
+ * @brief No faults: every byte sent once, rate reported by END
+ */
+static void test_clean(void) {
+    faults_t f = { 0 };
+    uint64_t start = test_now_us;
+
+    CHECK(run(&f));
+    CHECK_EQ(up.air_bytes, IMAGE_SIZE);
+    CHECK_EQ(up.interruptions, 0);
+    CHECK(up.end_rate > 0);
+
+    uint64_t elapsed_ms = (test_now_us - start) / 1000;
+    fprintf(stderr, "ota: %u bytes in %llu ms at %u packets per %u ms event, END reports %u B/s\n",
+            IMAGE_SIZE, (unsigned long long)elapsed_ms, PACKETS_PER_EVENT, EVENT_US / 1000, up.end_rate);
+}
+
+/**
+ * @brief Lost data packets: each costs at most the packets in flight behind it
+ */
+static void test_loss(void) {
+    faults_t f = { .loss_percent = 5 };
+    uint32_t air_max = 0;
+
+    for (int i = 0; i < LOSS_RUNS; i++) {
+        CHECK(run(&f));
+        air_max = (up.air_bytes > air_max) ? up.air_bytes : air_max;
+    }
+    fprintf(stderr, "ota: 5%% packet loss, at most %.2fx the image sent\n", (double)air_max / IMAGE_SIZE);
+}
+
+/**
+ * @brief Dropped links: START continues from the last sector with every byte acked
+ */
+static void test_disconnects(void) {
+    faults_t f = { .loss_percent = 2, .disconnect_percent = 5 };
+    uint32_t interruptions = 0;
+    uint32_t lost_max = 0;
+
+    for (int i = 0; i < DISCONNECT_RUNS; i++) {
+        CHECK(run(&f));
+        interruptions += up.interruptions;
+        lost_max = (up.lost_max > lost_max) ? up.lost_max : lost_max;
+    }
+    CHECK(interruptions > DISCONNECT_RUNS);
+    CHECK(lost_max < NVM_SECTOR_SIZE);
+    fprintf(stderr, "ota: %u disconnects, at most %u acked bytes resent after one\n", interruptions, lost_max);
+}
+
+/**
+ * @brief A power cut at every flash operation of an update, in each cut mode
+ */
+static void test_power_cuts(void) {
+    faults_t f = { 0 };
+    uint32_t ops;
+    uint32_t cuts = 0;
+    uint32_t lost_max = 0;
+    uint32_t restarts = 0;
+
+    CHECK(run(&f));
+    ops = flash_ops;
+    CHECK(ops > IMAGE_SECTORS);
+
+    for (f.cut_mode = CUT_BEFORE; f.cut_mode < CUT_MODES; f.cut_mode++) {
+        for (f.cut_op = 1; f.cut_op <= ops; f.cut_op++) {
+            CHECK(run(&f));
+            cuts += up.interruptions;
+            lost_max = (up.lost_max > lost_max) ? up.lost_max : lost_max;
+            restarts += (up.lost_max >= NVM_SECTOR_SIZE);
+        }
+    }
+    CHECK(lost_max < 2 * NVM_SECTOR_SIZE);
+    fprintf(stderr, "ota: %u power cuts over %u flash operations, at most %u acked bytes resent, "
+            "%u resumes lost more than a sector\n", cuts, ops, lost_max, restarts);
+}
+
+/**
+ * @brief Half of one file sent, then another one started and cut, then the first again
+ */
+static void test_other_image(void) {
+    faults_t f = { 0 };
+    uint32_t resumed = 0;
+    uint32_t runs = 0;
+
+    for (f.cut_mode = CUT_BEFORE; f.cut_mode < CUT_MODES; f.cut_mode++) {
+        for (uint32_t k = 1; k <= 8; k++) {
+            setup(&f);
+            while (up.acked < IMAGE_SIZE / 2) {
+                event();
+            }
+            event();                            // Last commit saved
+            interrupted(false);
+
+            file = other;
+            file_crc = crc32_ieee(file, IMAGE_SIZE);
+            up.resumed = false;
+            faults.cut_op = flash_ops + k;
+            for (uint32_t n = 0; n < MAX_EVENTS && !power_lost; n++) {
+                event();
+            }
+            CHECK(power_lost);
+
+            // Back to the first file: a resume point left over must still match the flash
+            file = image;
+            file_crc = crc32_ieee(file, IMAGE_SIZE);
+            interrupted(true);
+            up.resumed = false;
+            for (uint32_t n = 0; n < MAX_EVENTS && up.state != UP_SEND; n++) {
+                event();
+            }
+            resumed += (up.acked > 0);
+            runs++;
+            CHECK(finish());
+        }
+    }
+    fprintf(stderr, "ota: other file cut while replacing a half-sent one, %u of %u resumes kept\n",
+            resumed, runs);
+}
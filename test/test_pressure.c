@@ -0,0 +1,232 @@
+/**
+ * @file test_pressure.c
+ * @brief Pressure chain: CIC gain and noise, calibration table, NVM and load rate
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Drives user_pressure.c the way read_sensors() does: PRESSURE_OVERSAMPLE
+ * conversions per output sample, then one decimation. The noise case checks
+ * the figure in the file header of user_pressure.c (0.29x the rms noise of
+ * one conversion, 0.35x for a plain 8-sample mean).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "test.h"
+#include "user_pressure.h"
+#include "user_nvm.h"
+
+#define NOISE_SAMPLES                   20000
+#define NOISE_SIGMA_CODES               8.0
+
+// Global Variables
+static uint32_t rng = 34;
+
+// Local Functions
+static double gauss(void);
+static void sample(const uint16_t *codes, pressure_out_t *out);
+static void sample_level(uint16_t code, pressure_out_t *out);
+static void put_table(uint8_t *blob, const uint16_t *table);
+static void test_dc(void);
+static void test_noise(void);
+static void test_calibration(void);
+static void test_load_rate(void);
+
+int main(void) {
+    test_quiet();
+    user_pressure_init();
+
+    test_dc();
+    test_noise();
+    test_calibration();
+    test_load_rate();
+
+    return test_report("test_pressure");
+}
+
+static double gauss(void) {
+    double u[2];
+
+    for (int i = 0; i < 2; i++) {
+        rng = rng * 1103515245u + 12345u;
+        u[i] = ((rng >> 8) + 0.5) / 16777216.0;
+    }
+    return sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+/**
+ * @brief One output sample from one burst of conversions
+ */
+static void sample(const uint16_t *codes, pressure_out_t *out) {
+    for (uint8_t i = 0; i < PRESSURE_OVERSAMPLE; i++) {
+        user_pressure_push(codes[i]);
+    }
+    user_pressure_decimate(100, out);
+}
+
+static void sample_level(uint16_t code, pressure_out_t *out) {
+    uint16_t codes[PRESSURE_OVERSAMPLE];
+
+    for (uint8_t i = 0; i < PRESSURE_OVERSAMPLE; i++) {
+        codes[i] = code;
+    }
+    sample(codes, out);
+}
+
+static void put_table(uint8_t *blob, const uint16_t *table) {
+    for (uint8_t i = 0; i < PRESSURE_CAL_POINTS; i++) {
+        blob[2 * i] = (uint8_t)table[i];
+        blob[2 * i + 1] = (uint8_t)(table[i] >> 8);
+    }
+}
+
+/**
+ * @brief Constant input: 12-bit raw is 4x the code, the default table is the old 0-100 kPa line
+ */
+static void test_dc(void) {
+    pressure_out_t out;
+
+    for (uint16_t code = 0; code <= 1023; code++) {
+        user_pressure_init();
+        sample_level(code, &out);               // First output: own burst only
+        CHECK_EQ(out.raw, code * 4);
+        sample_level(code, &out);
+        CHECK_EQ(out.raw, code * 4);
+        CHECK_EQ(out.load_rate, 0);
+
+        // Same line as the old (code * 100) / 1023 kPa, which truncated to whole kPa;
+        // the table interpolation truncates too, at 25 Pa steps
+        double lsb = code * 4000.0 / 1023.0;
+        CHECK(fabs(out.pressure - lsb) < 1.5);
+    }
+
+    // A step settles on the second output (this burst and the last one)
+    user_pressure_init();
+    sample_level(200, &out);
+    sample_level(200, &out);
+    sample_level(600, &out);
+    CHECK(out.raw > 800 && out.raw < 2400);
+    sample_level(600, &out);
+    CHECK_EQ(out.raw, 2400);
+}
+
+/**
+ * @brief White noise on every conversion: rms at the output against one conversion
+ */
+static void test_noise(void) {
+    const double level = 512.0;
+    double sum_sq = 0.0;
+    double mean_sq = 0.0;
+    pressure_out_t out;
+
+    user_pressure_init();
+    for (int n = 0; n < NOISE_SAMPLES; n++) {
+        uint16_t codes[PRESSURE_OVERSAMPLE];
+        double mean = 0.0;
+
+        for (uint8_t i = 0; i < PRESSURE_OVERSAMPLE; i++) {
+            double v = level + NOISE_SIGMA_CODES * gauss();
+            codes[i] = (uint16_t)lround(v);
+            mean += codes[i];
+        }
+        sample(codes, &out);
+        if (n == 0) {
+            continue;
+        }
+
+        double err = out.raw / 4.0 - level;
+        double mean_err = mean / PRESSURE_OVERSAMPLE - level;
+        sum_sq += err * err;
+        mean_sq += mean_err * mean_err;
+    }
+
+    double cic = sqrt(sum_sq / (NOISE_SAMPLES - 1)) / NOISE_SIGMA_CODES;
+    double plain = sqrt(mean_sq / (NOISE_SAMPLES - 1)) / NOISE_SIGMA_CODES;
+    fprintf(stderr, "pressure noise: CIC %.3fx, 8-sample mean %.3fx of one conversion\n", cic, plain);
+
+    // Weights 1..8..1 / 64: sqrt(344) / 64 = 0.290; mean 1 / sqrt(8) = 0.354
+    CHECK(fabs(cic - 0.290) < 0.01);
+    CHECK(fabs(plain - 0.354) < 0.01);
+    CHECK(cic < plain);
+}
+
+/**
+ * @brief Per-device table: interpolation, validation, NVM round trip
+ */
+static void test_calibration(void) {
+    uint16_t table[PRESSURE_CAL_POINTS];
+    uint8_t blob[PRESSURE_CAL_LEN];
+    uint8_t read[PRESSURE_CAL_LEN];
+    pressure_out_t out;
+
+    // Sensor saturating towards the top: steep first, flat last
+    for (uint8_t i = 0; i < PRESSURE_CAL_POINTS; i++) {
+        table[i] = (uint16_t)(4000.0 * sqrt(i / 16.0));
+    }
+    put_table(blob, table);
+    CHECK(user_pressure_set_calibration(blob));
+
+    // Points and midpoints of each segment
+    for (uint8_t seg = 0; seg < PRESSURE_CAL_POINTS - 1; seg++) {
+        uint16_t code = (uint16_t)((seg << PRESSURE_CAL_SEG_SHIFT) / 4);
+        user_pressure_init();
+        user_pressure_set_calibration(blob);
+        sample_level(code, &out);
+        CHECK_EQ(out.pressure, table[seg]);
+
+        code += (1 << PRESSURE_CAL_SEG_SHIFT) / 8;
+        sample_level(code, &out);
+        sample_level(code, &out);
+        CHECK(abs((int)out.pressure - (table[seg] + table[seg + 1]) / 2) <= 1);
+    }
+
+    // Not monotonic, or past 12 bits: refused, table unchanged
+    uint16_t bad[PRESSURE_CAL_POINTS];
+    for (uint8_t i = 0; i < PRESSURE_CAL_POINTS; i++) {
+        bad[i] = table[i];
+    }
+    bad[5] = bad[4] - 1;
+    put_table(read, bad);
+    CHECK(!user_pressure_set_calibration(read));
+    bad[5] = table[5];
+    bad[16] = PRESSURE_RAW_MAX + 1;
+    put_table(read, bad);
+    CHECK(!user_pressure_set_calibration(read));
+    user_pressure_get_calibration(read);
+    for (uint8_t i = 0; i < PRESSURE_CAL_LEN; i++) {
+        CHECK_EQ(read[i], blob[i]);
+    }
+
+    // Saved from the sampling loop, back after a restart
+    user_pressure_save_poll();
+    user_pressure_init();
+    user_pressure_get_calibration(read);
+    for (uint8_t i = 0; i < PRESSURE_CAL_LEN; i++) {
+        CHECK_EQ(read[i], blob[i]);
+    }
+}
+
+/**
+ * @brief A steady ramp gives its slope in 25 Pa/s
+ */
+static void test_load_rate(void) {
+    uint16_t table[PRESSURE_CAL_POINTS];
+    uint8_t blob[PRESSURE_CAL_LEN];
+    pressure_out_t out;
+
+    // Identity table: 12-bit raw is the pressure
+    for (uint8_t i = 0; i < PRESSURE_CAL_POINTS; i++) {
+        table[i] = (uint16_t)((i << PRESSURE_CAL_SEG_SHIFT) > PRESSURE_RAW_MAX ? PRESSURE_RAW_MAX : (i << PRESSURE_CAL_SEG_SHIFT));
+    }
+    put_table(blob, table);
+    user_pressure_init();
+    CHECK(user_pressure_set_calibration(blob));
+
+    // 2 codes per sample at 100 Hz: 8 raw LSB per sample, 800 LSB/s
+    for (uint16_t n = 0; n < 100; n++) {
+        sample_level(100 + 2 * n, &out);
+        if (n >= 2) {
+            CHECK_EQ(out.load_rate, 800);
+        }
+    }
+}
@@ -0,0 +1,293 @@
+/**
+ * @file test_reps.c
+ * @brief Repetition counter: template register, NVM record, rep and set rules
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Feeds 100 Hz IMU samples through user_reps_process() as reps_update() in
+ * main.c does. Knee extensions (tools/tracegen.py shape) are counted against
+ * a template cut from the same motion, with tempo and amplitude varied rep
+ * to rep and an offset on the axis; walking and single reps must not make a
+ * set. Tempo and range of motion are checked against the generated motion.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "user_reps.h"
+#include "user_nvm.h"
+#include "user_config.h"
+#include "sdk_stub.h"
+
+#define SAMPLE_HZ                       100
+#define SAMPLE_MS                       (1000 / SAMPLE_HZ)
+#define KNEE_THRESHOLD                  96      // 4 x Len, inside the README's 3-5 x Len
+#define KNEE_AMPLITUDE_DEG              70.0
+
+// Global Variables
+static uint32_t now_ms = 0;
+static uint32_t rng = 39;
+static uint8_t knee_blob[REPS_TEMPLATE_BLOB_LEN];
+
+// Local Functions
+static double noise_mg(void);
+static void feed(double x, double y, double z);
+static void sit(double seconds, double z_offset);
+static void walk(double seconds);
+static double knee_rep(double raise_s, double hold_s, double lower_s, double amplitude_deg, double z_offset);
+static void make_knee_template(uint8_t *blob);
+static void test_template(void);
+static void test_nvm(void);
+static void test_count(void);
+static void test_reject(void);
+static void test_set_rules(void);
+
+int main(void) {
+    test_quiet();
+    user_reps_init();
+    make_knee_template(knee_blob);
+
+    test_template();
+    test_nvm();
+    test_count();
+    test_reject();
+    test_set_rules();
+
+    return test_report("test_reps");
+}
+
+static double noise_mg(void) {
+    rng = rng * 1103515245u + 12345u;
+    return (int32_t)((rng >> 16) % 33) - 16;
+}
+
+/**
+ * @brief One IMU sample in mg, magnitude as main.c computes it
+ */
+static void feed(double x, double y, double z) {
+    reps_sample_t s = {
+        .time_ms = now_ms,
+        .accel = { (int16_t)lround(x), (int16_t)lround(y), (int16_t)lround(z) },
+        .accel_mg = (uint16_t)lround(sqrt(x * x + y * y + z * z))
+    };
+
+    user_reps_process(&s);
+    now_ms += SAMPLE_MS;
+}
+
+static void sit(double seconds, double z_offset) {
+    for (int i = 0; i < (int)(seconds * SAMPLE_HZ); i++) {
+        feed(noise_mg(), noise_mg(), 1000.0 + z_offset + noise_mg());
+    }
+}
+
+static void walk(double seconds) {
+    for (int i = 0; i < (int)(seconds * SAMPLE_HZ); i++) {
+        double t = i / (double)SAMPLE_HZ;
+        feed(150.0 * sin(2 * M_PI * 0.9 * t) + noise_mg(), 200.0 * sin(2 * M_PI * 1.8 * t + 1.0),
+             1000.0 + 350.0 * sin(2 * M_PI * 1.8 * t) + noise_mg());
+    }
+}
+
+/**
+ * @brief Seated knee extension: raise, hold, lower, 0.6 s rest
+ * @return Peak-to-peak of Z over the rep, mg
+ */
+static double knee_rep(double raise_s, double hold_s, double lower_s, double amplitude_deg, double z_offset) {
+    int raise = (int)(raise_s * SAMPLE_HZ);
+    int hold = (int)(hold_s * SAMPLE_HZ);
+    int lower = (int)(lower_s * SAMPLE_HZ);
+    int total = raise + hold + lower + 60;
+
+    for (int i = 0; i < total; i++) {
+        double phase = 0.0;
+        if (i < raise) {
+            phase = 0.5 * (1 - cos(M_PI * i / raise));
+        } else if (i < raise + hold) {
+            phase = 1.0;
+        } else if (i < raise + hold + lower) {
+            phase = 0.5 * (1 + cos(M_PI * (i - raise - hold) / lower));
+        }
+        double angle = amplitude_deg * M_PI / 180.0 * phase;
+        feed(noise_mg(), 1000.0 * sin(angle), 1000.0 * cos(angle) + z_offset + noise_mg());
+    }
+    return 1000.0 * (1 - cos(amplitude_deg * M_PI / 180.0));
+}
+
+/**
+ * @brief Register 0x18 blob for slot 0, as tools/tracegen.py knee_extension_template()
+ */
+static void make_knee_template(uint8_t *blob) {
+    uint8_t len = 0;
+
+    memset(blob, 0, REPS_TEMPLATE_BLOB_LEN);
+    for (double t = 0.0; t < 2.4 - 1e-9 && len < REPS_TEMPLATE_MAX_LEN; t += 0.1) {
+        double phase = (t < 1.0) ? 0.5 * (1 - cos(M_PI * t)) :
+                       (t < 1.4) ? 1.0 : 0.5 * (1 + cos(M_PI * (t - 1.4)));
+        double z = 1000.0 * cos(KNEE_AMPLITUDE_DEG * M_PI / 180.0 * phase);
+        blob[5 + len++] = (uint8_t)(int8_t)lround(z / REPS_LSB_MG);
+    }
+    blob[0] = 0;
+    blob[1] = REPS_AXIS_Z;
+    blob[2] = KNEE_THRESHOLD & 0xFF;
+    blob[3] = KNEE_THRESHOLD >> 8;
+    blob[4] = len;
+}
+
+/**
+ * @brief Register checks: slot, axis, threshold and length limits; Len 0 clears
+ */
+static void test_template(void) {
+    uint8_t blob[REPS_TEMPLATE_BLOB_LEN];
+    uint8_t status[REPS_STATUS_LEN];
+
+    memcpy(blob, knee_blob, sizeof(blob));
+    blob[0] = REPS_TEMPLATE_SLOTS;
+    CHECK(!user_reps_set_template(blob));
+    blob[0] = 1;
+    blob[1] = REPS_AXIS_NB;
+    CHECK(!user_reps_set_template(blob));
+    blob[1] = REPS_AXIS_Z;
+    blob[2] = blob[3] = 0;
+    CHECK(!user_reps_set_template(blob));
+    blob[2] = KNEE_THRESHOLD;
+    blob[4] = REPS_TEMPLATE_MIN_LEN - 1;
+    CHECK(!user_reps_set_template(blob));
+    blob[4] = REPS_TEMPLATE_MAX_LEN + 1;
+    CHECK(!user_reps_set_template(blob));
+
+    user_reps_get_status(status);
+    CHECK_EQ(status[0], 0);
+
+    blob[4] = REPS_TEMPLATE_MIN_LEN;
+    CHECK(user_reps_set_template(blob));
+    CHECK(user_reps_set_template(knee_blob));
+    user_reps_get_status(status);
+    CHECK_EQ(status[0], 0x03);
+    CHECK_EQ(status[1], 0xFF);
+
+    blob[4] = 0;
+    CHECK(user_reps_set_template(blob));
+    user_reps_get_status(status);
+    CHECK_EQ(status[0], 0x01);
+}
+
+/**
+ * @brief Templates saved from the loop, back after a restart, 36 bytes per slot
+ */
+static void test_nvm(void) {
+    uint8_t status[REPS_STATUS_LEN];
+    uint32_t addr = NVM_BASE_ADDR + NVM_RECORD_REP_TEMPLATES * NVM_SECTOR_SIZE;
+
+    user_reps_save_poll();
+    const uint8_t *header = &stub_flash[addr];
+    CHECK_EQ(header[0] | (header[1] << 8), NVM_RECORD_MAGIC);
+    CHECK_EQ(header[4] | (header[5] << 8), REPS_TEMPLATE_SLOTS * (4 + REPS_TEMPLATE_MAX_LEN));
+
+    // Nothing changed: no second write
+    uint32_t writes = stub_flash_writes;
+    user_reps_save_poll();
+    CHECK_EQ(stub_flash_writes, writes);
+
+    user_reps_init();
+    user_reps_get_status(status);
+    CHECK_EQ(status[0], 0x01);
+}
+
+/**
+ * @brief Two sets, varied tempo and depth, the second on an offset axis
+ */
+static void test_count(void) {
+    reps_set_t set;
+    double rom_sum = 0.0;
+    uint32_t start_ms;
+    uint32_t first_ms = 0;
+    uint32_t last_ms = 0;
+
+    user_reps_reset();
+    sit(5.0, 0.0);
+    for (int i = 0; i < 10; i++) {
+        start_ms = now_ms;
+        rom_sum += knee_rep(1.0, 0.4, 1.0, KNEE_AMPLITUDE_DEG, 0.0);
+        first_ms = (i == 0) ? start_ms : first_ms;
+        last_ms = start_ms;
+    }
+    CHECK(!user_reps_take_set(&set));           // Not closed before the pause
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 0.0);
+
+    CHECK(user_reps_take_set(&set));
+    CHECK_EQ(set.reps, 10);
+    CHECK_EQ(set.slot, 0);
+    double tempo = (last_ms - first_ms) / 9.0;
+    CHECK(fabs(set.tempo_ms - tempo) < 0.05 * tempo);
+    CHECK(fabs(set.rom_mg - rom_sum / 10) < 4 * REPS_LSB_MG);
+
+    // Slower and shallower, 300 mg offset on Z: matching is offset free
+    uint16_t first_set = set.set;
+    rom_sum = 0.0;
+    for (int i = 0; i < 8; i++) {
+        double k = 0.9 + 0.05 * (i % 4);
+        rom_sum += knee_rep(1.1 * k, 0.4, 1.2 * k, 62.0, 300.0);
+    }
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 300.0);
+
+    CHECK(user_reps_take_set(&set));
+    CHECK_EQ(set.reps, 8);
+    CHECK_EQ(set.set, first_set + 1);
+    CHECK(fabs(set.rom_mg - rom_sum / 8) < 4 * REPS_LSB_MG);
+    fprintf(stderr, "reps: set of %d, tempo %d ms, ROM %d mg (generated %.0f mg)\n",
+            set.reps, set.tempo_ms, set.rom_mg, rom_sum / 8);
+
+    // Same length, phases moved by up to 0.4 s: only the warped comparison matches,
+    // so the lower bound must allow for the warp too
+    for (int i = 0; i < 6; i++) {
+        knee_rep(0.7, 0.9, 0.8, KNEE_AMPLITUDE_DEG, 0.0);
+    }
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 0.0);
+    CHECK(user_reps_take_set(&set));
+    CHECK_EQ(set.reps, 6);
+}
+
+/**
+ * @brief Walking and sitting make no reps; other templates stay out of an open set
+ */
+static void test_reject(void) {
+    reps_set_t set;
+    uint8_t status[REPS_STATUS_LEN];
+
+    user_reps_reset();
+    walk(60.0);
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 0.0);
+    CHECK(!user_reps_take_set(&set));
+    user_reps_get_status(status);
+    CHECK_EQ(status[1], 0xFF);
+    CHECK_EQ(status[2] | (status[3] << 8), 0);
+}
+
+/**
+ * @brief A lone rep is not a set; a pause under the gap keeps the set open
+ */
+static void test_set_rules(void) {
+    reps_set_t set;
+    uint8_t status[REPS_STATUS_LEN];
+
+    user_reps_reset();
+    sit(3.0, 0.0);
+    knee_rep(1.0, 0.4, 1.0, KNEE_AMPLITUDE_DEG, 0.0);
+    user_reps_get_status(status);
+    CHECK_EQ(status[1], 0);
+    CHECK_EQ(status[2] | (status[3] << 8), 1);
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 0.0);
+    CHECK(!user_reps_take_set(&set));
+
+    // The gap runs from one rep's match to the next, a whole rep (3 s) after the pause
+    knee_rep(1.0, 0.4, 1.0, KNEE_AMPLITUDE_DEG, 0.0);
+    sit(REPS_SET_GAP_MS / 1000.0 - 4.0, 0.0);
+    knee_rep(1.0, 0.4, 1.0, KNEE_AMPLITUDE_DEG, 0.0);
+    user_reps_get_status(status);
+    CHECK_EQ(status[2] | (status[3] << 8), 2);
+    sit(REPS_SET_GAP_MS / 1000.0 + 2.0, 0.0);
+    CHECK(user_reps_take_set(&set));
+    CHECK_EQ(set.reps, 2);
+}
@@ -0,0 +1,278 @@
+"""
+AnkleBand notification packet decoder/encoder.
+
+Generated by tools/packetgen.py from tools/packets.json - do not edit.
+
+    import ankleband_packets as pk
+    name, fields = pk.decode(notification_bytes)
+
+decode() gives engineering units for scaled fields (g, kPa), ints for
+the rest and bytes for a variable tail; pass raw=True for the integers
+on the wire. Check register 0x03 against SCHEMA_VERSION when connecting.
+"""
+
+import struct
+
+SCHEMA_VERSION = 2
+
+PACKETS = [
+    {
+        "name": "sensor",
+        "header": b'\xaa',
+        "format": "<BBBBHHHIh",
+        "fields": [
+            {"name": "accel_x", "type": "u8", "offset": -128, "scale": 0.02, "unit": "g"},
+            {"name": "accel_y", "type": "u8", "offset": -128, "scale": 0.02, "unit": "g"},
+            {"name": "accel_z", "type": "u8", "offset": -128, "scale": 0.02, "unit": "g"},
+            {"name": "jump_height", "type": "u8", "unit": "cm"},
+            {"name": "total_jumps", "type": "u16"},
+            {"name": "pressure", "type": "u16", "scale": 0.025, "unit": "kPa"},
+            {"name": "battery_mv", "type": "u16", "unit": "mV"},
+            {"name": "sample_time", "type": "u32", "unit": "us"},
+            {"name": "load_rate", "type": "i16", "unit": "kPa/s"},
+        ],
+    },
+    {
+        "name": "jump",
+        "header": b'\xbb',
+        "format": "<BHHBI",
+        "fields": [
+            {"name": "height", "type": "u8", "unit": "cm"},
+            {"name": "flight_ms", "type": "u16", "unit": "ms"},
+            {"name": "total_jumps", "type": "u16"},
+            {"name": "max_height", "type": "u8", "unit": "cm"},
+            {"name": "takeoff_time", "type": "u32", "unit": "us"},
+        ],
+    },
+    {
+        "name": "reps",
+        "header": b'\xbe',
+        "format": "<HBHHHH",
+        "fields": [
+            {"name": "set", "type": "u16"},
+            {"name": "slot", "type": "u8"},
+            {"name": "reps", "type": "u16"},
+            {"name": "tempo_ms", "type": "u16", "unit": "ms"},
+            {"name": "rom_mg", "type": "u16", "unit": "mg"},
+            {"name": "duration_s", "type": "u16", "unit": "s"},
+        ],
+    },
+    {
+        "name": "battery",
+        "header": b'\xcc',
+        "format": "<HBBH",
+        "fields": [
+            {"name": "battery_mv", "type": "u16", "unit": "mV"},
+            {"name": "percent", "type": "u8", "unit": "%"},
+            {"name": "tier", "type": "u8"},
+            {"name": "hours_left", "type": "u16", "unit": "h"},
+        ],
+    },
+    {
+        "name": "status",
+        "header": b'\xdd\x05',
+        "format": "<BBIH",
+        "fields": [
+            {"name": "mode", "type": "u8"},
+            {"name": "flags", "type": "u8", "bits": ["calibrated", "in_jump", "synced", "off_body"]},
+            {"name": "total_jumps", "type": "u32"},
+            {"name": "battery_mv", "type": "u16", "unit": "mV"},
+        ],
+    },
+    {
+        "name": "ctrl_result",
+        "header": b'\xdd~',
+        "format": "<B",
+        "fields": [
+            {"name": "seq", "type": "u8"},
+            {"name": "results", "type": "bytes", "max": 61},
+        ],
+    },
+    {
+        "name": "time_sync_req",
+        "header": b'\xdd\x07',
+        "format": "<BII",
+        "fields": [
+            {"name": "seq", "type": "u8"},
+            {"name": "t2", "type": "u32", "unit": "us"},
+            {"name": "t3", "type": "u32", "unit": "us"},
+        ],
+    },
+    {
+        "name": "time_sync_result",
+        "header": b'\xdd\x08',
+        "format": "<BBii",
+        "fields": [
+            {"name": "seq", "type": "u8"},
+            {"name": "accepted", "type": "u8"},
+            {"name": "residual_us", "type": "i32", "unit": "us"},
+            {"name": "drift_ppb", "type": "i32", "unit": "ppb"},
+        ],
+    },
+    {
+        "name": "gait",
+        "header": b'\xbd',
+        "format": "<HHBHHHHI",
+        "fields": [
+            {"name": "minute", "type": "u16"},
+            {"name": "steps", "type": "u16"},
+            {"name": "cadence_spm", "type": "u8", "unit": "steps/min"},
+            {"name": "stance_ms", "type": "u16", "unit": "ms"},
+            {"name": "swing_ms", "type": "u16", "unit": "ms"},
+            {"name": "stride_ms", "type": "u16", "unit": "ms"},
+            {"name": "stride_cv", "type": "u16", "scale": 0.1, "unit": "%"},
+            {"name": "total_steps", "type": "u32"},
+        ],
+    },
+    {
+        "name": "capture_head",
+        "header": b'\xee',
+        "format": "<HBIHBBBB",
+        "fields": [
+            {"name": "jump_id", "type": "u16"},
+            {"name": "chunk", "type": "u8", "value": 0},
+            {"name": "takeoff_time", "type": "u32", "unit": "us"},
+            {"name": "flight_ms", "type": "u16", "unit": "ms"},
+            {"name": "pre_samples", "type": "u8"},
+            {"name": "post_samples", "type": "u8"},
+            {"name": "chunks", "type": "u8"},
+            {"name": "sample_rate_hz", "type": "u8", "unit": "Hz"},
+        ],
+    },
+    {
+        "name": "capture_data",
+        "header": b'\xee',
+        "format": "<HB",
+        "fields": [
+            {"name": "jump_id", "type": "u16"},
+            {"name": "chunk", "type": "u8"},
+            {"name": "samples", "type": "bytes", "max": 240},
+        ],
+    },
+    {
+        "name": "alert",
+        "header": b'\xa1',
+        "format": "<BBIH",
+        "fields": [
+            {"name": "type", "type": "u8"},
+            {"name": "seq", "type": "u8"},
+            {"name": "impact_time", "type": "u32", "unit": "us"},
+            {"name": "peak_mg", "type": "u16", "unit": "mg"},
+        ],
+    },
+    {
+        "name": "ota_start",
+        "header": b'\xf0\x01',
+        "format": "<BIBH",
+        "fields": [
+            {"name": "status", "type": "u8"},
+            {"name": "next", "type": "u32"},
+            {"name": "window", "type": "u8"},
+            {"name": "max_data", "type": "u16"},
+        ],
+    },
+    {
+        "name": "ota_ack",
+        "header": b'\xf0\x02',
+        "format": "<BI",
+        "fields": [
+            {"name": "status", "type": "u8"},
+            {"name": "next", "type": "u32"},
+        ],
+    },
+    {
+        "name": "ota_end",
+        "header": b'\xf0\x03',
+        "format": "<BIII",
+        "fields": [
+            {"name": "status", "type": "u8"},
+            {"name": "bytes", "type": "u32"},
+            {"name": "elapsed_ms", "type": "u32", "unit": "ms"},
+            {"name": "rate", "type": "u32", "unit": "B/s"},
+        ],
+    },
+    {
+        "name": "ota_reply",
+        "header": b'\xf0',
+        "format": "<BB",
+        "fields": [
+            {"name": "cmd", "type": "u8"},
+            {"name": "status", "type": "u8"},
+        ],
+    },
+]
+
+
+def _lookup_name(name):
+    for pkt in PACKETS:
+        if pkt["name"] == name:
+            return pkt
+    raise KeyError(name)
+
+
+def _fixed(pkt):
+    return [f for f in pkt["fields"] if f["type"] != "bytes"]
+
+
+def _tail(pkt):
+    last = pkt["fields"][-1] if pkt["fields"] else None
+    return last if last is not None and last["type"] == "bytes" else None
+
+
+def _match(data):
+    """Return (pkt, values) for the first layout that fits, or (header match, None)."""
+    # Longest header first (0xDD 0x05 before any bare 0xDD), then layouts with
+    # fixed values; a reply too short for its own layout falls back to a
+    # shorter one with the same header
+    order = sorted(PACKETS, key=lambda p: (-len(p["header"]),
+                                           -sum("value" in f for f in p["fields"])))
+    seen = None
+    for pkt in order:
+        start = len(pkt["header"])
+        if data[:start] != pkt["header"]:
+            continue
+        seen = seen or pkt
+        if len(data) < start + struct.calcsize(pkt["format"]):
+            continue
+        values = struct.unpack_from(pkt["format"], data, start)
+        if all(f["value"] == v for f, v in zip(_fixed(pkt), values) if "value" in f):
+            return pkt, values
+    return seen, None
+
+
+def decode(data, raw=False):
+    """Return (name, {field: value}); raises ValueError for unknown or short packets."""
+    data = bytes(data)
+    pkt, values = _match(data)
+    if pkt is None:
+        raise ValueError("unknown packet header %s" % data[:2].hex())
+    if values is None:
+        raise ValueError("%s packet too short: %d bytes" % (pkt["name"], len(data)))
+
+    # Trailing bytes are fields appended after this decoder was generated,
+    # unless the layout ends in a variable tail
+    result = {}
+    for field, value in zip(_fixed(pkt), values):
+        if not raw and ("scale" in field or "offset" in field):
+            value = (value + field.get("offset", 0)) * field.get("scale", 1)
+        elif not raw and "bits" in field:
+            value = {bit: bool(value & (1 << i)) for i, bit in enumerate(field["bits"])}
+        result[field["name"]] = value
+
+    tail = _tail(pkt)
+    if tail is not None:
+        start = len(pkt["header"]) + struct.calcsize(pkt["format"])
+        result[tail["name"]] = data[start:start + tail["max"]]
+
+    return pkt["name"], result
+
+
+def encode(name, **fields):
+    """Build a packet from raw field values (simulators and tests)."""
+    pkt = _lookup_name(name)
+    values = [fields.get(f["name"], f.get("value")) for f in _fixed(pkt)]
+    data = pkt["header"] + struct.pack(pkt["format"], *values)
+    tail = _tail(pkt)
+    if tail is not None:
+        data += bytes(fields.get(tail["name"], b""))[:tail["max"]]
+    return data
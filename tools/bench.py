@@ -0,0 +1,460 @@
+#!/usr/bin/env python3
+"""
+Trace and operation benchmarks, checked against a committed baseline.
+
+Runs test/bench.c (built by test/Makefile) over every trace: the synthetic
+ones from tools/tracegen.py, written to <build>/traces, and any recorded
+session in test/traces/*.csv. For each trace it reports
+
+    precision, recall           counted jumps against the ground truth lines,
+                                matched one to one by landing time
+    height_mae, height_err_max  cm, matched jumps only
+    jump_packet_missing         counted jumps without a jump notification
+    steps_err                   |total_steps of the last gait summary - truth|
+    reps_err                    summed |reps - truth| over the exercise sets
+    pressure_err_max            read_sensors() against the ideal CIC + table
+    fall_recall                 medical traces: confirmed fall alerts matched to the
+                                fall lines by impact time
+    fall_false_per_h            confirmed alerts without a fall, per hour
+    fall_suspect_per_h          suspected alerts without a fall (later cancelled)
+    fall_latency_max            ms from the impact sample to the alert's link confirm;
+                                the fake link confirms within the sample, so this is
+                                the queueing on the band, not the connection event wait
+    ns_per_sample               host time, fastest pass (this machine only)
+    insns, cycles, cycles_max   per sample, Cortex-M0+ cost model
+    <section>_cycles            per call, from user_profile.c on the cost model
+
+and runs test/bench_ops.c, single operations outside the sampling loop
+(TLV control frames, pressure chain, ...), listed under the operation's name:
+
+    insns, cycles, cycles_max   per call, Cortex-M0+ cost model
+    ns_per_op                   host time, fastest pass
+    err_rms_pa                  pressure ops: rms error against the true load, Pa
+    reps_err                    reps ops: |reps counted - reps performed|
+
+Cost model: the cost build calls __sanitizer_cov_trace_pc() at every basic
+block. This script disassembles it and gives each block the estimated
+Cortex-M0+ instructions and cycles of its x86 instructions (table below:
+soft-float calls, software divide, literal pool loads for globals). It is a
+nominal estimate for catching regressions, not a cycle-accurate simulator;
+check absolute numbers with the on-target profiler (CFG_PROFILE_HOT_PATHS).
+
+A run fails when accuracy gets worse than the baseline, a cost grows by more
+than COST_TOLERANCE, or host time by more than NS_TOLERANCE times (it is
+measured on whatever machine runs the check).
+
+Usage (from test/, see the Makefile):
+    python ../tools/bench.py --build build --baseline baseline/bench.txt
+    python ../tools/bench.py --build build --baseline baseline/bench.txt --update
+"""
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(TOOLS)
+sys.path.insert(0, TOOLS)
+
+import ankleband_packets as pk  # noqa: E402
+import tracegen  # noqa: E402
+
+MATCH_WINDOW_MS = 150       # Landing time tolerance for a detection to count
+COST_TOLERANCE = 0.05       # Relative growth allowed in modeled cost
+NS_TOLERANCE = 3.0          # Host time may vary this much between machines
+JUMP_HANDLE = 5             # CUSTS1_IDX_JUMP_METRICS_VAL
+FALL_ALERT_SUSPECTED = 1
+FALL_ALERT_CONFIRMED = 2
+
+# Metrics that must not go down; every other accuracy metric must not go up
+HIGHER_IS_BETTER = {"precision", "recall", "fall_recall"}
+COST_METRICS = re.compile(r"^(insns|cycles|cycles_max|\w+_cycles)$")
+
+TRACE_CALL = "__sanitizer_cov_trace_pc"
+FUNC = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+INSN = re.compile(r"^\s*([0-9a-f]+):\s+(\S+)\s*(.*)$")
+
+# (insns, cycles) on the M0+ for one x86 instruction
+FREE = {"nop", "nopl", "nopw", "xchg", "endbr64", "data16", "cs", "cltd", "cltq", "cqto"}
+BRANCH = (1, 2)
+CALL = (1, 3)
+RET = (1, 3)
+LOAD_STORE = (1, 2)
+ALU = (1, 1)
+ALU_MEM = (2, 3)            # ldr + op
+ALU_RMW = (3, 5)            # ldr + op + str
+LITERAL = (1, 2)            # ldr of a global's address from the literal pool
+SELECT = (2, 3)             # cmov/setcc become a branch and a move
+DIVIDE = (40, 70)           # __aeabi_idiv / __aeabi_uidiv
+MUL64 = (4, 8)
+BLOCK_FILL = (30, 40)       # memcpy / memset / rep stos of a small struct
+
+# Soft-float library calls (libgcc on Cortex-M0+)
+SOFT_FLOAT = {
+    "addss": (40, 60), "subss": (40, 60),
+    "mulss": (35, 55),
+    "divss": (80, 150),
+    "sqrtss": (200, 450),
+    "comiss": (15, 25), "ucomiss": (15, 25), "maxss": (15, 25), "minss": (15, 25),
+    "cvtsi2ss": (20, 30), "cvttss2si": (20, 30), "cvtsi2sd": (20, 30), "cvttsd2si": (20, 30),
+    "cvtss2sd": (15, 25), "cvtsd2ss": (15, 25),
+    "addsd": (64, 96), "subsd": (64, 96), "mulsd": (56, 88), "divsd": (128, 240),
+    "sqrtsd": (320, 720), "comisd": (24, 40), "ucomisd": (24, 40),
+    # Two lanes of what gcc vectorized on the host
+    "addps": (80, 120), "subps": (80, 120), "mulps": (70, 110), "divps": (160, 300),
+}
+LIBRARY_CALLS = {
+    "sqrtf": SOFT_FLOAT["sqrtss"], "sqrt": SOFT_FLOAT["sqrtsd"],
+    "memcpy": BLOCK_FILL, "memset": BLOCK_FILL, "memmove": BLOCK_FILL,
+}
+# Console output is not part of the sampling loop's cost
+IGNORED_CALLS = {"printf", "puts", "putchar", "fprintf", "vprintf", "fputs", "fwrite"}
+
+MOVES = {"mov", "movl", "movb", "movw", "movq", "movabs", "movzbl", "movzwl", "movzbw",
+         "movsbl", "movswl", "movsbw", "movsbq", "movswq", "movslq", "movzbq", "movzwq",
+         "movss", "movsd", "movd", "movaps", "movups", "movdqa", "movdqu", "movlps",
+         "movhps", "movapd", "lea"}
+WIDE_ALU = {"add", "sub", "and", "or", "xor", "shl", "shr", "sar", "cmp", "neg", "adc", "sbb"}
+REG64 = re.compile(r"%r(?:[abcd]x|si|di|8|9|1[0-5])(?![dwb\w])")
+
+
+def insn_cost(mnemonic, operands):
+    """Estimated (insns, cycles) of one x86 instruction on the M0+."""
+    base = mnemonic.split(".")[0]
+    memory = "(" in operands
+    literal = LITERAL if "(%rip)" in operands else (0, 0)
+
+    def plus(cost):
+        return (cost[0] + literal[0], cost[1] + literal[1])
+
+    if base in ("rep", "repz") and operands.startswith("ret"):
+        return RET
+    if base == "rep" and operands.startswith(("stos", "movs")):
+        return BLOCK_FILL
+    if base in FREE:
+        return (0, 0)
+    if base in SOFT_FLOAT:
+        return plus(SOFT_FLOAT[base])
+    if base in ("ret", "retq"):
+        return RET
+    if base in ("push", "pop"):
+        return ALU
+    if base.startswith("j"):
+        return BRANCH if "*" not in operands else (2, 4)
+    if base in ("idiv", "div"):
+        return DIVIDE
+    if base in ("imul", "mul") and REG64.search(operands):
+        return plus(MUL64)
+    if base.startswith("cmov") or base.startswith("set"):
+        return plus(SELECT)
+    if base in MOVES or base in ("pxor", "xorps", "andps", "andnps", "orps", "unpcklps",
+                                 "punpckldq", "shufps", "pshufd", "cvtps2pd"):
+        return plus(LOAD_STORE if memory else ALU)
+
+    if memory:
+        dest = operands.rsplit(",", 1)[-1]
+        cost = ALU_RMW if "(" in dest and base not in ("cmp", "test") else ALU_MEM
+    else:
+        cost = ALU
+    alu = base if base in WIDE_ALU else base[:-1]
+    if alu in WIDE_ALU and REG64.search(operands) and "%rsp" not in operands:
+        cost = (cost[0] * 2, cost[1] * 2)
+    return plus(cost)
+
+
+def call_cost(target):
+    """Cost of calling a function; instrumented callees count their own blocks."""
+    name = target.split("@")[0]
+    if name in IGNORED_CALLS:
+        return (0, 0)
+    if name in LIBRARY_CALLS:
+        extra = LIBRARY_CALLS[name]
+        return (CALL[0] + extra[0], CALL[1] + extra[1])
+    return CALL
+
+
+def block_table(binary, out_path):
+    """Write "address insns cycles" for every instrumented block of binary."""
+    dump = subprocess.run(["objdump", "-d", "--no-show-raw-insn", binary],
+                          check=True, capture_output=True, text=True).stdout
+
+    functions = []
+    for line in dump.splitlines():
+        m = FUNC.match(line)
+        if m:
+            functions.append([])
+            continue
+        m = INSN.match(line)
+        if m and functions:
+            functions[-1].append((int(m.group(1), 16), m.group(2), m.group(3)))
+
+    blocks = []
+    for insns in functions:
+        calls = [i for i, (_a, op, args) in enumerate(insns) if op == "call" and TRACE_CALL in args]
+        if not calls:
+            continue
+
+        for n, at in enumerate(calls):
+            # A block runs to the next hook, or an unconditional branch or return.
+            # Instructions skipped by a conditional branch are counted anyway.
+            start = 0 if n == 0 else at + 1
+            total = [0, 0]
+            for addr, op, args in insns[start:]:
+                if op == "call" and TRACE_CALL in args:
+                    if addr > insns[at][0]:
+                        break
+                    continue
+                if op == "call":
+                    target = re.search(r"<([^>+]+)", args)
+                    cost = call_cost(target.group(1)) if target else (2, 4)
+                elif op == "jmp" and re.search(r"<([^>+]+)>", args):
+                    cost = BRANCH       # tail call
+                else:
+                    cost = insn_cost(op, args)
+                total[0] += cost[0]
+                total[1] += cost[1]
+                if addr > insns[at][0] and (op in ("jmp", "ret", "retq") or op.startswith("ud2")):
+                    break
+            return_addr = insns[at + 1][0] if at + 1 < len(insns) else insns[at][0] + 5
+            blocks.append((return_addr, total[0], total[1]))
+
+    with open(out_path, "w") as f:
+        for addr, insns_n, cycles in blocks:
+            f.write("%x %d %d\n" % (addr, insns_n, cycles))
+    return len(blocks)
+
+
+def read_truth(path):
+    truth = {"jumps": [], "falls": [], "steps": None, "sets": [], "mode": "gymnastics"}
+    with open(path) as f:
+        for line in f:
+            if not line.startswith("#"):
+                continue
+            key, _, value = line[1:].strip().partition(": ")
+            if key == "jump":
+                takeoff, landing, height = value.split()
+                truth["jumps"].append((int(takeoff), int(landing), float(height)))
+            elif key == "fall":
+                truth["falls"].append(int(value))
+            elif key == "steps":
+                truth["steps"] = int(value)
+            elif key == "set":
+                truth["sets"].append(int(value.split()[1]))
+            elif key == "mode":
+                truth["mode"] = value
+    return truth
+
+
+def run(binary, trace, extra=()):
+    args = [binary] + ([trace] if trace else []) + list(extra)
+    out = subprocess.run(args, check=True,
+                         capture_output=True, text=True, timeout=600).stdout
+    return [line.split() for line in out.splitlines() if line.strip()]
+
+
+def accuracy(lines, truth):
+    """Detections and notifications of one run against the trace's truth."""
+    metrics = {}
+    jumps = [(int(l[1]), int(l[2]), float(l[3])) for l in lines if l[0] == "jump"]
+    packets = {"jump": 0, "gait": [], "reps": []}
+    for l in lines:
+        if l[0] != "ntf" or len(l) < 3:
+            continue
+        try:
+            name, fields = pk.decode(bytes.fromhex(l[2]))
+        except ValueError:
+            continue
+        if name == "jump" and int(l[1]) == JUMP_HANDLE:
+            packets["jump"] += 1
+        elif name in ("gait", "reps"):
+            packets[name].append(fields)
+
+    if truth["jumps"] or truth["mode"] == "gymnastics":
+        # Greedy one to one match in time order
+        unmatched = list(truth["jumps"])
+        errors = []
+        for _takeoff, landing, height in jumps:
+            best = None
+            for t in unmatched:
+                if abs(t[1] - landing) <= MATCH_WINDOW_MS and (best is None or abs(t[1] - landing) < abs(best[1] - landing)):
+                    best = t
+            if best is not None:
+                unmatched.remove(best)
+                errors.append(abs(height - best[2]))
+        metrics["precision"] = len(errors) / len(jumps) if jumps else 1.0
+        metrics["recall"] = len(errors) / len(truth["jumps"]) if truth["jumps"] else 1.0
+        metrics["height_mae"] = sum(errors) / len(errors) if errors else 0.0
+        metrics["height_err_max"] = max(errors) if errors else 0.0
+        metrics["jump_packet_missing"] = max(0, len(jumps) - packets["jump"])
+
+    if truth["mode"] == "medical":
+        samples = next(int(l[1]) for l in lines if l[0] == "samples")
+        hours = samples * tracegen.DT_MS / 3600000.0
+        alerts = {}
+        for l in lines:
+            if l[0] == "alert":
+                alerts.setdefault(int(l[1]), set()).add(int(l[2]))
+
+        def unmatched(impacts):
+            left = list(truth["falls"])
+            extra = 0
+            for impact in sorted(impacts):
+                hit = [t for t in left if abs(t - impact) <= MATCH_WINDOW_MS]
+                if hit:
+                    left.remove(hit[0])
+                else:
+                    extra += 1
+            return extra, len(truth["falls"]) - len(left)
+
+        false_confirmed, found = unmatched(alerts.get(FALL_ALERT_CONFIRMED, set()))
+        false_suspected, _found = unmatched(alerts.get(FALL_ALERT_SUSPECTED, set()))
+        if truth["falls"]:
+            metrics["fall_recall"] = found / len(truth["falls"])
+        metrics["fall_false_per_h"] = false_confirmed / hours
+        metrics["fall_suspect_per_h"] = false_suspected / hours
+
+    if truth["steps"] is not None:
+        counted = packets["gait"][-1]["total_steps"] if packets["gait"] else 0
+        metrics["steps_err"] = abs(counted - truth["steps"])
+
+    if truth["sets"]:
+        counted = [s["reps"] for s in packets["reps"]]
+        err = sum(abs(c - t) for c, t in zip(counted, truth["sets"]))
+        err += sum(counted[len(truth["sets"]):]) + sum(truth["sets"][len(counted):])
+        metrics["reps_err"] = err
+
+    return metrics
+
+
+def measure(build, trace, blocks):
+    truth = read_truth(trace)
+    lines = run(os.path.join(build, "bench"), trace)
+    metrics = accuracy(lines, truth)
+    for l in lines:
+        if l[0] in ("pressure_err_max", "ns_per_sample", "fall_latency_max"):
+            metrics[l[0]] = float(l[1])
+
+    for l in run(os.path.join(build, "bench_cost"), trace, [blocks]):
+        if l[0] == "cost_sample":
+            metrics["insns"] = float(l[1])
+            metrics["cycles"] = float(l[2])
+            metrics["cycles_max"] = float(l[3])
+        elif l[0] == "cost_unknown" and int(l[1]) != 0:
+            raise RuntimeError("%s: %s blocks missing from the cost table" % (trace, l[1]))
+        elif l[0] == "cost_section":
+            name, avg, budget = l[1], float(l[3]), int(l[5])
+            metrics[name + "_cycles"] = avg
+            if avg > budget:
+                print("  note: %s averages %.0f modeled cycles, budget %d" % (name, avg, budget))
+    return metrics
+
+
+def measure_ops(build):
+    """Per operation metrics of bench_ops, keyed by operation name."""
+    blocks = os.path.join(build, "bench_ops_cost.blocks")
+    block_table(os.path.join(build, "bench_ops_cost"), blocks)
+
+    ops = {}
+    for l in run(os.path.join(build, "bench_ops_cost"), blocks) + run(os.path.join(build, "bench_ops"), None):
+        if l[0] == "cost_unknown":
+            if int(l[1]) != 0:
+                raise RuntimeError("bench_ops: %s blocks missing from the cost table" % l[1])
+            continue
+        ops.setdefault(l[0], {})[l[1]] = float(l[2])
+    return ops
+
+
+def read_baseline(path):
+    baseline = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                if line.strip() and not line.startswith("#"):
+                    trace, metric, value = line.split()
+                    baseline[(trace, metric)] = float(value)
+    return baseline
+
+
+def regressed(metric, value, base):
+    if metric.startswith("ns_per_"):
+        return value > base * NS_TOLERANCE
+    if COST_METRICS.match(metric):
+        return value > base * (1.0 + COST_TOLERANCE)
+    if metric in HIGHER_IS_BETTER:
+        return value < base - 1e-6
+    return value > base + 1e-6
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Trace and operation benchmarks against a baseline")
+    parser.add_argument("--build", required=True, help="test build directory (bench, bench_ops and their cost builds)")
+    parser.add_argument("--baseline", required=True, help="baseline file")
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    args = parser.parse_args()
+
+    trace_dir = os.path.join(args.build, "traces")
+    os.makedirs(trace_dir, exist_ok=True)
+    for make in tracegen.TRACES:
+        tr = make()
+        tr.write(os.path.join(trace_dir, tr.name + ".csv"))
+    traces = sorted(glob.glob(os.path.join(trace_dir, "*.csv")))
+    traces += sorted(glob.glob(os.path.join(ROOT, "test", "traces", "*.csv")))
+
+    blocks = os.path.join(args.build, "bench_cost.blocks")
+    count = block_table(os.path.join(args.build, "bench_cost"), blocks)
+    print("cost model: %d blocks" % count)
+
+    results = []
+    for trace in traces:
+        name = os.path.splitext(os.path.basename(trace))[0]
+        print("%s" % name)
+        for metric, value in measure(args.build, trace, blocks).items():
+            # Same precision as the baseline file
+            results.append((name, metric, float("%.4g" % value)))
+
+    for name, metrics in sorted(measure_ops(args.build).items()):
+        print("%s" % name)
+        for metric, value in metrics.items():
+            results.append((name, metric, float("%.4g" % value)))
+
+    if args.update:
+        with open(args.baseline, "w") as f:
+            f.write("# tools/bench.py results: <trace> <metric> <value>\n")
+            f.write("# Regenerate with: make -C test bench-update\n")
+            for name, metric, value in results:
+                f.write("%s %s %.4g\n" % (name, metric, value))
+        print("baseline written: %s" % args.baseline)
+        return 0
+
+    baseline = read_baseline(args.baseline)
+    failures = 0
+    seen = set()
+    print("%-20s %-22s %12s %12s" % ("trace", "metric", "value", "baseline"))
+    for name, metric, value in results:
+        base = baseline.get((name, metric))
+        seen.add((name, metric))
+        status = ""
+        if base is None:
+            status = "new"
+        elif regressed(metric, value, base):
+            status = "REGRESSED"
+            failures += 1
+        print("%-20s %-22s %12.4g %12s %s" % (name, metric, value,
+                                              "-" if base is None else "%.4g" % base, status))
+
+    for key in sorted(set(baseline) - seen):
+        print("%-20s %-22s %12s %12.4g MISSING" % (key[0], key[1], "-", baseline[key]))
+        failures += 1
+
+    if failures:
+        print("%d metric(s) regressed against %s" % (failures, args.baseline))
+        return 1
+    print("no regressions against %s" % args.baseline)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
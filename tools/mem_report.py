@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Per-file RAM/flash report from a Keil (armlink) map file.
+
+Reads the "Image component sizes" table that armlink writes with
+--info=sizes (on by default in uVision map files) and prints, for every
+object file of this project:
+
+    flash = Code + RO Data + RW Data   (RW initial values live in flash)
+    ram   = RW Data + ZI Data
+
+SDK objects and libraries are summed into one "SDK + libraries" line.
+
+Usage:
+    python tools/mem_report.py Objects/AnkleBandV2.map
+    python tools/mem_report.py Objects/AnkleBandV2.map --ram-budget 49152
+"""
+
+import argparse
+import re
+import sys
+
+ROW = re.compile(r"^\s*(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\S+)\s*$")
+
+# Project sources: main.c and the user_*.c modules
+PROJECT = re.compile(r"^(main|user_\w+)\.o$")
+
+
+def parse_sizes(path):
+    """Return {object: (code, ro, rw, zi)} from the component size tables."""
+    objects = {}
+    in_table = False
+
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            if "Object Name" in line or "Library Member Name" in line:
+                in_table = True
+                continue
+            if "Totals" in line:
+                in_table = False
+                continue
+            if not in_table:
+                continue
+
+            m = ROW.match(line)
+            if m:
+                code, _inc, ro, rw, zi, _debug = (int(v) for v in m.groups()[:6])
+                name = m.group(7)
+                prev = objects.get(name, (0, 0, 0, 0))
+                objects[name] = (prev[0] + code, prev[1] + ro, prev[2] + rw, prev[3] + zi)
+
+    return objects
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-file RAM/flash use from a Keil map file")
+    parser.add_argument("map", help="armlink .map file")
+    parser.add_argument("--ram-budget", type=int, default=0, help="warn when total RAM exceeds this (bytes)")
+    parser.add_argument("--flash-budget", type=int, default=0, help="warn when total flash exceeds this (bytes)")
+    args = parser.parse_args()
+
+    objects = parse_sizes(args.map)
+    if not objects:
+        print("No 'Image component sizes' table found in %s" % args.map, file=sys.stderr)
+        return 1
+
+    rows = []
+    other = [0, 0]
+    for name, (code, ro, rw, zi) in objects.items():
+        flash = code + ro + rw
+        ram = rw + zi
+        if PROJECT.match(name):
+            rows.append((name, code, ro, rw, zi, flash, ram))
+        else:
+            other[0] += flash
+            other[1] += ram
+
+    rows.sort(key=lambda r: (r[6], r[5]), reverse=True)
+
+    print("%-24s %7s %7s %7s %7s %8s %7s" % ("File", "Code", "RO", "RW", "ZI", "Flash", "RAM"))
+    print("-" * 72)
+    for name, code, ro, rw, zi, flash, ram in rows:
+        print("%-24s %7d %7d %7d %7d %8d %7d" % (name[:-2] + ".c", code, ro, rw, zi, flash, ram))
+    print("%-24s %7s %7s %7s %7s %8d %7d" % ("SDK + libraries", "", "", "", "", other[0], other[1]))
+    print("-" * 72)
+
+    total_flash = sum(r[5] for r in rows) + other[0]
+    total_ram = sum(r[6] for r in rows) + other[1]
+    print("%-24s %7s %7s %7s %7s %8d %7d" % ("Total", "", "", "", "", total_flash, total_ram))
+
+    status = 0
+    if args.ram_budget and total_ram > args.ram_budget:
+        print("RAM OVER BUDGET: %d > %d bytes" % (total_ram, args.ram_budget))
+        status = 2
+    if args.flash_budget and total_flash > args.flash_budget:
+        print("FLASH OVER BUDGET: %d > %d bytes" % (total_flash, args.flash_budget))
+        status = 2
+
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
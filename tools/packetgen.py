@@ -0,0 +1,535 @@
+#!/usr/bin/env python3
+"""
+Generate the notification packet code from tools/packets.json.
+
+One schema drives every side of the link:
+
+    user_packets.h / user_packets.c   firmware packers (write straight into
+                                      the notification message, no copy)
+    tools/ankleband_packets.py        host decoder/encoder library
+    README.md                         packet formats between the
+                                      <!-- packets:begin/end --> markers
+
+Every multi-byte field is little-endian. Layout changes that break old
+decoders bump "version" in the schema; the firmware reports it in
+register 0x03.
+
+Besides the integer types a field can be:
+
+    "value": n          fixed on the wire, written by the packer and used by
+                        the decoder to tell packets with one header apart
+    "type": "bytes"     variable tail of at most "max" bytes, last field only
+
+"transport" picks how the packet leaves: "notify" (default), "alert" (every
+central, ahead of the TX credits) or "ota" (the OTA control characteristic
+of one connection). Every transport is packed straight into the
+notification message.
+
+Usage:
+    python tools/packetgen.py            rewrite the generated files
+    python tools/packetgen.py --check    exit 1 if any of them is stale
+"""
+
+import argparse
+import json
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCHEMA = os.path.join(ROOT, "tools", "packets.json")
+
+TYPES = {
+    # type: (size, signed, C type, struct code)
+    "u8": (1, False, "uint8_t", "B"),
+    "i8": (1, True, "int8_t", "b"),
+    "u16": (2, False, "uint16_t", "H"),
+    "i16": (2, True, "int16_t", "h"),
+    "u32": (4, False, "uint32_t", "I"),
+    "i32": (4, True, "int32_t", "i"),
+}
+
+TRANSPORTS = {
+    # transport: (return type, target parameter, alloc call, failed return, doc)
+    "alert": ("uint8_t", "", "user_custs1_alert_alloc(%s)", "return 0;",
+              "Number of connections the packet was queued for"),
+    "ota": ("void", "uint8_t conidx, ", "user_custs1_ota_alloc(conidx, %s)", "return;", None),
+}
+
+GENERATED = "Generated by tools/packetgen.py from tools/packets.json - do not edit"
+
+
+def load_schema(path):
+    """Read the schema and check it is usable."""
+    with open(path, "r") as f:
+        schema = json.load(f)
+
+    names = set()
+    for pkt in schema["packets"]:
+        if pkt["name"] in names:
+            raise ValueError("duplicate packet %s" % pkt["name"])
+        names.add(pkt["name"])
+        for name in pkt["header"]:
+            if name not in schema["constants"]:
+                raise ValueError("%s: unknown header constant %s" % (pkt["name"], name))
+        if pkt.get("transport", "notify") not in ("notify",) + tuple(TRANSPORTS):
+            raise ValueError("%s: unknown transport %s" % (pkt["name"], pkt["transport"]))
+        for i, field in enumerate(pkt["fields"]):
+            if field["type"] == "bytes":
+                if i != len(pkt["fields"]) - 1 or "max" not in field:
+                    raise ValueError("%s.%s: bytes must be the last field and have a max" % (pkt["name"], field["name"]))
+            elif field["type"] not in TYPES:
+                raise ValueError("%s.%s: unknown type %s" % (pkt["name"], field["name"], field["type"]))
+
+    return schema
+
+
+def header_len(pkt):
+    return len(pkt["header"])
+
+
+def fixed_fields(pkt):
+    return [f for f in pkt["fields"] if f["type"] != "bytes"]
+
+
+def tail_field(pkt):
+    """The variable-length bytes field, or None."""
+    last = pkt["fields"][-1] if pkt["fields"] else None
+    return last if last is not None and last["type"] == "bytes" else None
+
+
+def body_len(pkt):
+    """Longest body: fixed fields plus a full tail."""
+    tail = tail_field(pkt)
+    return sum(TYPES[f["type"]][0] for f in fixed_fields(pkt)) + (tail["max"] if tail else 0)
+
+
+def len_expr(pkt, what):
+    """C expression for the packed length of pkt, what is "LEN" or "BODY_LEN"."""
+    tail = tail_field(pkt)
+    if tail is None:
+        return "PKT_%s_%s" % (upper(pkt), what)
+    return "PKT_%s_%s - PKT_%s_%s_MAX + pkt->%s_len" % (upper(pkt), what, upper(pkt), tail["name"].upper(),
+                                                       tail["name"])
+
+
+def upper(pkt):
+    return pkt["name"].upper()
+
+
+# ---------------------------------------------------------------------------
+# Firmware
+# ---------------------------------------------------------------------------
+
+def gen_c_header(schema):
+    out = []
+    out.append("/**")
+    out.append(" * @file user_packets.h")
+    out.append(" * @brief Notification packet packers")
+    out.append(" * @author Muhammad Umer Sajid, Student")
+    out.append(" *")
+    out.append(" * %s" % GENERATED)
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef USER_PACKETS_H_")
+    out.append("#define USER_PACKETS_H_")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("#include <stdbool.h>")
+    out.append("")
+    out.append("// Bumped on every layout change that breaks old decoders (register 0x03)")
+    out.append("#define PACKET_SCHEMA_VERSION           %d" % schema["version"])
+    out.append("")
+
+    for pkt in schema["packets"]:
+        out.append("// %s: %s" % (pkt["title"], pkt["doc"]))
+        out.append("#define PKT_%s_LEN%s%d" % (upper(pkt), " " * max(1, 24 - len(upper(pkt))),
+                                              header_len(pkt) + body_len(pkt)))
+        out.append("#define PKT_%s_BODY_LEN%s%d" % (upper(pkt), " " * max(1, 19 - len(upper(pkt))),
+                                                   body_len(pkt)))
+        tail = tail_field(pkt)
+        if tail is not None:
+            macro = "PKT_%s_%s_MAX" % (upper(pkt), tail["name"].upper())
+            out.append("#define %s%s%d" % (macro, " " * max(1, 32 - len(macro)), tail["max"]))
+        out.append("")
+        out.append("typedef struct {")
+        for field in pkt["fields"]:
+            if "value" in field:
+                continue
+            if field["type"] == "bytes":
+                out.append("%-36s// At most %d" % ("    const uint8_t *%s;" % field["name"], field["max"]))
+                out.append("    uint8_t %s_len;" % field["name"])
+                continue
+            comment = field.get("unit", "")
+            if "scale" in field or "offset" in field:
+                comment = "x %g %s" % (field.get("scale", 1), field.get("unit", ""))
+                if field.get("offset"):
+                    comment = "(raw %+d) " % field["offset"] + comment
+            if "bits" in field:
+                comment = ", ".join("bit %d %s" % (i, b) for i, b in enumerate(field["bits"]))
+            decl = "    %s %s;" % (TYPES[field["type"]][2], field["name"])
+            out.append(("%-36s// %s" % (decl, comment.strip())) if comment else decl)
+        out.append("} pkt_%s_t;" % pkt["name"])
+        out.append("")
+
+    out.append("// Function Prototypes")
+    for pkt in schema["packets"]:
+        out.append("uint8_t user_pkt_%s_put(uint8_t *buf, const pkt_%s_t *pkt);" % (pkt["name"], pkt["name"]))
+        out.append("%s;" % send_signature(pkt))
+    out.append("")
+    out.append("#endif // USER_PACKETS_H_")
+    return "\n".join(out) + "\n"
+
+
+def send_signature(pkt):
+    transport = pkt.get("transport", "notify")
+    if transport == "notify":
+        return "bool user_pkt_%s_send(uint8_t target, const pkt_%s_t *pkt)" % (pkt["name"], pkt["name"])
+    ret, target, _alloc, _fail, _doc = TRANSPORTS[transport]
+    return "%s user_pkt_%s_send(%sconst pkt_%s_t *pkt)" % (ret, pkt["name"], target, pkt["name"])
+
+
+def gen_c_put(field, offset):
+    """Byte stores for one field at buf[offset]."""
+    if field["type"] == "bytes":
+        return ["    memcpy(&buf[%d], pkt->%s, pkt->%s_len);" % (offset, field["name"], field["name"])]
+
+    size, signed, _ctype, _code = TYPES[field["type"]]
+    value = "pkt->%s" % field["name"]
+    if "value" in field:
+        if size == 1:
+            return ["    buf[%d] = 0x%02X;" % (offset, field["value"] & 0xFF)]
+        return ["    buf[%d] = 0x%02X;" % (offset + i, (field["value"] >> (8 * i)) & 0xFF) for i in range(size)]
+    if signed:
+        value = "(uint%d_t)%s" % (size * 8, value)
+
+    if size == 1 and not signed:
+        return ["    buf[%d] = %s;" % (offset, value)]
+
+    lines = []
+    for i in range(size):
+        shift = " >> %d" % (8 * i) if i else ""
+        lines.append("    buf[%d] = (uint8_t)(%s%s);" % (offset + i, value, shift))
+    return lines
+
+
+def gen_c_source(schema):
+    consts = schema["constants"]
+    out = []
+    out.append("/**")
+    out.append(" * @file user_packets.c")
+    out.append(" * @brief Notification packet packers")
+    out.append(" * @author Muhammad Umer Sajid, Student")
+    out.append(" *")
+    out.append(" * %s" % GENERATED)
+    out.append(" */")
+    out.append("")
+    out.append("#include <stddef.h>")
+    out.append("#include <string.h>")
+    out.append("#include \"user_packets.h\"")
+    out.append("#include \"user_custs1_def.h\"")
+    out.append("#include \"user_custs1_impl.h\"")
+    for name in schema.get("includes", []):
+        out.append("#include \"%s\"" % name)
+    out.append("")
+    out.append("// The schema must agree with the service definitions")
+    for name in sorted(consts):
+        out.append("#if %s != 0x%02X" % (name, consts[name]))
+        out.append("#error \"%s does not match tools/packets.json\"" % name)
+        out.append("#endif")
+    out.append("")
+
+    for pkt in schema["packets"]:
+        name = pkt["name"]
+        out.append("/**")
+        out.append(" * @brief Write the %s body (no header)" % pkt["title"])
+        out.append(" * @return %s" % len_expr(pkt, "BODY_LEN").replace("pkt->", ""))
+        out.append(" */")
+        out.append("uint8_t user_pkt_%s_put(uint8_t *buf, const pkt_%s_t *pkt) {" % (name, name))
+        offset = 0
+        for field in pkt["fields"]:
+            out.extend(gen_c_put(field, offset))
+            if field["type"] != "bytes":
+                offset += TYPES[field["type"]][0]
+        out.append("")
+        out.append("    return %s;" % len_expr(pkt, "BODY_LEN"))
+        out.append("}")
+        out.append("")
+        out.append("/**")
+        transport = pkt.get("transport", "notify")
+        if transport == "notify":
+            out.append(" * @brief Pack and notify a %s packet" % pkt["title"])
+            out.append(" * @param target Connection index or CONIDX_ALL")
+            out.append(" * @return false when no connection took the packet")
+            out.append(" */")
+            out.append("%s {" % send_signature(pkt))
+            out.append("    uint8_t *buf = user_custs1_ntf_alloc(target, %s, %s);"
+                       % (pkt["characteristic"], len_expr(pkt, "LEN")))
+            out.append("")
+            out.append("    if (buf == NULL) {")
+            out.append("        return false;")
+            out.append("    }")
+            out.append("")
+            for i, hdr in enumerate(pkt["header"]):
+                out.append("    buf[%d] = %s;" % (i, hdr))
+            out.append("    user_pkt_%s_put(&buf[%d], pkt);" % (name, header_len(pkt)))
+            out.append("    user_custs1_ntf_commit();")
+            out.append("")
+            out.append("    return true;")
+        else:
+            _ret, target, alloc, fail, doc = TRANSPORTS[transport]
+            out.append(" * @brief Pack and send a %s packet" % pkt["title"])
+            if target:
+                out.append(" * @param conidx Connection index")
+            if doc:
+                out.append(" * @return %s" % doc)
+            out.append(" */")
+            out.append("%s {" % send_signature(pkt))
+            out.append("    uint8_t *buf = %s;" % (alloc % len_expr(pkt, "LEN")))
+            out.append("")
+            out.append("    if (buf == NULL) {")
+            out.append("        %s" % fail)
+            out.append("    }")
+            out.append("")
+            for i, hdr in enumerate(pkt["header"]):
+                out.append("    buf[%d] = %s;" % (i, hdr))
+            out.append("    user_pkt_%s_put(&buf[%d], pkt);" % (name, header_len(pkt)))
+            if doc:
+                out.append("")
+                out.append("    return user_custs1_ntf_commit();")
+            else:
+                out.append("    user_custs1_ntf_commit();")
+        out.append("}")
+        out.append("")
+
+    return "\n".join(out)
+
+
+# ---------------------------------------------------------------------------
+# Host
+# ---------------------------------------------------------------------------
+
+def gen_python(schema):
+    consts = schema["constants"]
+    packets = []
+    for pkt in schema["packets"]:
+        fields = []
+        for field in pkt["fields"]:
+            entry = {"name": field["name"], "type": field["type"]}
+            for key in ("value", "max", "offset", "scale", "unit", "bits"):
+                if key in field:
+                    entry[key] = field[key]
+            fields.append(entry)
+        packets.append({
+            "name": pkt["name"],
+            "header": bytes(consts[h] for h in pkt["header"]),
+            "format": "<" + "".join(TYPES[f["type"]][3] for f in fixed_fields(pkt)),
+            "fields": fields,
+        })
+
+    out = []
+    out.append('"""')
+    out.append("AnkleBand notification packet decoder/encoder.")
+    out.append("")
+    out.append(GENERATED + ".")
+    out.append("")
+    out.append("    import ankleband_packets as pk")
+    out.append("    name, fields = pk.decode(notification_bytes)")
+    out.append("")
+    out.append("decode() gives engineering units for scaled fields (g, kPa), ints for")
+    out.append("the rest and bytes for a variable tail; pass raw=True for the integers")
+    out.append("on the wire. Check register 0x03 against SCHEMA_VERSION when connecting.")
+    out.append('"""')
+    out.append("")
+    out.append("import struct")
+    out.append("")
+    out.append("SCHEMA_VERSION = %d" % schema["version"])
+    out.append("")
+    out.append("PACKETS = [")
+    for p in packets:
+        out.append("    {")
+        out.append("        \"name\": %s," % json.dumps(p["name"]))
+        out.append("        \"header\": %r," % p["header"])
+        out.append("        \"format\": %s," % json.dumps(p["format"]))
+        out.append("        \"fields\": [")
+        for f in p["fields"]:
+            out.append("            %s," % json.dumps(f))
+        out.append("        ],")
+        out.append("    },")
+    out.append("]")
+    out.append("")
+    out.append("")
+    out.append("def _lookup_name(name):")
+    out.append("    for pkt in PACKETS:")
+    out.append("        if pkt[\"name\"] == name:")
+    out.append("            return pkt")
+    out.append("    raise KeyError(name)")
+    out.append("")
+    out.append("")
+    out.append("def _fixed(pkt):")
+    out.append("    return [f for f in pkt[\"fields\"] if f[\"type\"] != \"bytes\"]")
+    out.append("")
+    out.append("")
+    out.append("def _tail(pkt):")
+    out.append("    last = pkt[\"fields\"][-1] if pkt[\"fields\"] else None")
+    out.append("    return last if last is not None and last[\"type\"] == \"bytes\" else None")
+    out.append("")
+    out.append("")
+    out.append("def _match(data):")
+    out.append("    \"\"\"Return (pkt, values) for the first layout that fits, or (header match, None).\"\"\"")
+    out.append("    # Longest header first (0xDD 0x05 before any bare 0xDD), then layouts with")
+    out.append("    # fixed values; a reply too short for its own layout falls back to a")
+    out.append("    # shorter one with the same header")
+    out.append("    order = sorted(PACKETS, key=lambda p: (-len(p[\"header\"]),")
+    out.append("                                           -sum(\"value\" in f for f in p[\"fields\"])))")
+    out.append("    seen = None")
+    out.append("    for pkt in order:")
+    out.append("        start = len(pkt[\"header\"])")
+    out.append("        if data[:start] != pkt[\"header\"]:")
+    out.append("            continue")
+    out.append("        seen = seen or pkt")
+    out.append("        if len(data) < start + struct.calcsize(pkt[\"format\"]):")
+    out.append("            continue")
+    out.append("        values = struct.unpack_from(pkt[\"format\"], data, start)")
+    out.append("        if all(f[\"value\"] == v for f, v in zip(_fixed(pkt), values) if \"value\" in f):")
+    out.append("            return pkt, values")
+    out.append("    return seen, None")
+    out.append("")
+    out.append("")
+    out.append("def decode(data, raw=False):")
+    out.append("    \"\"\"Return (name, {field: value}); raises ValueError for unknown or short packets.\"\"\"")
+    out.append("    data = bytes(data)")
+    out.append("    pkt, values = _match(data)")
+    out.append("    if pkt is None:")
+    out.append("        raise ValueError(\"unknown packet header %s\" % data[:2].hex())")
+    out.append("    if values is None:")
+    out.append("        raise ValueError(\"%s packet too short: %d bytes\" % (pkt[\"name\"], len(data)))")
+    out.append("")
+    out.append("    # Trailing bytes are fields appended after this decoder was generated,")
+    out.append("    # unless the layout ends in a variable tail")
+    out.append("    result = {}")
+    out.append("    for field, value in zip(_fixed(pkt), values):")
+    out.append("        if not raw and (\"scale\" in field or \"offset\" in field):")
+    out.append("            value = (value + field.get(\"offset\", 0)) * field.get(\"scale\", 1)")
+    out.append("        elif not raw and \"bits\" in field:")
+    out.append("            value = {bit: bool(value & (1 << i)) for i, bit in enumerate(field[\"bits\"])}")
+    out.append("        result[field[\"name\"]] = value")
+    out.append("")
+    out.append("    tail = _tail(pkt)")
+    out.append("    if tail is not None:")
+    out.append("        start = len(pkt[\"header\"]) + struct.calcsize(pkt[\"format\"])")
+    out.append("        result[tail[\"name\"]] = data[start:start + tail[\"max\"]]")
+    out.append("")
+    out.append("    return pkt[\"name\"], result")
+    out.append("")
+    out.append("")
+    out.append("def encode(name, **fields):")
+    out.append("    \"\"\"Build a packet from raw field values (simulators and tests).\"\"\"")
+    out.append("    pkt = _lookup_name(name)")
+    out.append("    values = [fields.get(f[\"name\"], f.get(\"value\")) for f in _fixed(pkt)]")
+    out.append("    data = pkt[\"header\"] + struct.pack(pkt[\"format\"], *values)")
+    out.append("    tail = _tail(pkt)")
+    out.append("    if tail is not None:")
+    out.append("        data += bytes(fields.get(tail[\"name\"], b\"\"))[:tail[\"max\"]]")
+    out.append("    return data")
+    out.append("")
+    return "\n".join(out)
+
+
+def gen_readme_block(schema):
+    consts = schema["constants"]
+    out = []
+    out.append("<!-- packets:begin (generated by tools/packetgen.py) -->")
+    for pkt in schema["packets"]:
+        hdr = "".join("[0x%02X]" % consts[h] for h in pkt["header"])
+        cells = []
+        for field in pkt["fields"]:
+            if field["type"] == "bytes":
+                cells.append("[%s, up to %d bytes]" % (field["label"], field["max"]))
+                continue
+            if "value" in field:
+                cells.append("[0x%02X]" % field["value"])
+                continue
+            size = TYPES[field["type"]][0]
+            if size == 1 and not TYPES[field["type"]][1]:
+                cells.append("[%s]" % field["label"])
+            else:
+                cells.append("[%s %s]" % (field["label"], field["type"]))
+        size = "%s%d bytes" % ("up to " if tail_field(pkt) else "", header_len(pkt) + body_len(pkt))
+        out.append("**%s Format** (%s, %s):" % (pkt["title"], pkt["doc"][0].lower() + pkt["doc"][1:], size))
+        out.append("```")
+        out.append(hdr + "".join(cells))
+        out.append("```")
+        notes = []
+        for field in pkt["fields"]:
+            if "scale" in field or "offset" in field:
+                expr = "raw"
+                if field.get("offset"):
+                    expr = "(raw %s %d)" % ("-" if field["offset"] < 0 else "+", abs(field["offset"]))
+                notes.append("%s = %s x %g %s" % (field["label"], expr, field.get("scale", 1),
+                                                  field.get("unit", "")))
+            elif "bits" in field:
+                notes.append("%s: %s" % (field["label"], ", ".join(
+                    "bit %d %s" % (i, b.replace("_", " ")) for i, b in enumerate(field["bits"]))))
+            elif "unit" in field:
+                notes.append("%s in %s" % (field["label"], field["unit"]))
+        if notes:
+            out.append("- " + "; ".join(n.strip() for n in notes))
+        out.append("")
+    out.append("All multi-byte fields are little-endian. Packet schema version %d (register `0x03`)."
+               % schema["version"])
+    out.append("<!-- packets:end -->")
+    return "\n".join(out)
+
+
+def splice_readme(text, block):
+    begin = text.find("<!-- packets:begin")
+    end = text.find("<!-- packets:end -->")
+    if begin < 0 or end < 0:
+        raise ValueError("README.md has no <!-- packets:begin/end --> markers")
+    end += len("<!-- packets:end -->")
+    return text[:begin] + block + text[end:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate packet packers/decoders from tools/packets.json")
+    parser.add_argument("--check", action="store_true", help="only verify the generated files are current")
+    args = parser.parse_args()
+
+    schema = load_schema(SCHEMA)
+
+    readme_path = os.path.join(ROOT, "README.md")
+    with open(readme_path, "r", encoding="utf-8") as f:
+        readme = f.read()
+
+    outputs = {
+        os.path.join(ROOT, "user_packets.h"): gen_c_header(schema),
+        os.path.join(ROOT, "user_packets.c"): gen_c_source(schema),
+        os.path.join(ROOT, "tools", "ankleband_packets.py"): gen_python(schema),
+        readme_path: splice_readme(readme, gen_readme_block(schema)),
+    }
+
+    stale = []
+    for path, text in outputs.items():
+        current = None
+        if os.path.exists(path):
+            with open(path, "r", encoding="utf-8") as f:
+                current = f.read()
+        if current == text:
+            continue
+        stale.append(os.path.relpath(path, ROOT))
+        if not args.check:
+            with open(path, "w", encoding="utf-8", newline="\n") as f:
+                f.write(text)
+
+    if args.check:
+        for path in stale:
+            print("stale: %s" % path)
+        return 1 if stale else 0
+
+    for path in stale:
+        print("wrote %s" % path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
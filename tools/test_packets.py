@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+Round-trip test for every packet in tools/packets.json.
+
+For each packet a set of random field values (edge values first) is packed
+by the generated firmware code, built for the host with test/stubs, and the
+bytes must equal ankleband_packets.encode() of the same values. decode() of
+those bytes must give the values back. The firmware side goes through the
+real user_pkt_*_send() functions, so headers, lengths and the transport
+(notify, alert, OTA control) are checked too.
+
+Usage:
+    python tools/test_packets.py         needs gcc on the PATH
+"""
+
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(TOOLS)
+sys.path.insert(0, TOOLS)
+
+import ankleband_packets as pk  # noqa: E402
+import packetgen  # noqa: E402
+
+CASES = 25
+
+HARNESS_HEAD = r"""
+#include <stdio.h>
+#include <string.h>
+#include "user_packets.h"
+#include "user_custs1_impl.h"
+
+const uint8_t att_decl_svc_128[16], att_decl_char_128[16], att_desc_client_char_cfg_128[16];
+
+static uint8_t out[256];
+static uint8_t out_len;
+static uint16_t out_handle;
+
+uint8_t *user_custs1_ntf_alloc(uint8_t target, uint16_t handle, uint8_t length) {
+    out_handle = handle;
+    out_len = length;
+    return out;
+}
+
+uint8_t *user_custs1_alert_alloc(uint8_t length) {
+    return user_custs1_ntf_alloc(CONIDX_ALL, CUSTS1_IDX_DEVICE_CONTROL_VAL, length);
+}
+
+uint8_t *user_custs1_ota_alloc(uint8_t conidx, uint8_t length) {
+    return user_custs1_ntf_alloc(conidx, CUSTS1_IDX_OTA_CONTROL_VAL, length);
+}
+
+uint8_t user_custs1_ntf_commit(void) {
+    return 1;
+}
+
+static void dump(const char *name) {
+    printf("%s %u ", name, out_handle);
+    for (uint8_t i = 0; i < out_len; i++) {
+        printf("%02x", out[i]);
+    }
+    printf("\n");
+}
+
+int main(void) {
+"""
+
+
+def field_range(field):
+    size, signed, _ctype, _code = packetgen.TYPES[field["type"]]
+    bits = 8 * size
+    if signed:
+        return -(1 << (bits - 1)), (1 << (bits - 1)) - 1
+    return 0, (1 << bits) - 1
+
+
+def reserved_values(schema, pkt):
+    """Values that mark another layout with the same header (capture chunk 0)."""
+    reserved = {}
+    for other in schema["packets"]:
+        if other is pkt or other["header"] != pkt["header"]:
+            continue
+        for field in other["fields"]:
+            if "value" in field:
+                reserved.setdefault(field["name"], set()).add(field["value"])
+    return reserved
+
+
+def make_cases(pkt, rng, reserved):
+    """Field values for CASES packets: all-min, all-max, then random."""
+    cases = []
+    for n in range(CASES):
+        values = {}
+        for field in pkt["fields"]:
+            if "value" in field:
+                continue
+            if field["type"] == "bytes":
+                length = (0, field["max"])[n] if n < 2 else rng.randint(0, field["max"])
+                values[field["name"]] = bytes(rng.randrange(256) for _ in range(length))
+                continue
+            lo, hi = field_range(field)
+            value = (lo, hi)[n] if n < 2 else rng.randint(lo, hi)
+            while value in reserved.get(field["name"], ()):
+                value = rng.randint(lo, hi)
+            values[field["name"]] = value
+        cases.append(values)
+    return cases
+
+
+def c_case(pkt, index, values):
+    """C statements that pack one case through the generated send function."""
+    lines = ["    {"]
+    for field in pkt["fields"]:
+        if field["type"] == "bytes":
+            data = values[field["name"]]
+            init = ", ".join("0x%02x" % b for b in data) or "0"
+            lines.append("        static const uint8_t tail_%d[] = { %s };" % (index, init))
+    lines.append("        pkt_%s_t pkt = {" % pkt["name"])
+    for field in pkt["fields"]:
+        if "value" in field:
+            continue
+        if field["type"] == "bytes":
+            lines.append("            .%s = tail_%d," % (field["name"], index))
+            lines.append("            .%s_len = %d," % (field["name"], len(values[field["name"]])))
+        else:
+            lines.append("            .%s = (%s)%dLL," % (field["name"], packetgen.TYPES[field["type"]][2],
+                                                      values[field["name"]]))
+    lines.append("        };")
+    transport = pkt.get("transport", "notify")
+    if transport == "notify":
+        lines.append("        user_pkt_%s_send(CONIDX_ALL, &pkt);" % pkt["name"])
+    elif transport == "alert":
+        lines.append("        user_pkt_%s_send(&pkt);" % pkt["name"])
+    else:
+        lines.append("        user_pkt_%s_send(0, &pkt);" % pkt["name"])
+    lines.append("        dump(\"%s\");" % pkt["name"])
+    lines.append("    }")
+    return lines
+
+
+def build_and_run(source, workdir):
+    harness = os.path.join(workdir, "harness.c")
+    binary = os.path.join(workdir, "harness")
+    with open(harness, "w") as f:
+        f.write(source)
+    cmd = ["gcc", "-std=gnu99", "-Wall", "-Werror", "-Wno-unused-parameter",
+           "-I", ROOT, "-I", os.path.join(ROOT, "test", "stubs"),
+           harness, os.path.join(ROOT, "user_packets.c"), "-o", binary]
+    subprocess.run(cmd, check=True)
+    return subprocess.run([binary], check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+
+def main():
+    schema = packetgen.load_schema(packetgen.SCHEMA)
+    rng = random.Random(0x0A4C1E)
+
+    all_cases = []
+    body = [HARNESS_HEAD]
+    index = 0
+    for pkt in schema["packets"]:
+        for values in make_cases(pkt, rng, reserved_values(schema, pkt)):
+            body.extend(line + "\n" for line in c_case(pkt, index, values))
+            all_cases.append((pkt, values))
+            index += 1
+    handles = sorted({pkt["characteristic"] for pkt in schema["packets"]})
+    for handle in handles:
+        body.append("    printf(\"handle %s %%u\\n\", %s);\n" % (handle, handle))
+    body.append("    return 0;\n}\n")
+
+    with tempfile.TemporaryDirectory() as workdir:
+        output = build_and_run("".join(body), workdir).splitlines()
+
+    handle_values = {}
+    for line in output[len(all_cases):]:
+        _tag, name, value = line.split()
+        handle_values[name] = int(value)
+
+    failures = 0
+    for (pkt, values), line in zip(all_cases, output):
+        name, handle, data = line.split(" ")
+        data = bytes.fromhex(data)
+        expected = pk.encode(pkt["name"], **values)
+        problems = []
+        if name != pkt["name"]:
+            problems.append("harness out of step")
+        if int(handle) != handle_values[pkt["characteristic"]]:
+            problems.append("sent on handle %s, expected %s" % (handle, pkt["characteristic"]))
+        if data != expected:
+            problems.append("firmware %s != host %s" % (data.hex(), expected.hex()))
+        decoded_name, decoded = pk.decode(data, raw=True)
+        if decoded_name != pkt["name"]:
+            problems.append("decoded as %s" % decoded_name)
+        for field, value in values.items():
+            if decoded.get(field) != value:
+                problems.append("%s: sent %r, decoded %r" % (field, value, decoded.get(field)))
+        if problems:
+            failures += 1
+            print("FAIL %s %s: %s" % (pkt["name"], values, "; ".join(problems)))
+
+    # Replies shorter than their command's layout fall back to the generic one,
+    # sample chunks are told from the header chunk by the chunk number, 0xDD
+    # answers by their command byte
+    for header, name in ((b"\xf0\x01\x02", "ota_reply"), (b"\xf0\x03\x07", "ota_reply"),
+                         (b"\xee\x05\x00\x01\xaa", "capture_data"), (b"\xdd\x05", None),
+                         (b"\xdd\x07\x01" + bytes(8), "time_sync_req"), (b"\xdd\x07\x01", None),
+                         (b"\xdd\x08\x01\x01" + bytes(8), "time_sync_result"),
+                         (b"\xdd\x7e\x03", "ctrl_result")):
+        try:
+            decoded_name = pk.decode(header)[0]
+        except ValueError:
+            decoded_name = None
+        if decoded_name != name:
+            failures += 1
+            print("FAIL %s decoded as %s, expected %s" % (header.hex(), decoded_name, name))
+
+    # A TLV answer as user_ctrl.c sends it: results stay raw in the tail
+    results = bytes([0x12, 0x00, 0x01, 100, 0x02, 0x00, 0x00, 0x30, 0x01, 0x00])
+    name, fields = pk.decode(b"\xdd\x7e\x09" + results)
+    if name != "ctrl_result" or fields != {"seq": 9, "results": results}:
+        failures += 1
+        print("FAIL TLV answer decoded as %s %r" % (name, fields))
+
+    print("%d packet types, %d cases, %d failures" % (len(schema["packets"]), len(all_cases), failures))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,457 @@
+#!/usr/bin/env python3
+"""
+Write the synthetic sensor traces for the host benchmark (test/bench.c).
+
+Trace format, one CSV per session, 100 Hz:
+
+    # name: cmj_series
+    # source: synthetic, tools/tracegen.py seed 1
+    # mode: gymnastics | medical
+    # jump: <takeoff ms> <landing ms> <height cm>     ground truth, one line per jump
+    # fall: <impact ms>                                ground truth, one line per fall
+    # steps: <n>                                       both legs, medical mode
+    # template: <hex>                                  register 0x18 blob, loaded first
+    # set: <template slot> <reps>                      one line per exercise set
+    ms,ax,ay,az,gx,gy,gz,adc
+
+Accel is in mg, gyro in 0.1 dps (the jump capture units) and adc is the
+10-bit pressure code, fed to all PRESSURE_OVERSAMPLE conversions of a sample.
+Recorded sessions in the same format go in test/traces/.
+
+The signals are shaped like typical ankle IMU and insole data:
+a countermovement dip, an impulsive push-off ending at toe-off, near free
+fall in flight and a 4-7 g landing impact. Traces also hold the motions the
+jump detector should ignore (stomps, running, walking) so precision means
+something. Falls drop the ankle below 0.5 g while the shank rotates towards
+the floor, hit it at 3.5-8 g and lie still; the medical sessions mix them
+with what the fall detector must not confirm: stumbles, stepping off a curb,
+sitting down hard, lying down in bed and stairs. Every trace has its own
+seed; the output is deterministic.
+
+Usage:
+    python tools/tracegen.py <output directory>
+"""
+
+import math
+import os
+import random
+import sys
+
+RATE_HZ = 100
+DT_MS = 1000 // RATE_HZ
+G = 9.81
+
+ACCEL_NOISE_MG = 12
+GYRO_NOISE = 3
+ADC_NOISE = 1.5
+ADC_FULL_SCALE_KPA = 100.0
+
+STAND_KPA = 45.0
+REPS_TEMPLATE_MAX_LEN = 32
+REPS_LSB_MG = 16
+REPS_AXIS_Z = 2
+
+
+def raised_cos(t, duration):
+    """0 -> 1 -> 0 over duration."""
+    return 0.5 * (1.0 - math.cos(2.0 * math.pi * t / duration))
+
+
+def flight_time_s(height_cm):
+    return 2.0 * math.sqrt(2.0 * height_cm / 100.0 / G)
+
+
+class Trace:
+    def __init__(self, name, mode, seed):
+        self.name = name
+        self.mode = mode
+        self.seed = seed
+        self.rng = random.Random(seed)
+        self.rows = []          # (ax, ay, az, gx, gy, gz, kPa) before noise
+        self.meta = []
+
+    @property
+    def now_ms(self):
+        return len(self.rows) * DT_MS
+
+    def add(self, accel, gyro=(0.0, 0.0, 0.0), kpa=STAND_KPA):
+        self.rows.append((accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2], kpa))
+
+    def add_mag(self, mag, tilt_deg=5.0, gyro=(0.0, 0.0, 0.0), kpa=STAND_KPA):
+        """Magnitude along the shank, tilted forward in the x-z plane."""
+        tilt = math.radians(tilt_deg)
+        self.add((mag * math.sin(tilt), 0.0, mag * math.cos(tilt)), gyro, kpa)
+
+    # Segments
+
+    def stand(self, seconds):
+        sway = self.rng.uniform(0, 2 * math.pi)
+        for i in range(int(seconds * RATE_HZ)):
+            t = i / RATE_HZ
+            self.add_mag(1000.0, 5.0 + 1.5 * math.sin(0.7 * t + sway),
+                         kpa=STAND_KPA + 3.0 * math.sin(0.4 * t + sway))
+
+    def jump(self, height_cm):
+        rng = self.rng
+        dip_ms = rng.uniform(250, 350)
+        push_ms = rng.uniform(60, 120)
+        push_peak = rng.uniform(2200, 3400)
+        impact = rng.uniform(4000, 7000)
+
+        # Countermovement: unweighting, the heel lifts off the insole
+        for i in range(int(dip_ms / DT_MS)):
+            s = math.sin(math.pi * i * DT_MS / dip_ms)
+            self.add_mag(1000.0 - 400.0 * s, 5.0 + 10.0 * s, kpa=STAND_KPA - 15.0 * s)
+        # Push-off ending at toe-off, load on the forefoot
+        for i in range(int(push_ms / DT_MS)):
+            w = raised_cos(i * DT_MS, push_ms)
+            self.add_mag(600.0 + (push_peak - 600.0) * w, 15.0 - 10.0 * w,
+                         gyro=(1500.0 * w, 0.0, 0.0), kpa=STAND_KPA + 30.0 * w)
+
+        takeoff = self.now_ms
+        flight_ms = flight_time_s(height_cm) * 1000.0
+        for i in range(int(round(flight_ms / DT_MS))):
+            self.add_mag(rng.uniform(50.0, 150.0), 10.0, gyro=(-300.0, 0.0, 0.0), kpa=1.0)
+        landing = self.now_ms
+        # Actual flight on the sample grid
+        height = G * ((landing - takeoff) / 1000.0) ** 2 / 8.0 * 100.0
+        self.meta.append("jump: %d %d %.1f" % (takeoff, landing, height))
+
+        # Impact, then the knees absorb it
+        for i in range(6):
+            self.add_mag(1000.0 + (impact - 1000.0) * math.sin(math.pi * i / 6), 8.0,
+                         gyro=(-800.0, 0.0, 0.0), kpa=90.0)
+        for i in range(30):
+            self.add_mag(1000.0 + 500.0 * math.exp(-i / 8.0), 5.0,
+                         kpa=STAND_KPA + 40.0 * math.exp(-i / 10.0))
+
+    def stomp(self):
+        """Lift the foot fast and stamp it down: not a jump."""
+        rng = self.rng
+        for i in range(6):
+            self.add_mag(1000.0 + 800.0 * raised_cos(i * DT_MS, 60), 5.0, gyro=(600.0, 0.0, 0.0))
+        for i in range(int(rng.uniform(250, 400) / DT_MS)):
+            self.add_mag(1000.0 + 100.0 * math.sin(i / 3.0), 20.0, kpa=1.0)
+        peak = rng.uniform(3000, 4500)
+        for i in range(6):
+            self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 6), 5.0, kpa=80.0)
+
+    def run(self, seconds):
+        """Running strides of the banded leg: push-off, long swing, heel impact."""
+        rng = self.rng
+        end = self.now_ms + seconds * 1000
+        while self.now_ms < end:
+            stance_ms = rng.uniform(220, 260)
+            swing_ms = rng.uniform(430, 480)
+            for i in range(int(stance_ms / DT_MS)):
+                t = i * DT_MS
+                if t < 40:
+                    mag = 1000.0 + 2200.0 * math.sin(math.pi * t / 40)
+                elif t > stance_ms - 70:
+                    mag = 1000.0 + 1500.0 * raised_cos(t - (stance_ms - 70), 70)
+                else:
+                    mag = 1800.0
+                self.add_mag(mag, 20.0, gyro=(900.0, 0.0, 0.0), kpa=80.0)
+            for i in range(int(swing_ms / DT_MS)):
+                t = i * DT_MS
+                self.add_mag(750.0 + 450.0 * math.sin(2 * math.pi * t / swing_ms), 40.0,
+                             gyro=(-2500.0 * math.sin(math.pi * t / swing_ms), 0.0, 0.0), kpa=1.0)
+
+    def walk(self, seconds, stride_ms=1100.0):
+        """Walking strides of the banded leg; returns the heel strike count."""
+        rng = self.rng
+        end = self.now_ms + seconds * 1000
+        strikes = 0
+        while self.now_ms < end:
+            stride = stride_ms * rng.uniform(0.97, 1.03)
+            stance = stride * 0.62
+            swing = stride - stance
+            impact = rng.uniform(1600, 2200)
+            strikes += 1
+            for i in range(int(stance / DT_MS)):
+                t = i * DT_MS
+                if t < 40:
+                    mag = 1000.0 + (impact - 1000.0) * math.sin(math.pi * t / 40)
+                elif t > stance - 100:
+                    mag = 1000.0 + 300.0 * raised_cos(t - (stance - 100), 100)
+                else:
+                    mag = 1000.0
+                # Heel then forefoot loading
+                kpa = 55.0 + 10.0 * math.sin(2 * math.pi * t / stance)
+                self.add_mag(mag, 10.0, gyro=(300.0, 0.0, 0.0), kpa=kpa)
+            for i in range(int(swing / DT_MS)):
+                t = i * DT_MS
+                self.add_mag(1000.0 + 300.0 * math.sin(2 * math.pi * t / swing), 25.0,
+                             gyro=(-1800.0 * math.sin(math.pi * t / swing), 0.0, 0.0), kpa=1.0)
+        return strikes
+
+    def fall(self):
+        """Loss of balance, impact on the floor, lying still, getting up."""
+        rng = self.rng
+        fall_ms = rng.uniform(300, 550)
+        low = rng.uniform(150, 450)
+        lying = rng.uniform(65, 100)
+        n = int(fall_ms / DT_MS)
+        rate = (lying - 5.0) / (fall_ms / 1000.0) * 10.0
+        for i in range(n):
+            phase = i / n
+            mag = low + (1000.0 - low) * max(0.0, 1.0 - 4.0 * phase)
+            self.add_mag(mag, 5.0 + (lying - 5.0) * phase, gyro=(rate, 0.0, 0.0), kpa=1.0)
+
+        self.meta.append("fall: %d" % self.now_ms)
+        peak = rng.uniform(3500, 8000)
+        for i in range(6):
+            self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 6), lying, kpa=0.5)
+        for i in range(50):
+            self.add_mag(1000.0 + 600.0 * math.exp(-i / 8.0) * math.sin(i), lying,
+                         gyro=(200.0 * math.exp(-i / 8.0), 0.0, 0.0), kpa=0.5)
+        for _ in range(int(rng.uniform(6, 10) * RATE_HZ)):
+            self.add_mag(1000.0, lying + rng.uniform(-1.0, 1.0), kpa=0.5)
+        self.get_up(lying)
+
+    def get_up(self, lying):
+        """Back to upright over 3 s, pushing off the floor."""
+        n = 3 * RATE_HZ
+        for i in range(n):
+            phase = i / n
+            self.add_mag(1000.0 + 300.0 * math.sin(6 * math.pi * phase), lying + (5.0 - lying) * phase,
+                         gyro=(-(lying - 5.0) / 3.0 * 10.0, 0.0, 0.0), kpa=20.0 * phase)
+
+    def stumble(self):
+        """Trip while walking and catch it with a hard step."""
+        rng = self.rng
+        for _ in range(int(rng.uniform(100, 180) / DT_MS)):
+            self.add_mag(rng.uniform(350, 480), 20.0, gyro=(-1500.0, 0.0, 0.0), kpa=1.0)
+        peak = rng.uniform(3100, 4000)
+        for i in range(6):
+            self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 6), 10.0, kpa=80.0)
+
+    def step_down(self):
+        """Step off a curb: short drop, firm landing."""
+        rng = self.rng
+        for _ in range(int(rng.uniform(120, 200) / DT_MS)):
+            self.add_mag(rng.uniform(100, 300), 10.0, gyro=(-400.0, 0.0, 0.0), kpa=1.0)
+        peak = rng.uniform(3000, 5000)
+        for i in range(6):
+            self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 6), 5.0, kpa=90.0)
+        for i in range(30):
+            self.add_mag(1000.0 + 400.0 * math.exp(-i / 8.0), 5.0, kpa=STAND_KPA)
+
+    def sit_down_hard(self, seconds):
+        """Drop onto a chair: no free fall, a jolt, then seated."""
+        for i in range(30):
+            self.add_mag(1000.0 - 250.0 * math.sin(math.pi * i / 30), 5.0, kpa=STAND_KPA * (1 - i / 30))
+        peak = self.rng.uniform(2500, 3500)
+        for i in range(5):
+            self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 5), 2.0, kpa=0.5)
+        self.sit(seconds)
+
+    def lie_down(self, seconds):
+        """Lie down in bed: slow rotation, no impact, still, then up."""
+        lying = self.rng.uniform(80, 95)
+        n = 3 * RATE_HZ
+        for i in range(n):
+            self.add_mag(1000.0, 5.0 + (lying - 5.0) * i / n, gyro=((lying - 5.0) / 3.0 * 10.0, 0.0, 0.0),
+                         kpa=0.5)
+        for _ in range(int(seconds * RATE_HZ)):
+            self.add_mag(1000.0, lying, kpa=0.5)
+        self.get_up(lying)
+
+    def stairs_down(self, steps):
+        """Each step lands on the banded leg every other step."""
+        rng = self.rng
+        for _ in range(steps):
+            for i in range(int(rng.uniform(600, 750) / DT_MS)):
+                self.add_mag(1000.0 + 250.0 * math.sin(2 * math.pi * i / 65), 15.0,
+                             gyro=(-1200.0 * math.sin(math.pi * i / 65), 0.0, 0.0), kpa=1.0)
+            peak = rng.uniform(2000, 2600)
+            for i in range(5):
+                self.add_mag(1000.0 + (peak - 1000.0) * math.sin(math.pi * i / 5), 10.0, kpa=70.0)
+
+    def knee_extension(self, raise_s, hold_s, lower_s, rest_s, amplitude_deg=70.0):
+        """Seated knee extension: the shank swings from vertical towards horizontal."""
+        phases = []
+        for i in range(int(raise_s * RATE_HZ)):
+            phases.append(0.5 * (1 - math.cos(math.pi * i / (raise_s * RATE_HZ))))
+        phases += [1.0] * int(hold_s * RATE_HZ)
+        for i in range(int(lower_s * RATE_HZ)):
+            phases.append(0.5 * (1 + math.cos(math.pi * i / (lower_s * RATE_HZ))))
+        phases += [0.0] * int(rest_s * RATE_HZ)
+        for phase in phases:
+            angle = math.radians(amplitude_deg * phase)
+            self.add((0.0, 1000.0 * math.sin(angle), 1000.0 * math.cos(angle)), kpa=0.5)
+
+    def sit(self, seconds):
+        for _ in range(int(seconds * RATE_HZ)):
+            self.add((0.0, 0.0, 1000.0), kpa=0.5)
+
+    # Output
+
+    def write(self, path):
+        rng = random.Random(self.seed * 7919)
+        with open(path, "w") as f:
+            f.write("# name: %s\n" % self.name)
+            f.write("# source: synthetic, tools/tracegen.py seed %d\n" % self.seed)
+            f.write("# mode: %s\n" % self.mode)
+            for line in self.meta:
+                f.write("# %s\n" % line)
+            f.write("ms,ax,ay,az,gx,gy,gz,adc\n")
+            for n, row in enumerate(self.rows):
+                accel = [int(round(v + rng.gauss(0, ACCEL_NOISE_MG))) for v in row[0:3]]
+                gyro = [int(round(v + rng.gauss(0, GYRO_NOISE))) for v in row[3:6]]
+                adc = int(round(row[6] * 1023 / ADC_FULL_SCALE_KPA + rng.gauss(0, ADC_NOISE)))
+                adc = min(max(adc, 0), 1023)
+                f.write("%d,%s,%s,%d\n" % (n * DT_MS, ",".join(map(str, accel)),
+                                           ",".join(map(str, gyro)), adc))
+
+
+def knee_extension_template(raise_s, hold_s, lower_s, threshold):
+    """Register 0x18 blob for slot 0: the Z axis of one rep at 10 Hz."""
+    samples = []
+    t = 0.0
+    total = raise_s + hold_s + lower_s
+    while t < total - 1e-9 and len(samples) < REPS_TEMPLATE_MAX_LEN:
+        if t < raise_s:
+            phase = 0.5 * (1 - math.cos(math.pi * t / raise_s))
+        elif t < raise_s + hold_s:
+            phase = 1.0
+        else:
+            phase = 0.5 * (1 + math.cos(math.pi * (t - raise_s - hold_s) / lower_s))
+        z = 1000.0 * math.cos(math.radians(70.0 * phase))
+        samples.append(int(round(z / REPS_LSB_MG)))
+        t += 0.1
+    blob = bytes([0, REPS_AXIS_Z, threshold & 0xFF, threshold >> 8, len(samples)])
+    blob += bytes(s & 0xFF for s in samples)
+    blob += bytes(REPS_TEMPLATE_MAX_LEN - len(samples))
+    return blob
+
+
+def cmj_series():
+    tr = Trace("cmj_series", "gymnastics", 1)
+    tr.stand(3)
+    for _ in range(12):
+        tr.jump(tr.rng.uniform(12, 45))
+        tr.stand(tr.rng.uniform(2.0, 3.5))
+    return tr
+
+
+def stomps_and_jumps():
+    tr = Trace("stomps_and_jumps", "gymnastics", 2)
+    tr.stand(3)
+    for i in range(12):
+        if i % 2:
+            tr.stomp()
+        else:
+            tr.jump(tr.rng.uniform(15, 40))
+        tr.stand(tr.rng.uniform(2.0, 3.0))
+    return tr
+
+
+def run_then_jumps():
+    tr = Trace("run_then_jumps", "gymnastics", 3)
+    tr.stand(3)
+    tr.run(10)
+    tr.stand(4)
+    for _ in range(5):
+        tr.jump(tr.rng.uniform(20, 50))
+        tr.stand(3)
+    return tr
+
+
+def walk_and_jumps():
+    tr = Trace("walk_and_jumps", "gymnastics", 4)
+    tr.stand(3)
+    for _ in range(4):
+        tr.walk(6)
+        tr.stand(2)
+        tr.jump(tr.rng.uniform(15, 40))
+        tr.stand(3)
+    return tr
+
+
+def walk_medical():
+    tr = Trace("walk_medical", "medical", 5)
+    tr.stand(4)
+    strikes = tr.walk(50)
+    tr.stand(10)
+    tr.meta.append("steps: %d" % (2 * strikes))
+    return tr
+
+
+def rehab_reps():
+    tr = Trace("rehab_reps", "medical", 6)
+    tr.meta.append("template: %s" % knee_extension_template(1.0, 0.4, 1.0, 160).hex())
+    tr.sit(5)
+    for _ in range(10):
+        tr.knee_extension(1.0, 0.4, 1.0, 0.6)
+    tr.meta.append("set: 0 10")
+    tr.sit(12)
+    for _ in range(8):
+        rng = tr.rng
+        tr.knee_extension(1.1 * rng.uniform(0.95, 1.1), 0.4, 1.2 * rng.uniform(0.95, 1.1), 0.8,
+                          amplitude_deg=60.0)
+    tr.meta.append("set: 0 8")
+    tr.sit(12)
+    return tr
+
+
+def falls_medical():
+    tr = Trace("falls_medical", "medical", 7)
+    tr.stand(4)
+    for i in range(8):
+        tr.walk(tr.rng.uniform(4, 8))
+        if i % 2:
+            tr.stumble()
+            tr.walk(3)
+        tr.fall()
+        tr.stand(3)
+    tr.sit_down_hard(10)
+    tr.lie_down(15)
+    tr.stand(5)
+    return tr
+
+
+def adl_medical():
+    """20 minutes of daily activity without a fall: false alarm rate."""
+    tr = Trace("adl_medical", "medical", 8)
+    rng = tr.rng
+    tr.stand(4)
+    while tr.now_ms < 20 * 60 * 1000:
+        pick = rng.randrange(7)
+        if pick == 0:
+            tr.walk(rng.uniform(20, 60))
+        elif pick == 1:
+            tr.stairs_down(rng.randrange(8, 16))
+        elif pick == 2:
+            tr.sit_down_hard(rng.uniform(20, 60))
+        elif pick == 3:
+            tr.lie_down(rng.uniform(20, 60))
+        elif pick == 4:
+            tr.walk(rng.uniform(3, 8))
+            tr.step_down()
+        elif pick == 5:
+            tr.walk(rng.uniform(3, 8))
+            tr.stumble()
+        tr.walk(rng.uniform(3, 10))
+        tr.stand(rng.uniform(5, 20))
+    return tr
+
+
+TRACES = [cmj_series, stomps_and_jumps, run_then_jumps, walk_and_jumps, walk_medical, rehab_reps,
+          falls_medical, adl_medical]
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        return 2
+    out = sys.argv[1]
+    os.makedirs(out, exist_ok=True)
+    for make in TRACES:
+        tr = make()
+        tr.write(os.path.join(out, tr.name + ".csv"))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,181 @@
+/**
+ * @file user_broadcast.c
+ * @brief Connectionless jump-count broadcast in advertising data
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_broadcast.h"
+#include "user_custs1_impl.h"
+#include "user_config.h"
+#include "app_api.h"
+#include "app_easy_gap.h"
+
+// Advertising data: manufacturer data followed by the complete local name
+#define BROADCAST_NAME_AD_LEN           (USER_DEVICE_NAME_LEN + 2)
+#define BROADCAST_ADV_DATA_LEN          (BROADCAST_AD_LEN + BROADCAST_NAME_AD_LEN)
+#define AD_TYPE_COMPLETE_NAME           0x09
+#define BROADCAST_INTERVAL_MAX          16384   // 10.24s, BLE limit
+
+// Global Variables
+static uint8_t adv_data[BROADCAST_ADV_DATA_LEN];
+static broadcast_metrics_t last_metrics = {0};
+static uint8_t rolling_counter = 0;
+static uint16_t adv_interval = USER_BROADCAST_INTERVAL_FAST;
+static uint16_t pending_interval = 0;
+static uint32_t last_jump_ms = 0;
+static uint32_t last_backoff_ms = 0;
+static bool jump_pending = false;
+static uint8_t power_shift = 0;
+
+// Local Functions
+static uint16_t broadcast_scaled(uint16_t interval);
+
+/**
+ * @brief Initialize broadcast advertising data
+ */
+void user_broadcast_init(void) {
+    memset(&last_metrics, 0, sizeof(last_metrics));
+    rolling_counter = 0;
+    adv_interval = USER_BROADCAST_INTERVAL_FAST;
+    pending_interval = 0;
+
+    // Local name never changes, write it once after the manufacturer data
+    adv_data[BROADCAST_AD_LEN] = USER_DEVICE_NAME_LEN + 1;
+    adv_data[BROADCAST_AD_LEN + 1] = AD_TYPE_COMPLETE_NAME;
+    memcpy(&adv_data[BROADCAST_AD_LEN + 2], USER_DEVICE_NAME, USER_DEVICE_NAME_LEN);
+
+    user_broadcast_encode(&last_metrics, rolling_counter, adv_data);
+}
+
+/**
+ * @brief Encode live metrics as a manufacturer specific AD structure
+ * @return Number of bytes written (BROADCAST_AD_LEN)
+ */
+uint8_t user_broadcast_encode(const broadcast_metrics_t *metrics, uint8_t counter, uint8_t *buf) {
+    uint8_t idx = 0;
+    uint16_t battery = metrics->battery_mv / BROADCAST_BATTERY_STEP_MV;
+
+    buf[idx++] = BROADCAST_AD_LEN - 1;
+    buf[idx++] = BROADCAST_AD_TYPE_MANUF;
+    buf[idx++] = (uint8_t)(USER_BROADCAST_COMPANY_ID & 0xFF);
+    buf[idx++] = (uint8_t)(USER_BROADCAST_COMPANY_ID >> 8);
+    buf[idx++] = BROADCAST_PAYLOAD_VERSION;
+    buf[idx++] = counter;
+
+    buf[idx++] = (uint8_t)(metrics->total_jumps & 0xFF);
+    buf[idx++] = (uint8_t)(metrics->total_jumps >> 8);
+    buf[idx++] = (uint8_t)(metrics->last_height_mm & 0xFF);
+    buf[idx++] = (uint8_t)(metrics->last_height_mm >> 8);
+    buf[idx++] = (uint8_t)(metrics->max_height_mm & 0xFF);
+    buf[idx++] = (uint8_t)(metrics->max_height_mm >> 8);
+    buf[idx++] = (uint8_t)(battery > 0xFF ? 0xFF : battery);
+
+    return idx;
+}
+
+/**
+ * @brief Refresh the advertised metrics
+ */
+void user_broadcast_update(const broadcast_metrics_t *metrics, bool jump_event) {
+    if (memcmp(metrics, &last_metrics, sizeof(last_metrics)) == 0) {
+        return;
+    }
+
+    last_metrics = *metrics;
+    rolling_counter++;
+    user_broadcast_encode(&last_metrics, rolling_counter, adv_data);
+
+    // Advertising data can be swapped while advertising is running
+    if (user_ble_can_advertise()) {
+        app_easy_gap_update_adv_data(adv_data, sizeof(adv_data), NULL, 0);
+    }
+
+    if (jump_event) {
+        jump_pending = true;
+    }
+}
+
+/**
+ * @brief Adapt the advertising interval to jump activity
+ */
+void user_broadcast_tick(uint32_t now_ms) {
+    uint16_t target = adv_interval;
+    uint16_t fast = broadcast_scaled(USER_BROADCAST_INTERVAL_FAST);
+    uint16_t idle = broadcast_scaled(USER_BROADCAST_INTERVAL_IDLE);
+
+    if (jump_pending) {
+        // Fresh jump: advertise fast so scanners pick it up quickly
+        jump_pending = false;
+        last_jump_ms = now_ms;
+        last_backoff_ms = now_ms;
+        target = fast;
+    } else if (adv_interval > idle) {
+        // Battery recovered to a tier with shorter intervals
+        target = idle;
+    } else if ((now_ms - last_jump_ms) > USER_BROADCAST_HOLD_MS &&
+               (now_ms - last_backoff_ms) > USER_BROADCAST_HOLD_MS &&
+               adv_interval < idle) {
+        // Between jumps: double the interval down to the idle rate
+        last_backoff_ms = now_ms;
+        target = ((uint32_t)adv_interval * 2 > idle) ? idle : adv_interval * 2;
+    }
+
+    if (target == adv_interval || !user_ble_can_advertise()) {
+        return;
+    }
+
+    // Interval changes need an advertising restart, finished in on_adv_complete
+    if (pending_interval == 0) {
+        app_easy_gap_advertise_stop();
+    }
+    pending_interval = target;
+}
+
+/**
+ * @brief Restart advertising with the pending interval
+ */
+void user_broadcast_on_adv_complete(void) {
+    if (pending_interval == 0) {
+        return;
+    }
+
+    adv_interval = pending_interval;
+    pending_interval = 0;
+
+    struct gapm_start_advertise_cmd *cmd = app_easy_gap_undirected_advertise_get_active();
+    cmd->intv.adv_intv_min = adv_interval;
+    cmd->intv.adv_intv_max = adv_interval;
+
+    // All slots taken: the new interval applies once a slot frees up
+    if (!user_ble_can_advertise()) {
+        return;
+    }
+
+    app_easy_gap_update_adv_data(adv_data, sizeof(adv_data), NULL, 0);
+    app_easy_gap_undirected_advertise_start();
+}
+
+/**
+ * @brief Get current advertising interval (0.625ms units)
+ */
+uint16_t user_broadcast_get_interval(void) {
+    return adv_interval;
+}
+
+/**
+ * @brief Stretch both advertising intervals for the battery governor
+ * @param shift Intervals are doubled this many times (0 = configured rates)
+ */
+void user_broadcast_set_power_shift(uint8_t shift) {
+    power_shift = shift;
+}
+
+/**
+ * @brief Interval scaled by the battery governor, within the BLE limit
+ */
+static uint16_t broadcast_scaled(uint16_t interval) {
+    uint32_t scaled = (uint32_t)interval << power_shift;
+    return (scaled > BROADCAST_INTERVAL_MAX) ? BROADCAST_INTERVAL_MAX : (uint16_t)scaled;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file user_broadcast.h
+ * @brief Connectionless jump-count broadcast in advertising data
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_BROADCAST_H_
+#define USER_BROADCAST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Manufacturer Specific Data Layout (little-endian)
+// [Len][0xFF][CompanyID_L][CompanyID_H][Version][Counter]
+// [Jumps_L][Jumps_H][LastHeight_L][LastHeight_H][MaxHeight_L][MaxHeight_H][Battery]
+#define BROADCAST_PAYLOAD_VERSION       0x01
+#define BROADCAST_AD_TYPE_MANUF         0xFF
+#define BROADCAST_AD_LEN                13      // Including the length byte
+#define BROADCAST_BATTERY_STEP_MV       20      // Battery byte resolution
+
+// Live Metrics Carried in the Broadcast
+typedef struct {
+    uint16_t total_jumps;
+    uint16_t last_height_mm;
+    uint16_t max_height_mm;
+    uint16_t battery_mv;
+} broadcast_metrics_t;
+
+// Function Prototypes
+void user_broadcast_init(void);
+void user_broadcast_update(const broadcast_metrics_t *metrics, bool jump_event);
+void user_broadcast_tick(uint32_t now_ms);
+void user_broadcast_on_adv_complete(void);
+uint8_t user_broadcast_encode(const broadcast_metrics_t *metrics, uint8_t counter, uint8_t *buf);
+uint16_t user_broadcast_get_interval(void);
+void user_broadcast_set_power_shift(uint8_t shift);
+
+#endif // USER_BROADCAST_H_
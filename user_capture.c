@@ -0,0 +1,322 @@
+/**
+ * @file user_capture.c
+ * @brief Pre/post-trigger raw capture window around each jump
+ * @author Muhammad Umer Sajid, Student
+ *
+ * A ring keeps the last CAPTURE_PRE_MS of samples. Takeoff freezes it into a
+ * free snapshot slot, landing appends CAPTURE_POST_MS more, and finished
+ * snapshots are sent in chunks only while the BLE link has no live traffic
+ * queued. Window lengths in samples follow the loop rate at takeoff; the
+ * rate goes out in the header so the app can rebuild the timebase.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_capture.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_time_sync.h"
+#include "user_packets.h"
+
+// Snapshot Slot States
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_IN_FLIGHT,
+    SLOT_POST,
+    SLOT_READY
+} slot_state_t;
+
+// Snapshot Storage
+typedef struct {
+    slot_state_t state;
+    uint16_t jump_id;
+    uint16_t flight_ms;
+    uint32_t takeoff_us;
+    uint8_t rate_hz;
+    uint8_t pre_count;
+    uint8_t post_samples;   // Post-landing window at rate_hz
+    uint8_t count;
+    capture_sample_t samples[CAPTURE_SNAPSHOT_SAMPLES];
+} capture_snapshot_t;
+
+// Global Variables
+static capture_sample_t ring[CAPTURE_PRE_SAMPLES];
+static uint8_t ring_head = 0;
+static uint8_t ring_count = 0;
+static uint8_t ring_rate_hz = 0;
+static capture_snapshot_t snapshots[CAPTURE_SNAPSHOT_COUNT];
+static capture_snapshot_t *active = NULL;        // In flight
+static capture_snapshot_t *post = NULL;          // Landed, recording the post-landing window
+static capture_snapshot_t *sending = NULL;
+static uint8_t send_chunk = 0;
+static uint8_t chunk_len = 0;        // Sample bytes per chunk of the snapshot being sent
+static uint16_t captures_dropped = 0;
+
+// Local Functions
+static uint8_t window_samples(uint16_t ms, uint8_t rate_hz);
+static uint8_t chunk_payload(void);
+static uint8_t snapshot_chunks(const capture_snapshot_t *snap);
+static capture_snapshot_t *next_ready(void);
+
+/**
+ * @brief Reset ring and snapshot slots
+ */
+void user_capture_init(void) {
+    memset(snapshots, 0, sizeof(snapshots));
+    ring_head = 0;
+    ring_count = 0;
+    ring_rate_hz = 0;
+    active = NULL;
+    post = NULL;
+    sending = NULL;
+    send_chunk = 0;
+    captures_dropped = 0;
+}
+
+/**
+ * @brief Add one sample (called every loop pass)
+ * @param rate_hz Current loop rate
+ *
+ * A rate change starts a new timebase: the ring restarts, an open
+ * post-landing window ends with what it has and a jump in flight is not
+ * captured.
+ */
+void user_capture_push(const capture_sample_t *sample, uint8_t rate_hz) {
+    if (rate_hz > CAPTURE_RATE_MAX_HZ) {
+        rate_hz = CAPTURE_RATE_MAX_HZ;
+    }
+
+    if (rate_hz != ring_rate_hz) {
+        ring_rate_hz = rate_hz;
+        ring_head = 0;
+        ring_count = 0;
+
+        if (post != NULL) {
+            post->state = SLOT_READY;
+            post = NULL;
+        }
+        user_capture_abort();
+    }
+
+    ring[ring_head] = *sample;
+    ring_head = (ring_head + 1) % CAPTURE_PRE_SAMPLES;
+    if (ring_count < CAPTURE_PRE_SAMPLES) {
+        ring_count++;
+    }
+
+    if (post != NULL) {
+        post->samples[post->count++] = *sample;
+
+        if (post->count >= post->pre_count + post->post_samples) {
+            post->state = SLOT_READY;
+            post = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Freeze the pre-trigger ring into a free snapshot slot
+ *
+ * A jump still recording its post-landing window (a takeoff within
+ * CAPTURE_POST_MS of the last landing) keeps its slot and goes on filling.
+ */
+void user_capture_on_takeoff(uint32_t takeoff_us) {
+    if (active != NULL) {
+        // Previous takeoff never landed, reuse its slot
+        active->state = SLOT_FREE;
+        active = NULL;
+    }
+
+    for (uint8_t i = 0; i < CAPTURE_SNAPSHOT_COUNT; i++) {
+        if (snapshots[i].state == SLOT_FREE) {
+            active = &snapshots[i];
+            break;
+        }
+    }
+
+    if (active == NULL) {
+        // All slots wait for BLE, keep the older captures
+        captures_dropped++;
+        printf("Capture dropped (%d), no free slot\n", captures_dropped);
+        return;
+    }
+
+    // Newest CAPTURE_PRE_MS of the ring, oldest sample first
+    uint8_t pre = window_samples(CAPTURE_PRE_MS, ring_rate_hz);
+    if (pre > ring_count) {
+        pre = ring_count;
+    }
+
+    uint8_t start = (ring_head + CAPTURE_PRE_SAMPLES - pre) % CAPTURE_PRE_SAMPLES;
+    for (uint8_t i = 0; i < pre; i++) {
+        active->samples[i] = ring[(start + i) % CAPTURE_PRE_SAMPLES];
+    }
+
+    active->state = SLOT_IN_FLIGHT;
+    active->takeoff_us = takeoff_us;
+    active->rate_hz = ring_rate_hz;
+    active->pre_count = pre;
+    active->post_samples = window_samples(CAPTURE_POST_MS, ring_rate_hz);
+    active->count = pre;
+}
+
+/**
+ * @brief Start the post-landing window of a valid jump
+ *
+ * The landing sample was pushed before detection ran, so it opens the
+ * post-landing window here. An earlier jump whose window is still open
+ * ends with the samples it has.
+ */
+void user_capture_on_landing(uint16_t jump_id, uint16_t flight_ms) {
+    if (active == NULL) {
+        return;
+    }
+
+    if (post != NULL) {
+        post->state = SLOT_READY;
+    }
+
+    post = active;
+    active = NULL;
+    post->jump_id = jump_id;
+    post->flight_ms = flight_ms;
+    post->state = SLOT_POST;
+
+    if (ring_count > 0) {
+        post->samples[post->count++] = ring[(ring_head + CAPTURE_PRE_SAMPLES - 1) % CAPTURE_PRE_SAMPLES];
+    }
+}
+
+/**
+ * @brief Drop the capture of a rejected jump
+ */
+void user_capture_abort(void) {
+    if (active != NULL) {
+        active->state = SLOT_FREE;
+        active = NULL;
+    }
+}
+
+/**
+ * @brief Last central gone: resend the current snapshot from its header chunk
+ */
+void user_capture_on_disconnect(void) {
+    send_chunk = 0;
+}
+
+/**
+ * @brief Number of snapshots waiting for BLE
+ */
+uint8_t user_capture_pending(void) {
+    uint8_t pending = 0;
+
+    for (uint8_t i = 0; i < CAPTURE_SNAPSHOT_COUNT; i++) {
+        if (snapshots[i].state == SLOT_READY) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+/**
+ * @brief Send one chunk of a finished snapshot when the link is idle
+ */
+void user_capture_poll_tx(void) {
+    if (user_ble_get_state() != BLE_CONNECTED || !user_custs1_tx_idle()) {
+        return;
+    }
+
+    if (sending == NULL) {
+        sending = next_ready();
+        send_chunk = 0;
+        if (sending == NULL) {
+            return;
+        }
+    }
+
+    // A central joined with a smaller MTU: start over with shorter chunks
+    if (send_chunk > 0 && chunk_payload() < chunk_len) {
+        send_chunk = 0;
+    }
+
+    bool sent;
+
+    if (send_chunk == 0) {
+        chunk_len = chunk_payload();
+        pkt_capture_head_t head = {
+            .jump_id = sending->jump_id,
+            .takeoff_time = user_time_sync_to_shared(sending->takeoff_us),
+            .flight_ms = sending->flight_ms,
+            .pre_samples = sending->pre_count,
+            .post_samples = sending->count - sending->pre_count,
+            .chunks = snapshot_chunks(sending),
+            .sample_rate_hz = sending->rate_hz
+        };
+        sent = user_pkt_capture_head_send(CONIDX_ALL, &head);
+    } else {
+        // Samples are stored little-endian already, send the raw bytes
+        uint16_t total = sending->count * sizeof(capture_sample_t);
+        uint16_t offset = (send_chunk - 1) * chunk_len;
+        uint16_t len = total - offset;
+        if (len > chunk_len) {
+            len = chunk_len;
+        }
+
+        pkt_capture_data_t data = {
+            .jump_id = sending->jump_id,
+            .chunk = send_chunk,
+            .samples = (const uint8_t *)sending->samples + offset,
+            .samples_len = (uint8_t)len
+        };
+        sent = user_pkt_capture_data_send(CONIDX_ALL, &data);
+    }
+
+    // Retry the same chunk until a connection takes it
+    if (!sent) {
+        return;
+    }
+
+    if (++send_chunk >= snapshot_chunks(sending)) {
+        sending->state = SLOT_FREE;
+        sending = NULL;
+    }
+}
+
+/**
+ * @brief Samples in a window of ms at rate_hz, at least one
+ */
+static uint8_t window_samples(uint16_t ms, uint8_t rate_hz) {
+    uint16_t samples = ((uint32_t)ms * rate_hz) / 1000;
+    return (samples > 0) ? (uint8_t)samples : 1;
+}
+
+/**
+ * @brief Sample bytes that fit one notification to every connection
+ */
+static uint8_t chunk_payload(void) {
+    uint16_t max = user_custs1_get_ntf_max(CONIDX_ALL) - CAPTURE_CHUNK_OVERHEAD;
+    return (max < CAPTURE_CHUNK_MAX) ? (uint8_t)max : CAPTURE_CHUNK_MAX;
+}
+
+/**
+ * @brief Chunks needed for a snapshot at chunk_len, including the header chunk
+ */
+static uint8_t snapshot_chunks(const capture_snapshot_t *snap) {
+    uint16_t total = snap->count * sizeof(capture_sample_t);
+    return 1 + (uint8_t)((total + chunk_len - 1) / chunk_len);
+}
+
+/**
+ * @brief Oldest finished snapshot (lowest jump id)
+ */
+static capture_snapshot_t *next_ready(void) {
+    capture_snapshot_t *next = NULL;
+
+    for (uint8_t i = 0; i < CAPTURE_SNAPSHOT_COUNT; i++) {
+        if (snapshots[i].state == SLOT_READY &&
+            (next == NULL || (int16_t)(snapshots[i].jump_id - next->jump_id) < 0)) {
+            next = &snapshots[i];
+        }
+    }
+    return next;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file user_capture.h
+ * @brief Pre/post-trigger raw capture window around each jump
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_CAPTURE_H_
+#define USER_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "user_config.h"
+#include "user_packets.h"
+
+// Window Sizes (samples at the highest loop rate, register 0x12 allows 10-100 Hz)
+#define CAPTURE_RATE_MAX_HZ             SENSOR_SAMPLE_RATE_HZ
+#define CAPTURE_PRE_SAMPLES             ((CAPTURE_PRE_MS * CAPTURE_RATE_MAX_HZ) / 1000)
+#define CAPTURE_POST_SAMPLES            ((CAPTURE_POST_MS * CAPTURE_RATE_MAX_HZ) / 1000)
+#define CAPTURE_SNAPSHOT_SAMPLES        (CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES)
+
+// BLE Chunks (capture_head and capture_data packets, tools/packets.json),
+// sample bytes per chunk fill the smallest MTU of the connected centrals
+#define CAPTURE_CHUNK_MAX               PKT_CAPTURE_DATA_SAMPLES_MAX
+#define CAPTURE_CHUNK_OVERHEAD          (PKT_CAPTURE_DATA_LEN - PKT_CAPTURE_DATA_SAMPLES_MAX)
+
+// Compact Full-Rate Sample (14 bytes, little-endian)
+typedef struct {
+    int16_t accel[3];       // mg
+    int16_t gyro[3];        // 0.1 dps
+    uint16_t pressure;      // 25 Pa
+} capture_sample_t;
+
+// Function Prototypes
+void user_capture_init(void);
+void user_capture_push(const capture_sample_t *sample, uint8_t rate_hz);
+void user_capture_on_takeoff(uint32_t takeoff_us);
+void user_capture_on_landing(uint16_t jump_id, uint16_t flight_ms);
+void user_capture_abort(void);
+void user_capture_on_disconnect(void);
+void user_capture_poll_tx(void);
+uint8_t user_capture_pending(void);
+
+#endif // USER_CAPTURE_H_
@@ -35,6 +35,13 @@
 #define USER_SLAVE_LATENCY              (0)
 #define USER_SUPERVISION_TIMEOUT        (1000)   // 10s (1000 * 10ms)
 
+// Broadcast Configuration (live metrics in advertising data)
+#define CFG_ADV_BROADCAST               (1)
+#define USER_BROADCAST_COMPANY_ID       (0x00D2) // Dialog Semiconductor
+#define USER_BROADCAST_INTERVAL_FAST    (160)    // 100ms right after a jump
+#define USER_BROADCAST_INTERVAL_IDLE    (1600)   // 1s when no jumps
+#define USER_BROADCAST_HOLD_MS          (3000)   // Time per interval step
+
 // Hardware Configuration
 #define GPIO_ALERT_LED_PORT             GPIO_PORT_0
 #define GPIO_ALERT_LED_PIN              GPIO_PIN_11
@@ -59,7 +66,8 @@
 #define SERIAL_NUMBER                   "AB2025001"
 
 // Memory Configuration
-#define CFG_MAX_CONNECTIONS             (1)
+#define CFG_MAX_CONNECTIONS             (3)      // Athlete phone + coach tablet + spare
+#define USER_TX_CREDITS                 (4)      // Queued notifications per connection
 #define CFG_CON_CTE_RSP_ENABLE          (0)
 
 // Debug Configuration
@@ -71,14 +79,77 @@
     #define DBG_UART_ENABLE             (0)
 #endif
 
+// Gait Analytics (medical mode)
+#define GAIT_MIN_PRESSURE_RANGE         (400)    // 25 Pa units (10 kPa) between contact and swing
+
+// Fall Detection (medical mode, alerts preempt all other notifications)
+#define CFG_FALL_DETECTION              (1)
+
+// Off-Body Detection (sensing, streaming and capture pause while the band is not worn)
+#define CFG_WEAR_DETECTION              (1)
+#define WEAR_PRESSURE_CONTACT           (40)     // 25 Pa units (1 kPa), any contact means worn
+
+// Exercise Repetition Counter (medical mode, templates in registers 0x18/0x19)
+#define CFG_REP_COUNTER                 (1)
+
+// Hot Path Profiling (SysTick cycle counts, printed every PROFILE_REPORT_MS)
+#define CFG_PROFILE_HOT_PATHS           (CFG_DEVELOPMENT_DEBUG)
+#define PROFILE_REPORT_MS               (10000)
+#define PROFILE_BUDGET_READ_SENSORS     (12000)  // Cycles per call at 16MHz
+#define PROFILE_BUDGET_DETECT_JUMP      (3000)
+#define PROFILE_BUDGET_BLE_TRANSMIT     (4000)
+#define PROFILE_BUDGET_GAIT             (400)
+#define PROFILE_BUDGET_PRESSURE         (1500)   // 8 conversions + CIC + LUT
+#define PROFILE_BUDGET_REPS             (2500)   // Mean per sample, matching runs at 10Hz
+
+// Memory Telemetry (heap/stack high-water marks, register 0x21)
+#define CFG_MEM_TELEMETRY               (1)
+#define USER_STACK_SIZE                 (0x600)  // Must match Stack_Size in the startup file
+
+// Battery Governor (filtered VBAT tiers, see user_power.c for per-tier limits)
+// Thresholds follow the CR2032 curve in user_power.c: a fresh cell (~3.0V) is Normal
+#define POWER_VBAT_INTERVAL_MS          (10000)
+#define POWER_TIER_ECO_MV               (2850)   // ~67% left
+#define POWER_TIER_LOW_MV               (2750)   // ~42% left
+#define POWER_TIER_CRITICAL_MV          (2600)   // ~15% left, session log flushed to flash
+#define POWER_TIER_CUTOFF_MV            (2450)   // ~2% left, streaming stops
+#define POWER_TIER_HYSTERESIS_MV        (60)
+#define POWER_BATTERY_CAPACITY_MAH      (225)    // CR2032
+
 // Low Power Configuration
 #define LP_CLK_OTP_OFFSET               (0x7f74)
 #define USE_POWER_OPTIMIZATIONS         (1)
 
 // Application Specific
 #define SENSOR_SAMPLE_RATE_HZ           (100)
+#define USER_DEFAULT_JUMP_THRESHOLD_MG  (1500)
+#define USER_DEFAULT_LANDING_THRESHOLD_MG (2500)
+#define USER_DEFAULT_TX_RATE_HZ         (10)
 #define JUMP_DETECTION_ENABLED          (1)
 #define PRESSURE_SENSOR_ENABLED         (1)
+#define PRESSURE_OVERSAMPLE             (8)      // ADC conversions per output sample (CIC decimation)
 #define BATTERY_MONITORING_ENABLED      (1)
 
+// Jump Capture (raw waveform around takeoff/landing, 14 bytes per sample)
+#define CFG_JUMP_CAPTURE                (1)
+#define CAPTURE_PRE_MS                  (250)    // Kept before takeoff
+#define CAPTURE_POST_MS                 (250)    // Recorded after landing
+#define CAPTURE_SNAPSHOT_COUNT          (2)      // ~0.7KB RAM each
+
+// Over-the-Air Update (SDK dual image layout in the 128KB SPI flash)
+#define CFG_OTA                         (1)
+#define OTA_BANK1_ADDR                  (0x02000)
+#define OTA_BANK2_ADDR                  (0x0E000)
+#define OTA_BANK_SIZE                   (0x0C000)  // 48KB per image
+#define OTA_ACK_WINDOW                  (8)      // Data packets per acknowledgement
+
+// Link Throughput (LE Data Length Extension, MTU exchange at connection)
+#define CFG_MAX_TX_PACKET_LENGTH        (251)
+#define CFG_MAX_RX_PACKET_LENGTH        (251)
+#define USER_DLE_TX_TIME                ((CFG_MAX_TX_PACKET_LENGTH + 14) * 8)  // us
+
+// NVM Records (one 4KB sector each, between image bank 2 and the product header at 0x1F000)
+#define NVM_BASE_ADDR                   (0x1A000)
+#define NVM_SECTOR_COUNT                (5)
+
 #endif // USER_CONFIG_H_
\ No newline at end of file
@@ -0,0 +1,472 @@
+/**
+ * @file user_ctrl.c
+ * @brief Batched TLV command/response protocol and configuration registers
+ * @author Muhammad Umer Sajid, Student
+ *
+ * One write carries any number of GET/SET operations. Results are collected
+ * into a single status (0xDD) notification to the writer. Processing stops at
+ * the first operation whose result would not fit in the notification, so
+ * unanswered operations have no side effects and can simply be resent.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_ctrl.h"
+#include "user_config.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_time_sync.h"
+#include "user_capture.h"
+#include "user_fall.h"
+#include "user_pressure.h"
+#include "user_reps.h"
+#include "user_wear.h"
+#include "user_mem.h"
+#include "user_packets.h"
+
+#define REG_MALFORMED                   0xFF
+
+#if PKT_CTRL_RESULT_LEN > MAX_STATUS_DATA_LEN
+#error "ctrl_result in tools/packets.json is longer than the device control value"
+#endif
+
+// Register Descriptor (length 0 = no read / no write access)
+typedef struct {
+    uint8_t reg;
+    uint8_t rd_len;
+    uint8_t wr_len;
+    uint32_t min;
+    uint32_t max;
+} ctrl_reg_desc_t;
+
+static const ctrl_reg_desc_t reg_table[] = {
+    { CTRL_REG_STATUS,            PKT_STATUS_BODY_LEN, 0, 0, 0 },
+    { CTRL_REG_SCHEMA_VERSION,    1,  0,  0,    0 },
+    { CTRL_REG_ACTION,            0,  1,  0,    CTRL_ACTION_CALIBRATE | CTRL_ACTION_RESET_COUNTERS },
+    { CTRL_REG_JUMP_THRESHOLD,    2,  2,  1100, 4000 },
+    { CTRL_REG_LANDING_THRESHOLD, 2,  2,  1500, 8000 },
+    { CTRL_REG_SAMPLE_RATE,       1,  1,  10,   100 },
+    { CTRL_REG_TX_RATE,           1,  1,  1,    20 },
+    { CTRL_REG_MODE,              1,  1,  DEVICE_MODE_GYMNASTICS, DEVICE_MODE_MEDICAL },
+    { CTRL_REG_LOG_CURSOR,        4,  4,  0,    0xFFFFFFFF },
+    { CTRL_REG_FALL_ALERT,        6,  1,  1,    1 },    // Statistics; write 1 = ack
+    { CTRL_REG_PRESSURE_CAL,      PRESSURE_CAL_LEN, PRESSURE_CAL_LEN, 0, 0 },
+    { CTRL_REG_REP_TEMPLATE,      0,  REPS_TEMPLATE_BLOB_LEN, 0, 0 },
+    { CTRL_REG_REP_STATUS,        REPS_STATUS_LEN, 0, 0, 0 },
+    { CTRL_REG_DIAG_SYSTEM,       9,  0,  0,    0 },
+    { CTRL_REG_DIAG_MEMORY,       12, 0,  0,    0 },
+    { CTRL_REG_DIAG_WEAR,         WEAR_DIAG_LEN, 0, 0, 0 }
+};
+
+#define REG_TABLE_NB                    (sizeof(reg_table) / sizeof(reg_table[0]))
+
+// Global Variables
+static app_settings_t settings;
+static app_status_t status;
+static volatile uint8_t pending_actions = 0;
+static uint32_t pending_jump_count = 0;
+static volatile bool jump_count_pending = false;
+
+// Local Functions
+static const ctrl_reg_desc_t *find_reg(uint8_t reg);
+static void status_get(pkt_status_t *pkt);
+static uint8_t reg_read(uint8_t reg, uint8_t *out);
+static void reg_write(uint8_t reg, uint32_t value);
+static uint8_t reg_write_block(uint8_t reg, const uint8_t *value);
+static uint32_t value_le(const uint8_t *p, uint8_t len);
+static uint8_t put_le(uint8_t *out, uint32_t value, uint8_t len);
+
+/**
+ * @brief Load default settings
+ */
+void user_ctrl_init(void) {
+    settings.jump_threshold_mg = USER_DEFAULT_JUMP_THRESHOLD_MG;
+    settings.landing_threshold_mg = USER_DEFAULT_LANDING_THRESHOLD_MG;
+    settings.sample_rate_hz = SENSOR_SAMPLE_RATE_HZ;
+    settings.tx_rate_hz = USER_DEFAULT_TX_RATE_HZ;
+    settings.mode = DEVICE_MODE_GYMNASTICS;
+
+    memset(&status, 0, sizeof(status));
+    pending_actions = 0;
+    jump_count_pending = false;
+}
+
+/**
+ * @brief Current runtime settings
+ */
+const app_settings_t *user_ctrl_settings(void) {
+    return &settings;
+}
+
+/**
+ * @brief Live status, updated by the sampling loop
+ */
+app_status_t *user_ctrl_status(void) {
+    return &status;
+}
+
+/**
+ * @brief Execute a TLV frame and answer with one status notification
+ */
+void user_ctrl_handle_frame(uint8_t conidx, const uint8_t *frame, uint16_t length) {
+    uint8_t rsp[PKT_CTRL_RESULT_RESULTS_MAX];
+    uint8_t idx = 0;
+    uint16_t limit = user_custs1_get_ntf_max(conidx) - (PKT_CTRL_RESULT_LEN - PKT_CTRL_RESULT_RESULTS_MAX);
+    uint16_t pos = CTRL_FRAME_HEADER_LEN;
+
+    if (length < CTRL_FRAME_HEADER_LEN) {
+        return;
+    }
+    if (limit > sizeof(rsp)) {
+        limit = sizeof(rsp);
+    }
+
+    while (pos < length) {
+        // Operation header and value must both be inside the frame
+        if ((length - pos) < CTRL_OP_HEADER_LEN ||
+            (length - pos - CTRL_OP_HEADER_LEN) < frame[pos + 2]) {
+            if (idx + CTRL_RESULT_HEADER_LEN <= limit) {
+                rsp[idx++] = REG_MALFORMED;
+                rsp[idx++] = CTRL_STATUS_MALFORMED;
+                rsp[idx++] = 0;
+            }
+            break;
+        }
+
+        uint8_t op = frame[pos];
+        uint8_t reg = frame[pos + 1];
+        uint8_t len = frame[pos + 2];
+        const uint8_t *value = &frame[pos + CTRL_OP_HEADER_LEN];
+        const ctrl_reg_desc_t *desc = find_reg(reg);
+
+        // Worst case result is a GET of this register
+        uint8_t result_len = CTRL_RESULT_HEADER_LEN + ((op == CTRL_OP_GET && desc) ? desc->rd_len : 0);
+        if (idx + result_len > limit) {
+            break;
+        }
+
+        uint8_t result = CTRL_STATUS_OK;
+        uint8_t out_len = 0;
+
+        if (desc == NULL) {
+            result = CTRL_STATUS_UNKNOWN_REG;
+        } else if (op == CTRL_OP_GET) {
+            if (desc->rd_len == 0) {
+                result = CTRL_STATUS_WRITE_ONLY;
+            } else {
+                out_len = reg_read(reg, &rsp[idx + CTRL_RESULT_HEADER_LEN]);
+            }
+        } else if (op == CTRL_OP_SET) {
+            if (desc->wr_len == 0) {
+                result = CTRL_STATUS_READ_ONLY;
+            } else if (len != desc->wr_len) {
+                result = CTRL_STATUS_BAD_LENGTH;
+            } else if (len > sizeof(uint32_t)) {
+                result = reg_write_block(reg, value);
+            } else {
+                uint32_t v = value_le(value, len);
+                if (v < desc->min || v > desc->max) {
+                    result = CTRL_STATUS_OUT_OF_RANGE;
+                } else {
+                    reg_write(reg, v);
+                }
+            }
+        } else {
+            result = CTRL_STATUS_BAD_OP;
+        }
+
+        rsp[idx++] = reg;
+        rsp[idx++] = result;
+        rsp[idx++] = out_len;
+        idx += out_len;
+
+        pos += CTRL_OP_HEADER_LEN + len;
+    }
+
+    pkt_ctrl_result_t pkt = {
+        .seq = frame[1],
+        .results = rsp,
+        .results_len = idx
+    };
+    user_pkt_ctrl_result_send(conidx, &pkt);
+}
+
+/**
+ * @brief Answer the legacy GET_STATUS command
+ */
+void user_ctrl_send_status(uint8_t conidx) {
+    pkt_status_t pkt;
+
+    status_get(&pkt);
+    user_pkt_status_send(conidx, &pkt);
+}
+
+/**
+ * @brief Switch operating mode
+ */
+void user_ctrl_set_mode(uint8_t mode) {
+    if (mode <= DEVICE_MODE_MEDICAL) {
+        settings.mode = mode;
+        printf("%s mode selected\n", (mode == DEVICE_MODE_MEDICAL) ? "Medical" : "Gymnastics");
+    }
+}
+
+/**
+ * @brief Queue actions for the sampling loop
+ */
+void user_ctrl_request_action(uint8_t actions) {
+    pending_actions |= actions;
+}
+
+/**
+ * @brief Fetch and clear queued actions
+ */
+uint8_t user_ctrl_take_actions(void) {
+    uint8_t actions = pending_actions;
+    pending_actions = 0;
+    return actions;
+}
+
+/**
+ * @brief Fetch a jump counter written over BLE
+ * @return true if a new value was written since the last call
+ */
+bool user_ctrl_take_jump_count(uint32_t *total_jumps) {
+    if (!jump_count_pending) {
+        return false;
+    }
+
+    *total_jumps = pending_jump_count;
+    jump_count_pending = false;
+    return true;
+}
+
+/**
+ * @brief Look up a register descriptor
+ */
+static const ctrl_reg_desc_t *find_reg(uint8_t reg) {
+    for (uint8_t i = 0; i < REG_TABLE_NB; i++) {
+        if (reg_table[i].reg == reg) {
+            return &reg_table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fill the status packet body (GET_STATUS and CTRL_REG_STATUS)
+ */
+static void status_get(pkt_status_t *pkt) {
+    time_sync_quality_t sync;
+    user_time_sync_get_quality(&sync);
+
+    pkt->mode = settings.mode;
+    pkt->flags = (status.calibrated ? (1 << 0) : 0) |
+                 (status.in_jump ? (1 << 1) : 0) |
+                 (sync.synced ? (1 << 2) : 0) |
+                 (status.off_body ? (1 << 3) : 0);
+    pkt->total_jumps = status.total_jumps;
+    pkt->battery_mv = status.battery_mv;
+}
+
+/**
+ * @brief Encode a register value
+ * @return Number of bytes written
+ */
+static uint8_t reg_read(uint8_t reg, uint8_t *out) {
+    uint8_t idx = 0;
+
+    switch (reg) {
+        case CTRL_REG_STATUS: {
+            pkt_status_t pkt;
+
+            // Same body as the GET_STATUS answer
+            status_get(&pkt);
+            idx += user_pkt_status_put(out, &pkt);
+            break;
+        }
+
+        case CTRL_REG_SCHEMA_VERSION:
+            out[idx++] = PACKET_SCHEMA_VERSION;
+            break;
+
+        case CTRL_REG_JUMP_THRESHOLD:
+            idx += put_le(out, settings.jump_threshold_mg, 2);
+            break;
+
+        case CTRL_REG_LANDING_THRESHOLD:
+            idx += put_le(out, settings.landing_threshold_mg, 2);
+            break;
+
+        case CTRL_REG_SAMPLE_RATE:
+            out[idx++] = settings.sample_rate_hz;
+            break;
+
+        case CTRL_REG_TX_RATE:
+            out[idx++] = settings.tx_rate_hz;
+            break;
+
+        case CTRL_REG_MODE:
+            out[idx++] = settings.mode;
+            break;
+
+        case CTRL_REG_LOG_CURSOR:
+            idx += put_le(out, status.total_jumps, 4);
+            break;
+
+        case CTRL_REG_FALL_ALERT: {
+            fall_stats_t fall;
+            user_fall_get_stats(&fall);
+
+            out[idx++] = fall.state;
+            out[idx++] = fall.alerts;
+            idx += put_le(&out[idx], fall.last_latency_ms, 2);
+            idx += put_le(&out[idx], fall.max_latency_ms, 2);
+            break;
+        }
+
+        case CTRL_REG_PRESSURE_CAL:
+            user_pressure_get_calibration(out);
+            idx = PRESSURE_CAL_LEN;
+            break;
+
+        case CTRL_REG_REP_STATUS:
+            user_reps_get_status(out);
+            idx = REPS_STATUS_LEN;
+            break;
+
+        case CTRL_REG_DIAG_SYSTEM: {
+            time_sync_quality_t sync;
+            user_time_sync_get_quality(&sync);
+
+            int32_t residual = sync.last_residual_us;
+            if (residual > INT16_MAX) {
+                residual = INT16_MAX;
+            } else if (residual < INT16_MIN) {
+                residual = INT16_MIN;
+            }
+
+            idx += put_le(&out[idx], status.uptime_ms / 1000, 4);
+            out[idx++] = user_ble_get_connection_count();
+#if CFG_JUMP_CAPTURE
+            out[idx++] = user_capture_pending();
+#else
+            out[idx++] = 0;
+#endif
+            out[idx++] = sync.samples;
+            idx += put_le(&out[idx], (uint16_t)residual, 2);
+            break;
+        }
+
+        case CTRL_REG_DIAG_MEMORY: {
+            mem_stats_t mem;
+            user_mem_get(&mem);
+
+            idx += put_le(&out[idx], mem.msg_heap_used, 2);
+            idx += put_le(&out[idx], mem.msg_heap_peak, 2);
+            idx += put_le(&out[idx], mem.heap_peak, 2);
+            idx += put_le(&out[idx], mem.stack_peak, 2);
+            idx += put_le(&out[idx], mem.stack_size, 2);
+            idx += put_le(&out[idx], mem.alloc_failures, 2);
+            break;
+        }
+
+        case CTRL_REG_DIAG_WEAR: {
+            wear_stats_t wear;
+            user_wear_get(&wear);
+
+            out[idx++] = wear.off_body ? 1 : 0;
+            idx += put_le(&out[idx], wear.removals, 2);
+            idx += put_le(&out[idx], wear.off_time_s, 4);
+            idx += put_le(&out[idx], wear.saved_permille, 2);
+            idx += put_le(&out[idx], wear.wake_latency_ms, 2);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return idx;
+}
+
+/**
+ * @brief Apply a validated register write
+ */
+static void reg_write(uint8_t reg, uint32_t value) {
+    switch (reg) {
+        case CTRL_REG_ACTION:
+            user_ctrl_request_action((uint8_t)value);
+            break;
+
+        case CTRL_REG_JUMP_THRESHOLD:
+            settings.jump_threshold_mg = (uint16_t)value;
+            break;
+
+        case CTRL_REG_LANDING_THRESHOLD:
+            settings.landing_threshold_mg = (uint16_t)value;
+            break;
+
+        case CTRL_REG_SAMPLE_RATE:
+            settings.sample_rate_hz = (uint8_t)value;
+            break;
+
+        case CTRL_REG_TX_RATE:
+            settings.tx_rate_hz = (uint8_t)value;
+            break;
+
+        case CTRL_REG_MODE:
+            user_ctrl_set_mode((uint8_t)value);
+            break;
+
+        case CTRL_REG_LOG_CURSOR:
+            pending_jump_count = value;
+            jump_count_pending = true;
+            break;
+
+        case CTRL_REG_FALL_ALERT:
+            user_fall_ack();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Apply a register write wider than 4 bytes (validated by the owner)
+ */
+static uint8_t reg_write_block(uint8_t reg, const uint8_t *value) {
+    switch (reg) {
+        case CTRL_REG_PRESSURE_CAL:
+            return user_pressure_set_calibration(value) ? CTRL_STATUS_OK : CTRL_STATUS_OUT_OF_RANGE;
+
+        case CTRL_REG_REP_TEMPLATE:
+            return user_reps_set_template(value) ? CTRL_STATUS_OK : CTRL_STATUS_OUT_OF_RANGE;
+
+        default:
+            return CTRL_STATUS_UNKNOWN_REG;
+    }
+}
+
+/**
+ * @brief Little-endian value of 1 to 4 bytes
+ */
+static uint32_t value_le(const uint8_t *p, uint8_t len) {
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < len && i < 4; i++) {
+        value |= (uint32_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Write a little-endian value of 1 to 4 bytes
+ */
+static uint8_t put_le(uint8_t *out, uint32_t value, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+    return len;
+}
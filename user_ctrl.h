@@ -0,0 +1,90 @@
+/**
+ * @file user_ctrl.h
+ * @brief Batched TLV command/response protocol and configuration registers
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_CTRL_H_
+#define USER_CTRL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame Layout (device control characteristic)
+// Request:  [0x7E][Seq] then per operation [Op][Reg][Len][Value...]
+// Response: [0xDD][0x7E][Seq] then per operation [Reg][Status][Len][Value...]
+#define CTRL_FRAME_HEADER_LEN           2
+#define CTRL_OP_HEADER_LEN              3
+#define CTRL_RESULT_HEADER_LEN          3
+
+// Operations
+#define CTRL_OP_GET                     0x01
+#define CTRL_OP_SET                     0x02
+
+// Registers
+#define CTRL_REG_STATUS                 0x01    // R:  mode, flags, jumps u32, battery u16
+#define CTRL_REG_ACTION                 0x02    // W:  CTRL_ACTION_* bitmask
+#define CTRL_REG_SCHEMA_VERSION         0x03    // R:  notification packet layout version
+#define CTRL_REG_JUMP_THRESHOLD         0x10    // RW: takeoff threshold, mg
+#define CTRL_REG_LANDING_THRESHOLD      0x11    // RW: landing threshold, mg
+#define CTRL_REG_SAMPLE_RATE            0x12    // RW: sensor sampling, Hz
+#define CTRL_REG_TX_RATE                0x13    // RW: sensor notifications, Hz
+#define CTRL_REG_MODE                   0x14    // RW: DEVICE_MODE_*
+#define CTRL_REG_LOG_CURSOR             0x15    // RW: jump counter (write 0 to reset)
+#define CTRL_REG_FALL_ALERT             0x16    // RW: state, alerts, latency ms u16 x2; write 1 (1 byte) = ack
+#define CTRL_REG_PRESSURE_CAL           0x17    // RW: 17 x u16 calibration points, 25 Pa LSB (saved to NVM)
+#define CTRL_REG_REP_TEMPLATE           0x18    // W:  slot, axis, threshold u16, len, 32 x i8 (saved to NVM)
+#define CTRL_REG_REP_STATUS             0x19    // R:  loaded slots, set slot, set reps u16, sets u16
+#define CTRL_REG_DIAG_SYSTEM            0x20    // R:  uptime s u32, connections, captures, sync
+#define CTRL_REG_DIAG_MEMORY            0x21    // R:  heap/stack high-water marks, alloc failures
+#define CTRL_REG_DIAG_WEAR              0x22    // R:  off-body state, removals, off time, duty-cycle saving
+
+// Result Status Codes
+#define CTRL_STATUS_OK                  0x00
+#define CTRL_STATUS_UNKNOWN_REG         0x01
+#define CTRL_STATUS_BAD_LENGTH          0x02
+#define CTRL_STATUS_OUT_OF_RANGE        0x03
+#define CTRL_STATUS_READ_ONLY           0x04
+#define CTRL_STATUS_WRITE_ONLY          0x05
+#define CTRL_STATUS_BAD_OP              0x06
+#define CTRL_STATUS_MALFORMED           0x07    // Reported with register 0xFF
+
+// Actions (CTRL_REG_ACTION, also legacy single byte commands)
+#define CTRL_ACTION_CALIBRATE           (1 << 0)
+#define CTRL_ACTION_RESET_COUNTERS      (1 << 1)
+
+// Device Modes
+#define DEVICE_MODE_GYMNASTICS          0
+#define DEVICE_MODE_MEDICAL             1
+
+// Runtime Settings (written over BLE, read by the sampling loop)
+typedef struct {
+    uint16_t jump_threshold_mg;
+    uint16_t landing_threshold_mg;
+    uint8_t sample_rate_hz;
+    uint8_t tx_rate_hz;
+    uint8_t mode;
+} app_settings_t;
+
+// Live Status (published by the sampling loop)
+typedef struct {
+    uint32_t uptime_ms;
+    uint32_t total_jumps;
+    uint16_t battery_mv;
+    bool calibrated;
+    bool in_jump;
+    bool off_body;
+} app_status_t;
+
+// Function Prototypes
+void user_ctrl_init(void);
+const app_settings_t *user_ctrl_settings(void);
+app_status_t *user_ctrl_status(void);
+void user_ctrl_handle_frame(uint8_t conidx, const uint8_t *frame, uint16_t length);
+void user_ctrl_send_status(uint8_t conidx);
+void user_ctrl_set_mode(uint8_t mode);
+void user_ctrl_request_action(uint8_t actions);
+uint8_t user_ctrl_take_actions(void);
+bool user_ctrl_take_jump_count(uint32_t *total_jumps);
+
+#endif // USER_CTRL_H_
@@ -26,6 +26,12 @@
 #define BATTERY_STATUS_CHAR_UUID        {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF4, \
                                          0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF4}
 
+#define OTA_CONTROL_CHAR_UUID           {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF5, \
+                                         0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF5}
+
+#define OTA_DATA_CHAR_UUID              {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF6, \
+                                         0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF6}
+
 // Service and Characteristic Handles
 enum {
     // Service
@@ -44,12 +50,22 @@ enum {
     // Device Control Characteristic
     CUSTS1_IDX_DEVICE_CONTROL_CHAR,
     CUSTS1_IDX_DEVICE_CONTROL_VAL,
+    CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG,
     
     // Battery Status Characteristic
     CUSTS1_IDX_BATTERY_STATUS_CHAR,
     CUSTS1_IDX_BATTERY_STATUS_VAL,
     CUSTS1_IDX_BATTERY_STATUS_NTF_CFG,
     
+    // OTA Control Characteristic
+    CUSTS1_IDX_OTA_CONTROL_CHAR,
+    CUSTS1_IDX_OTA_CONTROL_VAL,
+    CUSTS1_IDX_OTA_CONTROL_NTF_CFG,
+    
+    // OTA Data Characteristic
+    CUSTS1_IDX_OTA_DATA_CHAR,
+    CUSTS1_IDX_OTA_DATA_VAL,
+    
     CUSTS1_IDX_NB
 };
 
@@ -73,7 +89,7 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
     
     // Sensor Data Value
     [CUSTS1_IDX_SENSOR_DATA_VAL] = {
-        SENSOR_DATA_CHAR_UUID,
+        (uint8_t[])SENSOR_DATA_CHAR_UUID,
         PERM(RD, ENABLE) | PERM(NTF, ENABLE),
         PERM(RI, ENABLE) | PERM_VAL(20),
         0
@@ -97,7 +113,7 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
     
     // Jump Metrics Value
     [CUSTS1_IDX_JUMP_METRICS_VAL] = {
-        JUMP_METRICS_CHAR_UUID,
+        (uint8_t[])JUMP_METRICS_CHAR_UUID,
         PERM(RD, ENABLE) | PERM(NTF, ENABLE),
         PERM(RI, ENABLE) | PERM_VAL(16),
         0
@@ -119,11 +135,19 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
         0
     },
     
-    // Device Control Value
+    // Device Control Value (status responses are notified back)
     [CUSTS1_IDX_DEVICE_CONTROL_VAL] = {
-        DEVICE_CONTROL_CHAR_UUID,
+        (uint8_t[])DEVICE_CONTROL_CHAR_UUID,
+        PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE) | PERM(NTF, ENABLE),
+        PERM(RI, ENABLE) | PERM_VAL(64),
+        0
+    },
+    
+    // Device Control Notification Configuration
+    [CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG] = {
+        (uint8_t*)&att_desc_client_char_cfg_128,
         PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
-        PERM(RI, ENABLE) | PERM_VAL(4),
+        0,
         0
     },
     
@@ -137,9 +161,9 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
     
     // Battery Status Value
     [CUSTS1_IDX_BATTERY_STATUS_VAL] = {
-        BATTERY_STATUS_CHAR_UUID,
+        (uint8_t[])BATTERY_STATUS_CHAR_UUID,
         PERM(RD, ENABLE) | PERM(NTF, ENABLE),
-        PERM(RI, ENABLE) | PERM_VAL(4),
+        PERM(RI, ENABLE) | PERM_VAL(8),
         0
     },
     
@@ -149,6 +173,46 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
         PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
         0,
         0
+    },
+    
+    // OTA Control Characteristic Declaration
+    [CUSTS1_IDX_OTA_CONTROL_CHAR] = {
+        (uint8_t*)&att_decl_char_128,
+        PERM(RD, ENABLE),
+        0,
+        0
+    },
+    
+    // OTA Control Value (start/end/abort, acknowledgements are notified)
+    [CUSTS1_IDX_OTA_CONTROL_VAL] = {
+        (uint8_t[])OTA_CONTROL_CHAR_UUID,
+        PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE) | PERM(NTF, ENABLE),
+        PERM(RI, ENABLE) | PERM_VAL(20),
+        0
+    },
+    
+    // OTA Control Notification Configuration
+    [CUSTS1_IDX_OTA_CONTROL_NTF_CFG] = {
+        (uint8_t*)&att_desc_client_char_cfg_128,
+        PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+        0,
+        0
+    },
+    
+    // OTA Data Characteristic Declaration
+    [CUSTS1_IDX_OTA_DATA_CHAR] = {
+        (uint8_t*)&att_decl_char_128,
+        PERM(RD, ENABLE),
+        0,
+        0
+    },
+    
+    // OTA Data Value (write without response bursts)
+    [CUSTS1_IDX_OTA_DATA_VAL] = {
+        (uint8_t[])OTA_DATA_CHAR_UUID,
+        PERM(WR, ENABLE) | PERM(WRITE_COMMAND, ENABLE),
+        PERM(RI, ENABLE) | PERM_VAL(244),
+        0
     }
 };
 
@@ -159,17 +223,29 @@ static const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] = {
 #define DEVICE_CMD_SET_MODE_GYMNASTICS  0x04
 #define DEVICE_CMD_GET_STATUS           0x05
 #define DEVICE_CMD_SLEEP_MODE           0x06
+#define DEVICE_CMD_TIME_SYNC_REQ        0x07    // [0x07][Seq][T1 u32]
+#define DEVICE_CMD_TIME_SYNC_RESULT     0x08    // [0x08][Seq][T1 u32][T4 u32]
+#define DEVICE_CMD_ALERT_ACK            0x09    // Acknowledge fall alert
+#define DEVICE_CMD_TLV_FRAME            0x7E    // [0x7E][Seq][Op][Reg][Len][Value]...
 
 // Data Packet Headers
+#define DATA_HEADER_ALERT               0xA1
 #define DATA_HEADER_SENSOR              0xAA
 #define DATA_HEADER_JUMP_METRICS        0xBB
+#define DATA_HEADER_GAIT                0xBD
+#define DATA_HEADER_REPS                0xBE
 #define DATA_HEADER_BATTERY             0xCC
 #define DATA_HEADER_STATUS              0xDD
+#define DATA_HEADER_CAPTURE             0xEE
+#define DATA_HEADER_OTA                 0xF0
 
 // Maximum data lengths
-#define MAX_SENSOR_DATA_LEN             20
+#define MAX_SENSOR_DATA_LEN             244     // ATT MTU 247 - 3, jump capture chunks
 #define MAX_JUMP_METRICS_LEN            16
-#define MAX_CONTROL_DATA_LEN            4
-#define MAX_BATTERY_DATA_LEN            4
+#define MAX_CONTROL_DATA_LEN            64      // Frames above 20 bytes need a larger MTU
+#define MAX_STATUS_DATA_LEN             64
+#define MAX_BATTERY_DATA_LEN            8
+#define MAX_OTA_CONTROL_LEN             20
+#define MAX_OTA_DATA_LEN                244     // ATT MTU 247 - 3
 
 #endif // USER_CUSTS1_DEF_H_
\ No newline at end of file
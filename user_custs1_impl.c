@@ -15,10 +15,61 @@
 #include "attm_db.h"
 #include "gapc_task.h"
 #include "arch_console.h"
+#include "app_easy_gap.h"
+#include "user_broadcast.h"
+#include "user_time_sync.h"
+#include "user_ctrl.h"
+#include "user_fall.h"
+#include "user_ota.h"
+#include "user_mem.h"
+#include "user_capture.h"
+#include "gattc.h"
+#include "datasheet.h"
+
+// Notification subscription bits (per connection CCCD state)
+#define NTF_SENSOR_DATA                 (1 << 0)
+#define NTF_JUMP_METRICS                (1 << 1)
+#define NTF_BATTERY_STATUS              (1 << 2)
+#define NTF_DEVICE_CONTROL              (1 << 3)
+#define NTF_OTA_CONTROL                 (1 << 4)
+
+#define ALERT_NONE                      0xFF
+
+// Per-connection state
+typedef struct {
+    bool active;
+    uint8_t ntf_mask;
+    int16_t tx_credits;         // Negative after priority sends past the window
+    uint8_t ctrl_queued;        // Control notifications waiting for their confirm
+    uint8_t alert_ahead;        // Control confirms due before the last alert's, or ALERT_NONE
+} user_conn_t;
+
+// Notification being packed in place (user_custs1_*_alloc, user_custs1_ntf_commit)
+typedef struct {
+    struct custs1_val_ntf_ind_req *req;
+    uint8_t target;
+    uint8_t ntf_bit;
+    bool priority;
+    bool alert;
+    uint8_t queued[CFG_MAX_CONNECTIONS];    // Alert: control notifications queued before it
+} user_ntf_pending_t;
 
 // Global Variables
 static ble_state_t ble_connection_state = BLE_DISCONNECTED;
-static uint8_t connection_idx = 0;
+static user_conn_t connections[CFG_MAX_CONNECTIONS];
+static uint8_t connection_count = 0;
+static user_ntf_pending_t ntf_pending;
+
+// Local Functions
+static void user_custs1_ntf_cfg_update(uint8_t conidx, uint8_t ntf_bit,
+                                       struct custs1_val_write_ind const *param);
+static bool user_custs1_can_notify(uint8_t conidx, uint8_t target, uint8_t ntf_bit, bool priority);
+static struct custs1_val_ntf_ind_req *user_custs1_ntf_msg(uint8_t conidx, uint16_t handle,
+                                                          uint8_t length);
+static uint8_t *user_custs1_ntf_alloc_to(uint8_t target, uint16_t handle, uint8_t ntf_bit,
+                                         uint8_t length, bool priority);
+static uint32_t read_u32_le(const uint8_t *p);
+static void user_custs1_link_setup(uint8_t conidx);
 
 /**
  * @brief Create custom service database
@@ -63,6 +114,9 @@ void user_custs1_val_write_ind_handler(ke_msg_id_t const msgid,
                                        struct custs1_val_write_ind const *param,
                                        ke_task_id_t const dest_id,
                                        ke_task_id_t const src_id) {
+    // Receive timestamp for time sync, taken before any other work
+    uint32_t rx_us = user_get_time_us();
+    
     switch (param->handle) {
         case CUSTS1_IDX_DEVICE_CONTROL_VAL:
             if (param->length > 0) {
@@ -70,27 +124,50 @@ void user_custs1_val_write_ind_handler(ke_msg_id_t const msgid,
                 printf("Control command received: 0x%02X\n", command);
                 
                 switch (command) {
+                    case DEVICE_CMD_TLV_FRAME:
+                        // Batched GET/SET operations, one coalesced response
+                        user_ctrl_handle_frame(param->conidx, param->value, param->length);
+                        break;
+                        
                     case DEVICE_CMD_CALIBRATE:
                         printf("Calibration requested\n");
-                        // Trigger calibration in main loop
+                        user_ctrl_request_action(CTRL_ACTION_CALIBRATE);
                         break;
                         
                     case DEVICE_CMD_RESET_COUNTERS:
                         printf("Reset counters requested\n");
-                        // Reset jump counters
+                        user_ctrl_request_action(CTRL_ACTION_RESET_COUNTERS);
                         break;
                         
                     case DEVICE_CMD_SET_MODE_MEDICAL:
-                        printf("Medical mode selected\n");
+                        user_ctrl_set_mode(DEVICE_MODE_MEDICAL);
                         break;
                         
                     case DEVICE_CMD_SET_MODE_GYMNASTICS:
-                        printf("Gymnastics mode selected\n");
+                        user_ctrl_set_mode(DEVICE_MODE_GYMNASTICS);
                         break;
                         
                     case DEVICE_CMD_GET_STATUS:
                         printf("Status request\n");
-                        // Send current device status
+                        user_ctrl_send_status(param->conidx);
+                        break;
+                        
+                    case DEVICE_CMD_ALERT_ACK:
+                        user_fall_ack();
+                        break;
+                        
+                    case DEVICE_CMD_TIME_SYNC_REQ:
+                        if (param->length >= 6) {
+                            user_time_sync_on_request(param->conidx, param->value[1], rx_us);
+                        }
+                        break;
+                        
+                    case DEVICE_CMD_TIME_SYNC_RESULT:
+                        if (param->length >= 10) {
+                            user_time_sync_on_result(param->conidx, param->value[1],
+                                                     read_u32_le(&param->value[2]),
+                                                     read_u32_le(&param->value[6]));
+                        }
                         break;
                         
                     default:
@@ -100,26 +177,34 @@ void user_custs1_val_write_ind_handler(ke_msg_id_t const msgid,
             }
             break;
             
+#if CFG_OTA
+        case CUSTS1_IDX_OTA_DATA_VAL:
+            user_ota_on_data(param->conidx, param->value, param->length);
+            break;
+            
+        case CUSTS1_IDX_OTA_CONTROL_VAL:
+            user_ota_on_control(param->conidx, param->value, param->length);
+            break;
+            
+        case CUSTS1_IDX_OTA_CONTROL_NTF_CFG:
+            user_custs1_ntf_cfg_update(param->conidx, NTF_OTA_CONTROL, param);
+            break;
+#endif
+            
         case CUSTS1_IDX_SENSOR_DATA_NTF_CFG:
-            if (param->length == 2) {
-                uint16_t ntf_cfg = (param->value[1] << 8) | param->value[0];
-                if (ntf_cfg == PRF_CLI_START_NTF) {
-                    printf("Sensor data notifications enabled\n");
-                } else {
-                    printf("Sensor data notifications disabled\n");
-                }
-            }
+            user_custs1_ntf_cfg_update(param->conidx, NTF_SENSOR_DATA, param);
             break;
             
         case CUSTS1_IDX_JUMP_METRICS_NTF_CFG:
-            if (param->length == 2) {
-                uint16_t ntf_cfg = (param->value[1] << 8) | param->value[0];
-                if (ntf_cfg == PRF_CLI_START_NTF) {
-                    printf("Jump metrics notifications enabled\n");
-                } else {
-                    printf("Jump metrics notifications disabled\n");
-                }
-            }
+            user_custs1_ntf_cfg_update(param->conidx, NTF_JUMP_METRICS, param);
+            break;
+            
+        case CUSTS1_IDX_BATTERY_STATUS_NTF_CFG:
+            user_custs1_ntf_cfg_update(param->conidx, NTF_BATTERY_STATUS, param);
+            break;
+            
+        case CUSTS1_IDX_DEVICE_CONTROL_NTF_CFG:
+            user_custs1_ntf_cfg_update(param->conidx, NTF_DEVICE_CONTROL, param);
             break;
             
         default:
@@ -134,38 +219,93 @@ void user_custs1_val_ntf_cfm_handler(ke_msg_id_t const msgid,
                                      struct custs1_val_ntf_cfm const *param,
                                      ke_task_id_t const dest_id,
                                      ke_task_id_t const src_id) {
-    // Notification was successfully sent
+    // Notification left the queue, return the TX credit to its connection
+    uint8_t conidx = KE_IDX_GET(src_id);
+    
+    if (conidx >= CFG_MAX_CONNECTIONS || !connections[conidx].active) {
+        return;
+    }
+    
+    user_conn_t *conn = &connections[conidx];
+    
+    if (conn->tx_credits < USER_TX_CREDITS) {
+        conn->tx_credits++;
+    }
+    
+    if (param->handle != CUSTS1_IDX_DEVICE_CONTROL_VAL) {
+        return;
+    }
+    
+    if (conn->ctrl_queued > 0) {
+        conn->ctrl_queued--;
+    }
+    
+    // Notifications confirm in order: count down to the alert's own confirm
+    if (conn->alert_ahead == ALERT_NONE) {
+        return;
+    }
+    if (conn->alert_ahead > 0) {
+        conn->alert_ahead--;
+        return;
+    }
+    conn->alert_ahead = ALERT_NONE;
+    
+#if CFG_FALL_DETECTION
+    // Alert handed to the link layer, close the latency measurement
+    user_fall_on_ntf_cfm(user_get_time_us());
+#endif
 }
 
 /**
- * @brief Send sensor data notification
+ * @brief Update CCCD subscription state of one connection
  */
-void user_custs1_sensor_data_send(uint8_t *data, uint8_t length) {
-    if (ble_connection_state != BLE_CONNECTED || length > MAX_SENSOR_DATA_LEN) {
+static void user_custs1_ntf_cfg_update(uint8_t conidx, uint8_t ntf_bit,
+                                       struct custs1_val_write_ind const *param) {
+    if (conidx >= CFG_MAX_CONNECTIONS || param->length != 2) {
         return;
     }
     
-    struct custs1_val_ntf_ind_req *req = KE_MSG_ALLOC_DYN(CUSTS1_VAL_NTF_REQ,
-                                                           prf_get_task_from_id(TASK_ID_CUSTS1),
-                                                           TASK_APP,
-                                                           custs1_val_ntf_ind_req,
-                                                           length);
+    uint16_t ntf_cfg = (param->value[1] << 8) | param->value[0];
+    if (ntf_cfg == PRF_CLI_START_NTF) {
+        connections[conidx].ntf_mask |= ntf_bit;
+    } else {
+        connections[conidx].ntf_mask &= ~ntf_bit;
+    }
     
-    req->conidx = connection_idx;
-    req->handle = CUSTS1_IDX_SENSOR_DATA_VAL;
-    req->length = length;
-    req->notification = true;
+    printf("Conn %d notifications: 0x%02X\n", conidx, connections[conidx].ntf_mask);
+}
+
+/**
+ * @brief Check whether a connection should get a notification now
+ */
+static bool user_custs1_can_notify(uint8_t conidx, uint8_t target, uint8_t ntf_bit, bool priority) {
+    user_conn_t *conn = &connections[conidx];
     
-    memcpy(req->value, data, length);
-    ke_msg_send(req);
+    if (target != CONIDX_ALL && target != conidx) {
+        return false;
+    }
+    
+    if (!conn->active || !(conn->ntf_mask & ntf_bit)) {
+        return false;
+    }
+    
+    // Slow clients drop samples instead of growing the message heap
+    if (conn->tx_credits <= 0 && !priority) {
+        return false;
+    }
+    
+    return true;
 }
 
 /**
- * @brief Send jump metrics notification
+ * @brief Allocate a notification message for one connection and take a TX credit
+ * @return Message with an uninitialised value, NULL when the heap is full
  */
-void user_custs1_jump_metrics_send(uint8_t *data, uint8_t length) {
-    if (ble_connection_state != BLE_CONNECTED || length > MAX_JUMP_METRICS_LEN) {
-        return;
+static struct custs1_val_ntf_ind_req *user_custs1_ntf_msg(uint8_t conidx, uint16_t handle,
+                                                          uint8_t length) {
+    // Full heap drops the packet (counted) rather than asserting in the kernel
+    if (!user_mem_msg_alloc_ok(sizeof(struct custs1_val_ntf_ind_req) + length)) {
+        return NULL;
     }
     
     struct custs1_val_ntf_ind_req *req = KE_MSG_ALLOC_DYN(CUSTS1_VAL_NTF_REQ,
@@ -174,36 +314,247 @@ void user_custs1_jump_metrics_send(uint8_t *data, uint8_t length) {
                                                            custs1_val_ntf_ind_req,
                                                            length);
     
-    req->conidx = connection_idx;
-    req->handle = CUSTS1_IDX_JUMP_METRICS_VAL;
+    req->conidx = conidx;
+    req->handle = handle;
     req->length = length;
     req->notification = true;
     
-    memcpy(req->value, data, length);
-    ke_msg_send(req);
+    // Priority sends also take a credit, so every confirm returns one it took
+    connections[conidx].tx_credits--;
+    if (handle == CUSTS1_IDX_DEVICE_CONTROL_VAL && connections[conidx].ctrl_queued < 0xFF) {
+        connections[conidx].ctrl_queued++;
+    }
+    
+    return req;
 }
 
 /**
- * @brief Send battery status notification
+ * @brief Allocate the message of the first connection that can take a notification
+ * @param priority Send even when the connection has no TX credits left
  */
-void user_custs1_battery_status_send(uint8_t *data, uint8_t length) {
-    if (ble_connection_state != BLE_CONNECTED || length > MAX_BATTERY_DATA_LEN) {
-        return;
+static uint8_t *user_custs1_ntf_alloc_to(uint8_t target, uint16_t handle, uint8_t ntf_bit,
+                                         uint8_t length, bool priority) {
+    if (ble_connection_state != BLE_CONNECTED || ntf_pending.req != NULL) {
+        return NULL;
     }
     
-    struct custs1_val_ntf_ind_req *req = KE_MSG_ALLOC_DYN(CUSTS1_VAL_NTF_REQ,
-                                                           prf_get_task_from_id(TASK_ID_CUSTS1),
-                                                           TASK_APP,
-                                                           custs1_val_ntf_ind_req,
-                                                           length);
+    // The first connection gets the message the packer writes into
+    for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        if (!user_custs1_can_notify(conidx, target, ntf_bit, priority)) {
+            continue;
+        }
+        
+        ntf_pending.req = user_custs1_ntf_msg(conidx, handle, length);
+        if (ntf_pending.req == NULL) {
+            continue;
+        }
+        
+        ntf_pending.target = target;
+        ntf_pending.ntf_bit = ntf_bit;
+        ntf_pending.priority = priority;
+        ntf_pending.alert = false;
+        return ntf_pending.req->value;
+    }
     
-    req->conidx = connection_idx;
-    req->handle = CUSTS1_IDX_BATTERY_STATUS_VAL;
-    req->length = length;
-    req->notification = true;
+    return NULL;
+}
+
+/**
+ * @brief Allocate a notification for a generated packer to fill in place
+ * @param target Single connection index or CONIDX_ALL
+ * @param handle Characteristic value index (sensor, jump, battery or control)
+ * @return Value buffer of length bytes, NULL when no connection can take it.
+ *         Follow with user_custs1_ntf_commit() before any other notification.
+ */
+uint8_t *user_custs1_ntf_alloc(uint8_t target, uint16_t handle, uint8_t length) {
+    uint8_t ntf_bit;
+    uint8_t max_len;
+    
+    switch (handle) {
+        case CUSTS1_IDX_SENSOR_DATA_VAL:
+            ntf_bit = NTF_SENSOR_DATA;
+            max_len = MAX_SENSOR_DATA_LEN;
+            break;
+        case CUSTS1_IDX_JUMP_METRICS_VAL:
+            ntf_bit = NTF_JUMP_METRICS;
+            max_len = MAX_JUMP_METRICS_LEN;
+            break;
+        case CUSTS1_IDX_BATTERY_STATUS_VAL:
+            ntf_bit = NTF_BATTERY_STATUS;
+            max_len = MAX_BATTERY_DATA_LEN;
+            break;
+        case CUSTS1_IDX_DEVICE_CONTROL_VAL:
+            ntf_bit = NTF_DEVICE_CONTROL;
+            max_len = MAX_STATUS_DATA_LEN;
+            break;
+        default:
+            return NULL;
+    }
+    
+    if (length > max_len) {
+        return NULL;
+    }
+    
+    return user_custs1_ntf_alloc_to(target, handle, ntf_bit, length, false);
+}
+
+/**
+ * @brief Allocate an alert on the control characteristic, ahead of all other traffic
+ * @return Value buffer, NULL when no connection can take it; send with
+ *         user_custs1_ntf_commit()
+ */
+uint8_t *user_custs1_alert_alloc(uint8_t length) {
+    uint8_t queued[CFG_MAX_CONNECTIONS];
+    
+    if (length > MAX_STATUS_DATA_LEN) {
+        return NULL;
+    }
+    
+    for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        queued[conidx] = connections[conidx].ctrl_queued;
+    }
+    
+    uint8_t *buf = user_custs1_ntf_alloc_to(CONIDX_ALL, CUSTS1_IDX_DEVICE_CONTROL_VAL,
+                                            NTF_DEVICE_CONTROL, length, true);
+    if (buf != NULL) {
+        ntf_pending.alert = true;
+        memcpy(ntf_pending.queued, queued, sizeof(queued));
+    }
+    return buf;
+}
+
+/**
+ * @brief Allocate an OTA control response (never held back by TX credits)
+ * @return Value buffer, NULL when the connection cannot take it; send with
+ *         user_custs1_ntf_commit()
+ */
+uint8_t *user_custs1_ota_alloc(uint8_t conidx, uint8_t length) {
+    if (length > MAX_OTA_CONTROL_LEN) {
+        return NULL;
+    }
+    
+    return user_custs1_ntf_alloc_to(conidx, CUSTS1_IDX_OTA_CONTROL_VAL, NTF_OTA_CONTROL, length, true);
+}
+
+/**
+ * @brief Send the notification from user_custs1_*_alloc()
+ * @return Number of connections the packet was queued for
+ *
+ * Other subscribed connections get a copy of the packed message; with one
+ * central the packet is never copied.
+ */
+uint8_t user_custs1_ntf_commit(void) {
+    struct custs1_val_ntf_ind_req *req = ntf_pending.req;
+    uint8_t sent = 1;
+    
+    if (req == NULL) {
+        return 0;
+    }
+    ntf_pending.req = NULL;
+    
+    for (uint8_t conidx = req->conidx + 1; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        if (!user_custs1_can_notify(conidx, ntf_pending.target, ntf_pending.ntf_bit, ntf_pending.priority)) {
+            continue;
+        }
+        
+        struct custs1_val_ntf_ind_req *copy = user_custs1_ntf_msg(conidx, req->handle, req->length);
+        if (copy != NULL) {
+            memcpy(copy->value, req->value, req->length);
+            ke_msg_send(copy);
+            sent++;
+        }
+    }
     
-    memcpy(req->value, data, length);
     ke_msg_send(req);
+    
+    // Remember how many control notifications are queued ahead of the alert
+    if (ntf_pending.alert) {
+        for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+            if (connections[conidx].ctrl_queued != ntf_pending.queued[conidx]) {
+                connections[conidx].alert_ahead = ntf_pending.queued[conidx];
+            }
+        }
+    }
+    
+    return sent;
+}
+
+/**
+ * @brief Check that no connection has live notifications backed up
+ */
+bool user_custs1_tx_idle(void) {
+    for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        // One notification in flight is normal streaming, more means backlog
+        if (connections[conidx].active && connections[conidx].tx_credits < USER_TX_CREDITS - 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check that no notification is queued or in flight on any connection
+ */
+bool user_custs1_tx_empty(void) {
+    for (uint8_t conidx = 0; conidx < CFG_MAX_CONNECTIONS; conidx++) {
+        if (connections[conidx].active && connections[conidx].tx_credits < USER_TX_CREDITS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check that the BLE core is not in a radio event (asleep or unclocked)
+ *
+ * Same test as the SDK's ble_is_powered(), inverted.
+ */
+bool user_ble_radio_idle(void) {
+    return GetBits16(CLK_RADIO_REG, BLE_ENABLE) == 0 ||
+           GetBits32(BLE_DEEPSLCNTL_REG, DEEP_SLEEP_STAT) != 0;
+}
+
+/**
+ * @brief Largest notification payload for a connection (ATT MTU - 3)
+ * @param conidx Connection index, or CONIDX_ALL for the smallest over all
+ *        connections (UINT16_MAX with none)
+ */
+uint16_t user_custs1_get_ntf_max(uint8_t conidx) {
+    if (conidx != CONIDX_ALL) {
+        return gattc_get_mtu(conidx) - 3;
+    }
+    
+    uint16_t max = UINT16_MAX;
+    for (uint8_t i = 0; i < CFG_MAX_CONNECTIONS; i++) {
+        if (connections[i].active && gattc_get_mtu(i) - 3 < max) {
+            max = gattc_get_mtu(i) - 3;
+        }
+    }
+    return max;
+}
+
+/**
+ * @brief Read little-endian 32-bit value from a write payload
+ */
+static uint32_t read_u32_le(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Ask for the largest ATT MTU and LE data length the stack supports
+ */
+static void user_custs1_link_setup(uint8_t conidx) {
+    struct gattc_exc_mtu_cmd *cmd = KE_MSG_ALLOC(GATTC_EXC_MTU_CMD,
+                                                 KE_BUILD_ID(TASK_GATTC, conidx),
+                                                 TASK_APP,
+                                                 gattc_exc_mtu_cmd);
+    
+    cmd->operation = GATTC_MTU_EXCH;
+    cmd->seq_num = 0;
+    ke_msg_send(cmd);
+    
+    // 251 byte link layer packets carry a full 244 byte ATT payload in one PDU
+    app_easy_gap_set_data_packet_length(conidx, CFG_MAX_TX_PACKET_LENGTH, USER_DLE_TX_TIME);
 }
 
 /**
@@ -232,18 +583,95 @@ void user_ble_set_state(ble_state_t state) {
     }
 }
 
+/**
+ * @brief Get number of active connections
+ */
+uint8_t user_ble_get_connection_count(void) {
+    return connection_count;
+}
+
+/**
+ * @brief Check if a free connection slot allows advertising
+ */
+bool user_ble_can_advertise(void) {
+    return connection_count < CFG_MAX_CONNECTIONS;
+}
+
 /**
  * @brief Connection event handler
  */
 void user_on_connection(uint8_t conidx, struct gapc_connection_req_ind const *param) {
-    connection_idx = conidx;
+    if (conidx >= CFG_MAX_CONNECTIONS || connections[conidx].active) {
+        return;
+    }
+    
+    // New client starts unsubscribed with a full credit window
+    connections[conidx].active = true;
+    connections[conidx].ntf_mask = 0;
+    connections[conidx].tx_credits = USER_TX_CREDITS;
+    connections[conidx].ctrl_queued = 0;
+    connections[conidx].alert_ahead = ALERT_NONE;
+    connection_count++;
+    
+    printf("Conn %d opened (%d/%d)\n", conidx, connection_count, CFG_MAX_CONNECTIONS);
     user_ble_set_state(BLE_CONNECTED);
+    
+    // Large MTU and data length for TLV frames, captures and OTA bursts
+    user_custs1_link_setup(conidx);
+    
+    // Keep advertising so the next central (e.g. coach tablet) can join
+    if (user_ble_can_advertise()) {
+        app_easy_gap_undirected_advertise_start();
+    }
 }
 
 /**
  * @brief Disconnection event handler
  */
 void user_on_disconnect(struct gapc_disconnect_ind const *param) {
-    user_ble_set_state(BLE_DISCONNECTED);
-    connection_idx = 0;
+    uint8_t conidx = gapc_get_conidx(param->conhdl);
+    
+    if (conidx >= CFG_MAX_CONNECTIONS || !connections[conidx].active) {
+        return;
+    }
+    
+    bool was_full = !user_ble_can_advertise();
+    
+    connections[conidx].active = false;
+    connections[conidx].ntf_mask = 0;
+    connections[conidx].tx_credits = 0;
+    connection_count--;
+    
+    // Another central may take over the shared timebase
+    user_time_sync_on_disconnect(conidx);
+    
+#if CFG_OTA
+    // An interrupted update resumes from its last committed sector
+    user_ota_on_disconnect(conidx);
+#endif
+    
+    printf("Conn %d closed (%d/%d)\n", conidx, connection_count, CFG_MAX_CONNECTIONS);
+    
+    if (connection_count == 0) {
+        user_ble_set_state(BLE_DISCONNECTED);
+#if CFG_JUMP_CAPTURE
+        // A half-sent capture starts over for the next central
+        user_capture_on_disconnect();
+#endif
+    }
+    
+    // Advertising was stopped while all slots were taken
+    if (was_full) {
+        app_easy_gap_undirected_advertise_start();
+    }
+}
+
+/**
+ * @brief Undirected advertising complete handler
+ */
+void user_on_adv_undirect_complete(uint8_t status) {
+#if CFG_ADV_BROADCAST
+    // Restarts advertising when the broadcast interval was changed
+    user_broadcast_on_adv_complete();
+#endif
 }
\ No newline at end of file
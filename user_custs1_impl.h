@@ -7,10 +7,14 @@
 #ifndef USER_CUSTS1_IMPL_H_
 #define USER_CUSTS1_IMPL_H_
 
+#include <stdbool.h>
 #include "ke_msg.h"
 #include "custs1_task.h"
 #include "user_custs1_def.h"
 
+// Notification target meaning every subscribed connection
+#define CONIDX_ALL                      0xFF
+
 // BLE Connection States
 typedef enum {
     BLE_DISCONNECTED = 0,
@@ -41,10 +45,17 @@ void user_custs1_val_ntf_cfm_handler(ke_msg_id_t const msgid,
                                      ke_task_id_t const src_id);
 
 // Application Functions
-void user_custs1_sensor_data_send(uint8_t *data, uint8_t length);
-void user_custs1_jump_metrics_send(uint8_t *data, uint8_t length);
-void user_custs1_battery_status_send(uint8_t *data, uint8_t length);
+uint8_t *user_custs1_ntf_alloc(uint8_t target, uint16_t handle, uint8_t length);
+uint8_t *user_custs1_alert_alloc(uint8_t length);
+uint8_t *user_custs1_ota_alloc(uint8_t conidx, uint8_t length);
+uint8_t user_custs1_ntf_commit(void);
+bool user_custs1_tx_idle(void);
+bool user_custs1_tx_empty(void);
+bool user_ble_radio_idle(void);
+uint16_t user_custs1_get_ntf_max(uint8_t conidx);
 ble_state_t user_ble_get_state(void);
 void user_ble_set_state(ble_state_t state);
+uint8_t user_ble_get_connection_count(void);
+bool user_ble_can_advertise(void);
 
 #endif // USER_CUSTS1_IMPL_H_
\ No newline at end of file
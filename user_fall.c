@@ -0,0 +1,269 @@
+/**
+ * @file user_fall.c
+ * @brief Fall / abnormal impact detector with priority BLE alert
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Free-fall, then a hard impact, raises a SUSPECTED alert straight away so
+ * the impact-to-notification time stays short. The detector then waits for
+ * the body to settle: lying still with the band tilted away from its upright
+ * reference turns it into a CONFIRMED alert that repeats until acknowledged,
+ * any movement sends CANCELLED instead. While an alert is in flight or
+ * unacknowledged the main loop holds back streaming, battery status and
+ * captures.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_fall.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_time_sync.h"
+#include "user_packets.h"
+
+#define MS_TO_US(ms)                    ((uint32_t)(ms) * 1000UL)
+
+// Detector States
+typedef enum {
+    FALL_MONITOR = 0,
+    FALL_FREEFALL,
+    FALL_SETTLE,
+    FALL_STILL,
+    FALL_ALERT
+} fall_state_t;
+
+// Global Variables
+static fall_state_t state = FALL_MONITOR;
+static bool freefall_candidate = false;
+static uint32_t freefall_start_us = 0;
+static uint32_t impact_us = 0;
+static uint16_t peak_mg = 0;
+static int32_t ref_q4[3] = {0, 0, 1000 << 4};  // Upright gravity reference
+static int32_t still_sum[3];
+static uint16_t still_count = 0;
+static uint8_t alert_seq = 0;
+static uint32_t last_alert_us = 0;
+static bool cfm_pending = false;
+static fall_stats_t stats = {0};
+
+// Local Functions
+static void send_alert(uint8_t type, uint32_t now_us);
+static bool is_tilted(void);
+
+/**
+ * @brief Reset detector
+ */
+void user_fall_init(void) {
+    state = FALL_MONITOR;
+    freefall_candidate = false;
+    cfm_pending = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief Run the detector on one sample
+ */
+void user_fall_process(const fall_sample_t *sample) {
+    uint32_t now = sample->time_us;
+    int32_t deviation = (int32_t)sample->accel_mg - 1000;
+    bool still = (deviation < FALL_STILL_TOL_MG && deviation > -FALL_STILL_TOL_MG &&
+                  sample->gyro_l1_dps < FALL_STILL_GYRO_DPS);
+
+    switch (state) {
+        case FALL_MONITOR:
+            if (sample->accel_mg < FALL_FREEFALL_MG) {
+                if (!freefall_candidate) {
+                    freefall_candidate = true;
+                    freefall_start_us = now;
+                } else if ((now - freefall_start_us) >= MS_TO_US(FALL_FREEFALL_MIN_MS)) {
+                    state = FALL_FREEFALL;
+                }
+            } else {
+                freefall_candidate = false;
+
+                // Track the upright orientation while the wearer is calm
+                if (still) {
+                    for (uint8_t i = 0; i < 3; i++) {
+                        ref_q4[i] += (((int32_t)sample->accel[i] << 4) - ref_q4[i]) >> 4;
+                    }
+                }
+            }
+            break;
+
+        case FALL_FREEFALL:
+            if (sample->accel_mg > FALL_IMPACT_MG) {
+                impact_us = now;
+                peak_mg = sample->accel_mg;
+                state = FALL_SETTLE;
+                send_alert(FALL_ALERT_SUSPECTED, now);
+            } else if ((now - freefall_start_us) > MS_TO_US(FALL_IMPACT_WINDOW_MS)) {
+                freefall_candidate = false;
+                state = FALL_MONITOR;
+            }
+            break;
+
+        case FALL_SETTLE:
+            if (sample->accel_mg > peak_mg) {
+                peak_mg = sample->accel_mg;
+            }
+            if ((now - impact_us) >= MS_TO_US(FALL_SETTLE_MS)) {
+                memset(still_sum, 0, sizeof(still_sum));
+                still_count = 0;
+                state = FALL_STILL;
+            }
+            break;
+
+        case FALL_STILL:
+            if (!still) {
+                // Wearer got up or kept moving
+                send_alert(FALL_ALERT_CANCELLED, now);
+                freefall_candidate = false;
+                state = FALL_MONITOR;
+                break;
+            }
+
+            for (uint8_t i = 0; i < 3; i++) {
+                still_sum[i] += sample->accel[i];
+            }
+            still_count++;
+
+            if ((now - impact_us) >= MS_TO_US(FALL_SETTLE_MS + FALL_STILL_MS)) {
+                if (is_tilted()) {
+                    state = FALL_ALERT;
+                    send_alert(FALL_ALERT_CONFIRMED, now);
+                } else {
+                    send_alert(FALL_ALERT_CANCELLED, now);
+                    freefall_candidate = false;
+                    state = FALL_MONITOR;
+                }
+            }
+            break;
+
+        case FALL_ALERT:
+        default:
+            // Held until acknowledged
+            break;
+    }
+
+    stats.state = (uint8_t)state;
+}
+
+/**
+ * @brief Repeat an unacknowledged alert
+ */
+void user_fall_poll(uint32_t now_us) {
+    if (state == FALL_ALERT && (now_us - last_alert_us) >= MS_TO_US(FALL_ALERT_REPEAT_MS)) {
+        send_alert(FALL_ALERT_CONFIRMED, now_us);
+    }
+}
+
+/**
+ * @brief Confirm of the last alert notification (matched by user_custs1_impl.c)
+ */
+void user_fall_on_ntf_cfm(uint32_t now_us) {
+    if (!cfm_pending) {
+        return;
+    }
+    cfm_pending = false;
+
+    // Impact sample to notification handed to the link layer
+    uint32_t latency_ms = (now_us - impact_us) / 1000;
+    if (latency_ms > 0xFFFF) {
+        latency_ms = 0xFFFF;
+    }
+
+    stats.last_latency_ms = (uint16_t)latency_ms;
+    if (stats.last_latency_ms > stats.max_latency_ms) {
+        stats.max_latency_ms = stats.last_latency_ms;
+    }
+
+    if (latency_ms > FALL_LATENCY_TARGET_MS) {
+        printf("Fall alert latency %lums over target\n", (unsigned long)latency_ms);
+    }
+}
+
+/**
+ * @brief Acknowledge a confirmed alert
+ */
+void user_fall_ack(void) {
+    if (state == FALL_ALERT) {
+        printf("Fall alert acknowledged\n");
+        freefall_candidate = false;
+        state = FALL_MONITOR;
+        stats.state = (uint8_t)state;
+    }
+}
+
+/**
+ * @brief A fall is being tracked: from free-fall until cancelled or acknowledged
+ */
+bool user_fall_in_progress(void) {
+    return state != FALL_MONITOR || cfm_pending;
+}
+
+/**
+ * @brief Alert traffic has priority over everything else
+ */
+bool user_fall_alert_active(void) {
+    return cfm_pending || state == FALL_ALERT;
+}
+
+/**
+ * @brief Copy alert statistics
+ */
+void user_fall_get_stats(fall_stats_t *out) {
+    *out = stats;
+}
+
+/**
+ * @brief Notify all connections, ignoring TX credits
+ */
+static void send_alert(uint8_t type, uint32_t now_us) {
+    pkt_alert_t pkt = {
+        .type = type,
+        .seq = alert_seq++,
+        .impact_time = user_time_sync_to_shared(impact_us),
+        .peak_mg = peak_mg
+    };
+
+    uint8_t sent = user_pkt_alert_send(&pkt);
+    last_alert_us = now_us;
+
+    if (type == FALL_ALERT_SUSPECTED) {
+        // Latency is only measurable if a central got the alert
+        cfm_pending = (sent > 0);
+        if (stats.alerts < 0xFF) {
+            stats.alerts++;
+        }
+    }
+
+    printf("Fall alert type %d\n", type);
+}
+
+/**
+ * @brief Compare resting orientation with the upright reference
+ */
+static bool is_tilted(void) {
+    if (still_count == 0) {
+        return false;
+    }
+
+    // Quarter-mg units keep the squared terms inside 64 bits
+    int32_t now[3];
+    int32_t ref[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        now[i] = (still_sum[i] / still_count) >> 2;
+        ref[i] = ref_q4[i] >> 6;
+    }
+
+    int64_t dot = (int64_t)now[0] * ref[0] + (int64_t)now[1] * ref[1] + (int64_t)now[2] * ref[2];
+    if (dot <= 0) {
+        return true;
+    }
+
+    uint64_t now_sq = (uint64_t)((int64_t)now[0] * now[0] + (int64_t)now[1] * now[1] + (int64_t)now[2] * now[2]);
+    uint64_t ref_sq = (uint64_t)((int64_t)ref[0] * ref[0] + (int64_t)ref[1] * ref[1] + (int64_t)ref[2] * ref[2]);
+
+    // cos(angle) < threshold, compared squared to avoid sqrt
+    return ((uint64_t)dot * (uint64_t)dot * 1000000ULL) <
+           ((uint64_t)FALL_TILT_COS_PERMILLE * FALL_TILT_COS_PERMILLE * now_sq * ref_sq);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file user_fall.h
+ * @brief Fall / abnormal impact detector with priority BLE alert
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_FALL_H_
+#define USER_FALL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Detection Parameters
+#define FALL_FREEFALL_MG                500     // Below this the body is falling
+#define FALL_FREEFALL_MIN_MS            60
+#define FALL_IMPACT_MG                  3000
+#define FALL_IMPACT_WINDOW_MS           800     // Impact must follow free-fall within this
+#define FALL_SETTLE_MS                  500     // Bounce after impact, not checked
+#define FALL_STILL_MS                   2000    // Stillness needed to confirm
+#define FALL_STILL_TOL_MG               200     // |a| within 1g +/- this
+#define FALL_STILL_GYRO_DPS             60      // |gx|+|gy|+|gz| below this
+#define FALL_TILT_COS_PERMILLE          707     // Orientation change above 45 degrees
+#define FALL_ALERT_REPEAT_MS            1000
+#define FALL_LATENCY_TARGET_MS          200
+
+// Alert Types (alert packet, tools/packets.json)
+#define FALL_ALERT_SUSPECTED            0x01    // Free-fall + impact, sent at once
+#define FALL_ALERT_CONFIRMED            0x02    // Stillness + tilt, repeated until ack
+#define FALL_ALERT_CANCELLED            0x03    // Movement resumed after a suspected fall
+
+// Input Sample
+typedef struct {
+    uint32_t time_us;       // Local time of the sample
+    int16_t accel[3];       // mg
+    uint16_t accel_mg;      // Magnitude
+    uint16_t gyro_l1_dps;   // |gx| + |gy| + |gz|
+} fall_sample_t;
+
+// Alert Statistics
+typedef struct {
+    uint8_t state;
+    uint8_t alerts;
+    uint16_t last_latency_ms;
+    uint16_t max_latency_ms;
+} fall_stats_t;
+
+// Function Prototypes
+void user_fall_init(void);
+void user_fall_process(const fall_sample_t *sample);
+void user_fall_poll(uint32_t now_us);
+void user_fall_on_ntf_cfm(uint32_t now_us);
+void user_fall_ack(void);
+bool user_fall_alert_active(void);
+bool user_fall_in_progress(void);
+void user_fall_get_stats(fall_stats_t *stats);
+
+#endif // USER_FALL_H_
@@ -0,0 +1,206 @@
+/**
+ * @file user_gait.c
+ * @brief Streaming gait event detection and step analytics (medical mode)
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Foot contact comes from the pressure ADC with thresholds that follow a
+ * slowly decaying min/max envelope, so no per-patient calibration is needed.
+ * Heel strike is dated by the IMU impact when one is seen just before the
+ * pressure rise, toe-off by the pressure release. Everything per sample is
+ * integer and loop-free; division and sqrt only run once per summary.
+ * The band sees one leg, so steps are counted as two per stride.
+ */
+
+#include <string.h>
+#include "user_gait.h"
+#include "user_config.h"
+
+// Envelope in Q4 pressure units
+#define Q4(x)                           ((int32_t)(x) << 4)
+
+// Global Variables
+static bool in_stance = false;
+static bool have_hs = false;
+static uint32_t last_hs_ms = 0;
+static uint32_t last_to_ms = 0;
+static uint32_t last_impact_ms = 0;
+static int32_t p_max = 0;
+static int32_t p_min = 0;
+
+// Accumulators for the current summary period
+static uint32_t period_start_ms = 0;
+static uint16_t period_index = 0;
+static uint16_t strides = 0;
+static uint16_t stance_count = 0;
+static uint32_t stance_sum = 0;
+static uint32_t swing_sum = 0;
+static uint32_t stride_sum = 0;
+static uint32_t stride_sq_sum = 0;
+static uint32_t total_steps = 0;
+
+static gait_summary_t summary;
+static bool summary_ready = false;
+
+// Local Functions
+static void close_period(void);
+static uint32_t isqrt32(uint32_t value);
+
+/**
+ * @brief Reset detector state and start a new summary period
+ */
+void user_gait_init(uint32_t now_ms) {
+    in_stance = false;
+    have_hs = false;
+    last_impact_ms = now_ms - GAIT_HS_IMPACT_WINDOW_MS - 1;
+    last_to_ms = now_ms;
+    p_max = 0;
+    p_min = 0;
+
+    period_start_ms = now_ms;
+    period_index = 0;
+    strides = 0;
+    stance_count = 0;
+    stance_sum = 0;
+    swing_sum = 0;
+    stride_sum = 0;
+    stride_sq_sum = 0;
+    total_steps = 0;
+    summary_ready = false;
+}
+
+/**
+ * @brief Process one sample (constant time)
+ */
+void user_gait_process(const gait_sample_t *sample) {
+    uint32_t now = sample->time_ms;
+    int32_t p = Q4(sample->pressure);
+
+    // Envelope: jump to new extremes, decay slowly toward the signal
+    if (p > p_max) {
+        p_max = p;
+    } else {
+        p_max -= (p_max - p) >> GAIT_ENVELOPE_DECAY_SHIFT;
+    }
+    if (p < p_min) {
+        p_min = p;
+    } else {
+        p_min += (p - p_min) >> GAIT_ENVELOPE_DECAY_SHIFT;
+    }
+
+    if (sample->accel_mg > GAIT_HS_ACCEL_MG) {
+        last_impact_ms = now;
+    }
+
+    int32_t range = p_max - p_min;
+
+    // Flat pressure: band not loaded/unloaded, no contact decisions
+    if (range >= Q4(GAIT_MIN_PRESSURE_RANGE)) {
+        int32_t on_level = p_min + ((range * 5) >> 3);
+        int32_t off_level = p_min + ((range * 3) >> 3);
+
+        if (!in_stance && p > on_level && (now - last_to_ms) >= GAIT_MIN_SWING_MS) {
+            // Heel strike
+            uint32_t hs = ((now - last_impact_ms) <= GAIT_HS_IMPACT_WINDOW_MS) ? last_impact_ms : now;
+            uint32_t stride = hs - last_hs_ms;
+
+            if (have_hs && stride <= GAIT_MAX_STRIDE_MS) {
+                strides++;
+                stride_sum += stride;
+                stride_sq_sum += stride * stride;
+                swing_sum += hs - last_to_ms;
+                total_steps += 2;
+            }
+
+            in_stance = true;
+            have_hs = true;
+            last_hs_ms = hs;
+        } else if (in_stance && p < off_level && (now - last_hs_ms) >= GAIT_MIN_STANCE_MS) {
+            // Toe-off
+            in_stance = false;
+            last_to_ms = now;
+            stance_count++;
+            stance_sum += now - last_hs_ms;
+        }
+    }
+
+    if ((now - period_start_ms) >= GAIT_SUMMARY_PERIOD_MS) {
+        close_period();
+        period_start_ms = now;
+    }
+}
+
+/**
+ * @brief Fetch a finished per-minute summary
+ * @return true if a new summary was available
+ */
+bool user_gait_take_summary(gait_summary_t *out) {
+    if (!summary_ready) {
+        return false;
+    }
+
+    *out = summary;
+    summary_ready = false;
+    return true;
+}
+
+/**
+ * @brief Turn the accumulators into a summary and clear them
+ */
+static void close_period(void) {
+    memset(&summary, 0, sizeof(summary));
+
+    summary.minute = period_index++;
+    summary.steps = strides * 2;
+    summary.cadence_spm = (summary.steps > 0xFF) ? 0xFF : (uint8_t)summary.steps;
+    summary.total_steps = total_steps;
+
+    if (stance_count > 0) {
+        summary.stance_ms = (uint16_t)(stance_sum / stance_count);
+    }
+
+    if (strides > 0) {
+        uint32_t mean = stride_sum / strides;
+
+        summary.swing_ms = (uint16_t)(swing_sum / strides);
+        summary.stride_ms = (uint16_t)mean;
+
+        // Population variance from sums; 64-bit because sum^2 overflows
+        uint64_t sq_mean = ((uint64_t)stride_sum * stride_sum) / strides;
+        uint32_t var = (stride_sq_sum > sq_mean) ? (uint32_t)((stride_sq_sum - sq_mean) / strides) : 0;
+
+        if (mean > 0) {
+            summary.stride_cv = (uint16_t)((isqrt32(var) * 1000) / mean);
+        }
+    }
+
+    strides = 0;
+    stance_count = 0;
+    stance_sum = 0;
+    swing_sum = 0;
+    stride_sum = 0;
+    stride_sq_sum = 0;
+    summary_ready = true;
+}
+
+/**
+ * @brief Integer square root
+ */
+static uint32_t isqrt32(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
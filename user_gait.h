@@ -0,0 +1,46 @@
+/**
+ * @file user_gait.h
+ * @brief Streaming gait event detection and step analytics (medical mode)
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_GAIT_H_
+#define USER_GAIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Detection Parameters
+#define GAIT_HS_ACCEL_MG                1300    // Heel strike impact on the IMU
+#define GAIT_HS_IMPACT_WINDOW_MS        100     // Impact this close to pressure rise dates the HS
+#define GAIT_MIN_STANCE_MS              150
+#define GAIT_MIN_SWING_MS               200
+#define GAIT_MAX_STRIDE_MS              3000    // Longer gaps start a new walking bout
+#define GAIT_ENVELOPE_DECAY_SHIFT       9       // Pressure min/max decay (~5s at 100Hz)
+#define GAIT_SUMMARY_PERIOD_MS          60000
+
+// Input Sample
+typedef struct {
+    uint32_t time_ms;
+    uint16_t accel_mg;      // Acceleration magnitude
+    uint16_t pressure;      // 25 Pa per LSB, thresholds adapt to the range
+} gait_sample_t;
+
+// Per-Minute Summary (sent as the gait packet, tools/packets.json)
+typedef struct {
+    uint16_t minute;
+    uint16_t steps;
+    uint8_t cadence_spm;
+    uint16_t stance_ms;     // Mean
+    uint16_t swing_ms;      // Mean
+    uint16_t stride_ms;     // Mean
+    uint16_t stride_cv;     // Stride time variability, 0.1% units
+    uint32_t total_steps;
+} gait_summary_t;
+
+// Function Prototypes
+void user_gait_init(uint32_t now_ms);
+void user_gait_process(const gait_sample_t *sample);
+bool user_gait_take_summary(gait_summary_t *summary);
+
+#endif // USER_GAIT_H_
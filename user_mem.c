@@ -0,0 +1,136 @@
+/**
+ * @file user_mem.c
+ * @brief Kernel heap and stack high-water marks
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The unused part of the stack is filled with a pattern at boot; the stack
+ * peak is the highest word that no longer holds it. Heap figures come from
+ * the kernel allocator (KE_PROFILING builds): the all-heaps peak is the
+ * kernel's own high-water mark, which sees every allocation including the
+ * stack's. The kernel keeps no per-heap peak, so the message heap peak
+ * (message heap plus the non-retained heap it overflows into) is sampled at
+ * every app allocation and main loop pass. Every notification checks for
+ * room in the message heap first, so a full heap costs one dropped packet
+ * and a counter increment instead of a kernel assert.
+ */
+
+#include <stdio.h>
+#include "user_mem.h"
+#include "user_config.h"
+#include "rwip_config.h"
+#include "ke_msg.h"
+#include "ke_mem.h"
+#include "arch.h"
+
+#define STACK_PAINT                     0xA5A5A5A5u
+#define STACK_PAINT_MARGIN              32      // Words left alone below the live SP
+
+// Top of stack from the startup file
+extern uint32_t __initial_sp[];
+
+// Global Variables
+static uint32_t *stack_base = NULL;
+static uint32_t *stack_top = NULL;
+static uint16_t msg_heap_peak = 0;
+static uint32_t heap_peak = 0;
+static uint16_t alloc_failures = 0;
+
+// Local Functions
+static uint16_t msg_heap_used(void);
+
+/**
+ * @brief Paint the unused stack (call first thing after boot)
+ */
+void user_mem_init(void) {
+    stack_top = __initial_sp;
+    stack_base = stack_top - (USER_STACK_SIZE / sizeof(uint32_t));
+
+    uint32_t *sp = (uint32_t *)(uintptr_t)__get_MSP() - STACK_PAINT_MARGIN;
+    for (uint32_t *p = stack_base; p < sp; p++) {
+        *p = STACK_PAINT;
+    }
+}
+
+/**
+ * @brief Check for room in the message heap before a KE_MSG_ALLOC_DYN
+ * @return false if the allocation would fail (counted)
+ */
+bool user_mem_msg_alloc_ok(uint16_t param_size) {
+    if (!ke_check_malloc(param_size + sizeof(struct ke_msg), KE_MEM_KE_MSG)) {
+        alloc_failures++;
+        return false;
+    }
+
+#if KE_PROFILING
+    uint16_t used = msg_heap_used() + param_size + sizeof(struct ke_msg);
+    if (used > msg_heap_peak) {
+        msg_heap_peak = used;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Sample the heaps (main loop, and before every report)
+ */
+void user_mem_poll(void) {
+#if KE_PROFILING
+    uint16_t used = msg_heap_used();
+    if (used > msg_heap_peak) {
+        msg_heap_peak = used;
+    }
+
+    // The kernel clears its peak on every read
+    uint32_t peak = ke_get_max_mem_usage();
+    if (peak > heap_peak) {
+        heap_peak = peak;
+    }
+#endif
+}
+
+/**
+ * @brief Current heap use and high-water marks
+ */
+void user_mem_get(mem_stats_t *stats) {
+    uint32_t *p = stack_base;
+
+    // First word that lost the paint is the deepest the stack has been
+    while (p != NULL && p < stack_top && *p == STACK_PAINT) {
+        p++;
+    }
+
+    user_mem_poll();
+#if KE_PROFILING
+    stats->msg_heap_used = msg_heap_used();
+#else
+    stats->msg_heap_used = 0;
+#endif
+    stats->msg_heap_peak = msg_heap_peak;
+    stats->heap_peak = (heap_peak > 0xFFFF) ? 0xFFFF : (uint16_t)heap_peak;
+    stats->stack_peak = (uint16_t)((stack_top - p) * sizeof(uint32_t));
+    stats->stack_size = USER_STACK_SIZE;
+    stats->alloc_failures = alloc_failures;
+}
+
+/**
+ * @brief Message heap in use, with its overflow into the non-retained heap
+ */
+static uint16_t msg_heap_used(void) {
+#if KE_PROFILING
+    return ke_get_mem_usage(KE_MEM_KE_MSG) + ke_get_mem_usage(KE_MEM_NON_RETENTION);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Print memory high-water marks
+ */
+void user_mem_report(void) {
+    mem_stats_t stats;
+    user_mem_get(&stats);
+
+    printf("MEM msg heap %d (peak %d), heaps peak %d, stack %d/%d, alloc fail %d\n",
+           stats.msg_heap_used, stats.msg_heap_peak, stats.heap_peak,
+           stats.stack_peak, stats.stack_size, stats.alloc_failures);
+}
@@ -0,0 +1,30 @@
+/**
+ * @file user_mem.h
+ * @brief Kernel heap and stack high-water marks
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_MEM_H_
+#define USER_MEM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Memory Statistics (bytes)
+typedef struct {
+    uint16_t msg_heap_used;     // Kernel message + non-retained heap now
+    uint16_t msg_heap_peak;     // Same, highest value sampled (app allocations, main loop)
+    uint16_t heap_peak;         // All kernel heaps together, kernel high-water mark
+    uint16_t stack_peak;        // Deepest stack use since boot (painted)
+    uint16_t stack_size;
+    uint16_t alloc_failures;    // Messages not sent because the heap was full
+} mem_stats_t;
+
+// Function Prototypes
+void user_mem_init(void);
+bool user_mem_msg_alloc_ok(uint16_t param_size);
+void user_mem_poll(void);
+void user_mem_get(mem_stats_t *stats);
+void user_mem_report(void);
+
+#endif // USER_MEM_H_
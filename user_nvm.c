@@ -0,0 +1,124 @@
+/**
+ * @file user_nvm.c
+ * @brief Record storage in reserved SPI flash sectors
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Header: [Magic u16][Record][Version][Length u16][CRC32 u32], payload follows.
+ * A record is only returned when magic, version, length and CRC all match,
+ * so an interrupted write reads back as "no record" and defaults are used.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_nvm.h"
+#include "user_config.h"
+#include "spi_flash.h"
+
+// Nibble-wise CRC32 (IEEE 802.3), 64 byte table instead of 1KB
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * @brief Update a running CRC32 (start with 0)
+ */
+uint32_t user_nvm_crc32(uint32_t crc, const uint8_t *data, uint32_t length) {
+    crc = ~crc;
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Read and validate a record
+ * @return true if a valid record of exactly this version and length was found
+ */
+bool user_nvm_read(nvm_record_t record, uint8_t version, void *data, uint16_t length) {
+    uint8_t header[NVM_HEADER_LEN];
+    uint32_t addr = NVM_BASE_ADDR + (uint32_t)record * NVM_SECTOR_SIZE;
+    uint32_t actual = 0;
+
+    if (record >= NVM_SECTOR_COUNT || length > NVM_MAX_PAYLOAD) {
+        return false;
+    }
+
+    spi_flash_release_from_power_down();
+
+    bool valid = (spi_flash_read_data(header, addr, NVM_HEADER_LEN, &actual) == SPI_FLASH_ERR_OK) &&
+                 (header[0] | (header[1] << 8)) == NVM_RECORD_MAGIC &&
+                 header[2] == (uint8_t)record &&
+                 header[3] == version &&
+                 (header[4] | (header[5] << 8)) == length &&
+                 spi_flash_read_data(data, addr + NVM_HEADER_LEN, length, &actual) == SPI_FLASH_ERR_OK;
+
+    spi_flash_power_down();
+
+    if (valid) {
+        uint32_t crc = (uint32_t)header[6] | ((uint32_t)header[7] << 8) |
+                       ((uint32_t)header[8] << 16) | ((uint32_t)header[9] << 24);
+        valid = (user_nvm_crc32(0, data, length) == crc);
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Erase the record sector and write a new record
+ */
+bool user_nvm_write(nvm_record_t record, uint8_t version, const void *data, uint16_t length) {
+    uint8_t header[NVM_HEADER_LEN];
+    uint32_t addr = NVM_BASE_ADDR + (uint32_t)record * NVM_SECTOR_SIZE;
+    uint32_t crc = user_nvm_crc32(0, data, length);
+    uint32_t actual = 0;
+
+    if (record >= NVM_SECTOR_COUNT || length > NVM_MAX_PAYLOAD) {
+        return false;
+    }
+
+    header[0] = (uint8_t)(NVM_RECORD_MAGIC & 0xFF);
+    header[1] = (uint8_t)(NVM_RECORD_MAGIC >> 8);
+    header[2] = (uint8_t)record;
+    header[3] = version;
+    header[4] = (uint8_t)(length & 0xFF);
+    header[5] = (uint8_t)(length >> 8);
+    header[6] = (uint8_t)(crc & 0xFF);
+    header[7] = (uint8_t)((crc >> 8) & 0xFF);
+    header[8] = (uint8_t)((crc >> 16) & 0xFF);
+    header[9] = (uint8_t)((crc >> 24) & 0xFF);
+
+    spi_flash_release_from_power_down();
+
+    // Payload first, header last: a partial write never looks valid
+    bool ok = spi_flash_block_erase(addr, SPI_FLASH_OP_SE) == SPI_FLASH_ERR_OK &&
+              spi_flash_write_data((uint8_t *)data, addr + NVM_HEADER_LEN, length, &actual) == SPI_FLASH_ERR_OK &&
+              spi_flash_write_data(header, addr, NVM_HEADER_LEN, &actual) == SPI_FLASH_ERR_OK;
+
+    spi_flash_power_down();
+
+    if (!ok) {
+        printf("NVM write failed: record %d\n", record);
+    }
+    return ok;
+}
+
+/**
+ * @brief Erase a record (reads back as "no record")
+ */
+bool user_nvm_erase(nvm_record_t record) {
+    if (record >= NVM_SECTOR_COUNT) {
+        return false;
+    }
+
+    spi_flash_release_from_power_down();
+    bool ok = spi_flash_block_erase(NVM_BASE_ADDR + (uint32_t)record * NVM_SECTOR_SIZE,
+                                    SPI_FLASH_OP_SE) == SPI_FLASH_ERR_OK;
+    spi_flash_power_down();
+
+    return ok;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file user_nvm.h
+ * @brief Record storage in reserved SPI flash sectors
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_NVM_H_
+#define USER_NVM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// One 4KB sector per record, at the top of the SPI flash (user_config.h)
+#define NVM_SECTOR_SIZE                 4096
+#define NVM_RECORD_MAGIC                0xAB52
+#define NVM_HEADER_LEN                  10
+#define NVM_MAX_PAYLOAD                 (NVM_SECTOR_SIZE - NVM_HEADER_LEN)
+
+// Record IDs (sector index from NVM_BASE_ADDR, at most NVM_SECTOR_COUNT)
+typedef enum {
+    NVM_RECORD_PRESSURE_CAL = 0,
+    NVM_RECORD_OTA_RESUME,
+    NVM_RECORD_SESSION_LOG,
+    NVM_RECORD_REP_TEMPLATES,
+    NVM_RECORD_OTA_RESUME_ALT,  // Resume points alternate with NVM_RECORD_OTA_RESUME
+    NVM_RECORD_NB
+} nvm_record_t;
+
+// Function Prototypes
+bool user_nvm_read(nvm_record_t record, uint8_t version, void *data, uint16_t length);
+bool user_nvm_write(nvm_record_t record, uint8_t version, const void *data, uint16_t length);
+bool user_nvm_erase(nvm_record_t record);
+uint32_t user_nvm_crc32(uint32_t crc, const uint8_t *data, uint32_t length);
+
+#endif // USER_NVM_H_
@@ -0,0 +1,544 @@
+/**
+ * @file user_ota.c
+ * @brief Resumable over-the-air image update into the inactive flash bank
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The host streams the SDK .img file (64 byte image header + code) as write
+ * without response packets tagged with their file offset, and waits for an
+ * acknowledgement every OTA_ACK_WINDOW packets. Packets are programmed as they
+ * arrive and the CRC32 is updated on the same bytes, so END needs no read
+ * back. Each completed 4KB sector is a commit point stored in NVM: after a
+ * disconnect or reset, START with the same size and CRC continues from the
+ * last committed sector. Commit points alternate between two records, so a
+ * reset while one is rewritten (erase, then write) still finds the one
+ * before it.
+ *
+ * Sector erases (image sectors and the NVM resume record) block for tens of
+ * ms, so the BLE write handlers never erase: user_ota_poll() in the main loop
+ * keeps the image erased one sector ahead of the write position and saves
+ * the resume points. START is answered once the first sector is erased; data
+ * that reaches a sector not erased yet is dropped and the poll acknowledges
+ * with the offset to continue from. The image header's valid flag and id are left
+ * erased until END has matched the CRC, so the bootloader never selects a
+ * partial image.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_ota.h"
+#include "user_config.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_time_sync.h"
+#include "user_nvm.h"
+#include "user_packets.h"
+#include "spi_flash.h"
+#include "arch.h"
+
+// SDK Image Header (start of each bank, read by the secondary bootloader)
+#define IMG_HEADER_LEN                  64
+#define IMG_SIGNATURE_0                 0x70
+#define IMG_SIGNATURE_1                 0x51
+#define IMG_VALID_OFFSET                2       // Valid flag, then image id
+#define IMG_VALID                       0xAA
+
+#define OTA_RESUME_VERSION              1
+#define OTA_NO_OWNER                    0xFF
+#define OTA_RESUME_SLOTS                2
+#define OTA_ERASE_AHEAD                 (2 * NVM_SECTOR_SIZE)   // Erased room past the write sector start
+#define SECTOR_ALIGN_UP(x)              (((x) + NVM_SECTOR_SIZE - 1) & ~(uint32_t)(NVM_SECTOR_SIZE - 1))
+
+// Resume Point (NVM record)
+typedef struct {
+    uint32_t size;
+    uint32_t image_crc;
+    uint32_t bank_addr;
+    uint32_t committed;     // Bytes known to be in flash (sector aligned or complete)
+    uint32_t crc;           // CRC32 of bytes [0, committed)
+} ota_resume_t;
+
+// Global Variables
+static uint8_t owner = OTA_NO_OWNER;
+static ota_resume_t resume;
+static uint32_t next_offset = 0;
+static uint32_t running_crc = 0;
+static uint8_t new_image_id = 0;
+static uint8_t packets_since_ack = 0;
+static bool nack_sent = false;
+static bool verified = false;
+static uint32_t session_start_us = 0;
+static uint32_t session_bytes = 0;
+
+// Flash work deferred to user_ota_poll()
+static uint32_t erased_end = 0;         // Image bytes [0, erased_end) erased this session
+static bool start_pending = false;      // START answered after the first erase
+static bool stalled = false;            // Data dropped at erased_end, ack once erased
+static bool commit_pending = false;
+static uint32_t commit_offset = 0;
+static uint32_t commit_crc = 0;
+static uint8_t resume_slot = 0;         // Record holding the newest commit
+static uint8_t resume_erase_pending = 0;    // Records to erase, one bit per slot
+
+static const nvm_record_t resume_records[OTA_RESUME_SLOTS] = {
+    NVM_RECORD_OTA_RESUME,
+    NVM_RECORD_OTA_RESUME_ALT
+};
+
+// Local Functions
+static uint32_t ota_target_bank(uint8_t *image_id);
+static bool ota_read_resume(uint32_t size, uint32_t image_crc, uint32_t bank);
+static bool ota_program(const uint8_t *data, uint32_t length);
+static void ota_commit(void);
+static void ota_start_reply(void);
+static void ota_drop_resume(void);
+static void ota_reply(uint8_t conidx, uint8_t cmd, uint8_t status);
+static void ota_ack(uint8_t conidx, uint8_t status);
+static uint32_t read_u32_le(const uint8_t *p);
+
+/**
+ * @brief Start with no session (only the NVM resume point outlives a reset) and report it
+ */
+void user_ota_init(void) {
+    owner = OTA_NO_OWNER;
+    verified = false;
+    erased_end = 0;
+    start_pending = false;
+    stalled = false;
+    commit_pending = false;
+    resume_erase_pending = 0;
+
+    if (ota_read_resume(0, 0, 0)) {
+        printf("OTA resume point: %lu/%lu bytes\n",
+               (unsigned long)resume.committed, (unsigned long)resume.size);
+    }
+}
+
+/**
+ * @brief Handle a write to the OTA control characteristic
+ */
+void user_ota_on_control(uint8_t conidx, const uint8_t *data, uint16_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    if (owner != OTA_NO_OWNER && owner != conidx) {
+        ota_reply(conidx, data[0], OTA_STATUS_BUSY);
+        return;
+    }
+
+    switch (data[0]) {
+        case OTA_CMD_START: {
+            if (length < 9) {
+                ota_reply(conidx, OTA_CMD_START, OTA_STATUS_BAD_SIZE);
+                return;
+            }
+
+            uint32_t size = read_u32_le(&data[1]);
+            uint32_t image_crc = read_u32_le(&data[5]);
+
+            if (size <= IMG_HEADER_LEN || size > OTA_BANK_SIZE) {
+                ota_reply(conidx, OTA_CMD_START, OTA_STATUS_BAD_SIZE);
+                return;
+            }
+
+            uint32_t bank = ota_target_bank(&new_image_id);
+
+            // Same image into the same bank continues from the last commit; one
+            // not saved by user_ota_poll() yet is newer than the NVM record
+            bool found;
+            if (commit_pending) {
+                resume.committed = commit_offset;
+                resume.crc = commit_crc;
+                found = true;
+            } else {
+                found = !resume_erase_pending && ota_read_resume(size, image_crc, bank);
+            }
+
+            if (!found || resume.size != size || resume.image_crc != image_crc || resume.bank_addr != bank) {
+                // Records of another image must not match it later, once its bytes are gone
+                ota_drop_resume();
+                resume.size = size;
+                resume.image_crc = image_crc;
+                resume.bank_addr = bank;
+            }
+
+            owner = conidx;
+            next_offset = resume.committed;
+            running_crc = resume.crc;
+            packets_since_ack = 0;
+            nack_sent = false;
+            verified = false;
+            session_start_us = user_get_time_us();
+            session_bytes = 0;
+
+            // Committed data is sector aligned, or the whole image
+            erased_end = SECTOR_ALIGN_UP(resume.committed);
+            stalled = false;
+
+            printf("OTA start: %lu bytes to 0x%05lX from %lu\n", (unsigned long)size,
+                   (unsigned long)bank, (unsigned long)next_offset);
+
+            if (erased_end > next_offset || next_offset == resume.size) {
+                ota_start_reply();
+            } else {
+                start_pending = true;
+            }
+            break;
+        }
+
+        case OTA_CMD_END: {
+            uint8_t status = OTA_STATUS_OK;
+
+            if (owner != conidx) {
+                ota_reply(conidx, OTA_CMD_END, OTA_STATUS_NOT_STARTED);
+                return;
+            }
+
+            if (next_offset != resume.size) {
+                status = OTA_STATUS_BAD_SIZE;
+            } else if (running_crc != resume.image_crc) {
+                // Nothing in flash can be trusted, start over next time
+                status = OTA_STATUS_CRC_MISMATCH;
+                ota_drop_resume();
+            } else {
+                uint8_t mark[2] = { IMG_VALID, new_image_id };
+                uint32_t actual = 0;
+
+                spi_flash_release_from_power_down();
+                if (spi_flash_write_data(mark, resume.bank_addr + IMG_VALID_OFFSET,
+                                         sizeof(mark), &actual) != SPI_FLASH_ERR_OK) {
+                    status = OTA_STATUS_FLASH_ERROR;
+                } else {
+                    verified = true;
+                    ota_drop_resume();
+                }
+                spi_flash_power_down();
+            }
+
+            uint32_t elapsed_ms = (user_get_time_us() - session_start_us) / 1000;
+            uint32_t rate = elapsed_ms ? (uint32_t)(((uint64_t)session_bytes * 1000) / elapsed_ms) : 0;
+
+            printf("OTA end: status %d, %lu bytes in %lu ms (%lu B/s)\n", status,
+                   (unsigned long)session_bytes, (unsigned long)elapsed_ms, (unsigned long)rate);
+
+            pkt_ota_end_t rsp = {
+                .status = status,
+                .bytes = session_bytes,
+                .elapsed_ms = elapsed_ms,
+                .rate = rate
+            };
+            user_pkt_ota_end_send(conidx, &rsp);
+            break;
+        }
+
+        case OTA_CMD_ABORT:
+            ota_drop_resume();
+            user_ota_on_disconnect(conidx);
+            ota_reply(conidx, OTA_CMD_ABORT, OTA_STATUS_OK);
+            break;
+
+        case OTA_CMD_REBOOT:
+            if (!verified) {
+                ota_reply(conidx, OTA_CMD_REBOOT, OTA_STATUS_NOT_STARTED);
+                return;
+            }
+            printf("OTA: rebooting into image %d\n", new_image_id);
+            platform_reset(RESET_AFTER_SUOTA_UPDATE);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Handle one write without response on the OTA data characteristic
+ */
+void user_ota_on_data(uint8_t conidx, const uint8_t *data, uint16_t length) {
+    if (conidx != owner || verified || length <= OTA_DATA_HEADER_LEN) {
+        return;
+    }
+
+    uint32_t offset = read_u32_le(data);
+    const uint8_t *payload = &data[OTA_DATA_HEADER_LEN];
+    uint32_t remaining = length - OTA_DATA_HEADER_LEN;
+
+    // Waiting for an erase: user_ota_poll() acks with the offset to continue from
+    if (stalled || start_pending) {
+        return;
+    }
+
+    // Lost or repeated packet: ask once for a resend from next_offset
+    if (offset != next_offset) {
+        if (!nack_sent) {
+            ota_ack(conidx, OTA_STATUS_OUT_OF_ORDER);
+            nack_sent = true;
+            packets_since_ack = 0;
+        }
+        return;
+    }
+    nack_sent = false;
+
+    if (remaining > resume.size - offset) {
+        ota_ack(conidx, OTA_STATUS_BAD_SIZE);
+        return;
+    }
+
+    if (offset == 0 && (remaining < IMG_VALID_OFFSET + 2 ||
+                        payload[0] != IMG_SIGNATURE_0 || payload[1] != IMG_SIGNATURE_1)) {
+        ota_ack(conidx, OTA_STATUS_BAD_IMAGE);
+        return;
+    }
+
+    if (offset + remaining > erased_end) {
+        stalled = true;
+        return;
+    }
+
+    // Split at sector boundaries so every commit point is sector aligned
+    while (remaining > 0) {
+        uint32_t room = NVM_SECTOR_SIZE - (next_offset % NVM_SECTOR_SIZE);
+        uint32_t chunk = (remaining < room) ? remaining : room;
+
+        if (!ota_program(payload, chunk)) {
+            ota_ack(conidx, OTA_STATUS_FLASH_ERROR);
+            return;
+        }
+
+        payload += chunk;
+        remaining -= chunk;
+
+        if ((next_offset % NVM_SECTOR_SIZE) == 0 || next_offset == resume.size) {
+            commit_offset = next_offset;
+            commit_crc = running_crc;
+            commit_pending = true;
+        }
+    }
+
+    if (++packets_since_ack >= OTA_ACK_WINDOW || next_offset == resume.size) {
+        ota_ack(conidx, OTA_STATUS_OK);
+        packets_since_ack = 0;
+    }
+}
+
+/**
+ * @brief Flash work of the update, from the main loop (may block for a sector erase)
+ */
+void user_ota_poll(void) {
+    // Old records go before any image sector, or one could outlive the bytes it vouches for
+    if (resume_erase_pending) {
+        uint8_t slot = (resume_erase_pending & 1) ? 0 : 1;
+        resume_erase_pending &= ~(1 << slot);
+        user_nvm_erase(resume_records[slot]);
+        return;
+    }
+
+    if (commit_pending) {
+        commit_pending = false;
+        ota_commit();
+    }
+
+    if (owner == OTA_NO_OWNER || verified) {
+        return;
+    }
+
+    // One sector per pass keeps the loop moving
+    uint32_t target = (next_offset & ~(uint32_t)(NVM_SECTOR_SIZE - 1)) + OTA_ERASE_AHEAD;
+    if (target > SECTOR_ALIGN_UP(resume.size)) {
+        target = SECTOR_ALIGN_UP(resume.size);
+    }
+
+    if (erased_end < target) {
+        spi_flash_release_from_power_down();
+        bool ok = spi_flash_block_erase(resume.bank_addr + erased_end, SPI_FLASH_OP_SE) == SPI_FLASH_ERR_OK;
+        spi_flash_power_down();
+
+        if (!ok) {
+            printf("OTA erase failed at %lu\n", (unsigned long)erased_end);
+            return;
+        }
+        erased_end += NVM_SECTOR_SIZE;
+    }
+
+    if (start_pending && erased_end > next_offset) {
+        start_pending = false;
+        ota_start_reply();
+    }
+
+    if (stalled && erased_end > next_offset) {
+        stalled = false;
+        nack_sent = false;
+        packets_since_ack = 0;
+        ota_ack(owner, OTA_STATUS_OK);
+    }
+}
+
+/**
+ * @brief Drop the session of a closed connection (resume point stays in NVM)
+ */
+void user_ota_on_disconnect(uint8_t conidx) {
+    if (owner != conidx) {
+        return;
+    }
+
+    owner = OTA_NO_OWNER;
+    start_pending = false;
+    stalled = false;
+}
+
+/**
+ * @brief Check if an update is streaming (live data gives way)
+ */
+bool user_ota_active(void) {
+    return owner != OTA_NO_OWNER;
+}
+
+/**
+ * @brief Pick the bank the bootloader is not running from
+ * @param image_id Id that makes the new image the newest one
+ */
+static uint32_t ota_target_bank(uint8_t *image_id) {
+    uint8_t h1[4], h2[4];
+    uint32_t actual = 0;
+
+    spi_flash_release_from_power_down();
+    spi_flash_read_data(h1, OTA_BANK1_ADDR, sizeof(h1), &actual);
+    spi_flash_read_data(h2, OTA_BANK2_ADDR, sizeof(h2), &actual);
+    spi_flash_power_down();
+
+    bool v1 = h1[0] == IMG_SIGNATURE_0 && h1[1] == IMG_SIGNATURE_1 && h1[2] == IMG_VALID;
+    bool v2 = h2[0] == IMG_SIGNATURE_0 && h2[1] == IMG_SIGNATURE_1 && h2[2] == IMG_VALID;
+
+    // Image ids compare with wrap-around, as in the bootloader
+    if (v2 && (!v1 || (int8_t)(h2[3] - h1[3]) > 0)) {
+        *image_id = h2[3] + 1;
+        return OTA_BANK1_ADDR;
+    }
+
+    *image_id = v1 ? h1[3] + 1 : 1;
+    return OTA_BANK2_ADDR;
+}
+
+/**
+ * @brief Load the newest valid resume point into resume
+ * @param size, image_crc, bank Image it must be for, 0 for any
+ */
+static bool ota_read_resume(uint32_t size, uint32_t image_crc, uint32_t bank) {
+    ota_resume_t slot;
+    bool found = false;
+
+    memset(&resume, 0, sizeof(resume));
+
+    for (uint8_t i = 0; i < OTA_RESUME_SLOTS; i++) {
+        if (!user_nvm_read(resume_records[i], OTA_RESUME_VERSION, &slot, sizeof(slot)) ||
+            (size != 0 && (slot.size != size || slot.image_crc != image_crc || slot.bank_addr != bank)) ||
+            (found && slot.committed <= resume.committed)) {
+            continue;
+        }
+        resume = slot;
+        resume_slot = i;
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * @brief Program bytes at next_offset (already erased by user_ota_poll)
+ */
+static bool ota_program(const uint8_t *data, uint32_t length) {
+    uint32_t addr = resume.bank_addr + next_offset;
+    uint32_t actual = 0;
+    bool ok;
+
+    spi_flash_release_from_power_down();
+
+    running_crc = user_nvm_crc32(running_crc, data, length);
+
+    if (next_offset == 0) {
+        // Valid flag and image id stay erased until END
+        ok = spi_flash_write_data((uint8_t *)data, addr, IMG_VALID_OFFSET, &actual) == SPI_FLASH_ERR_OK &&
+             spi_flash_write_data((uint8_t *)&data[IMG_VALID_OFFSET + 2], addr + IMG_VALID_OFFSET + 2,
+                                  length - IMG_VALID_OFFSET - 2, &actual) == SPI_FLASH_ERR_OK;
+    } else {
+        ok = spi_flash_write_data((uint8_t *)data, addr, length, &actual) == SPI_FLASH_ERR_OK;
+    }
+
+    spi_flash_power_down();
+
+    if (!ok) {
+        running_crc = resume.crc;
+        next_offset = resume.committed;
+        return false;
+    }
+
+    next_offset += length;
+    session_bytes += length;
+    return true;
+}
+
+/**
+ * @brief Store the resume point of the last completed sector over the older record
+ */
+static void ota_commit(void) {
+    uint8_t slot = resume_slot ^ 1;
+
+    resume.committed = commit_offset;
+    resume.crc = commit_crc;
+    if (user_nvm_write(resume_records[slot], OTA_RESUME_VERSION, &resume, sizeof(resume))) {
+        resume_slot = slot;
+    }
+}
+
+/**
+ * @brief Answer START once the write position is erased
+ */
+static void ota_start_reply(void) {
+    pkt_ota_start_t rsp = {
+        .status = OTA_STATUS_OK,
+        .next = next_offset,
+        .window = OTA_ACK_WINDOW,
+        .max_data = user_custs1_get_ntf_max(owner) - OTA_DATA_HEADER_LEN
+    };
+
+    user_pkt_ota_start_send(owner, &rsp);
+}
+
+/**
+ * @brief Forget the resume point (records erased from the main loop)
+ */
+static void ota_drop_resume(void) {
+    memset(&resume, 0, sizeof(resume));
+    commit_pending = false;
+    resume_erase_pending = (1 << OTA_RESUME_SLOTS) - 1;
+}
+
+/**
+ * @brief Answer a control command with its status only
+ */
+static void ota_reply(uint8_t conidx, uint8_t cmd, uint8_t status) {
+    pkt_ota_reply_t rsp = {
+        .cmd = cmd,
+        .status = status
+    };
+
+    user_pkt_ota_reply_send(conidx, &rsp);
+}
+
+/**
+ * @brief Acknowledge data up to next_offset
+ */
+static void ota_ack(uint8_t conidx, uint8_t status) {
+    pkt_ota_ack_t rsp = {
+        .status = status,
+        .next = next_offset
+    };
+
+    user_pkt_ota_ack_send(conidx, &rsp);
+}
+
+/**
+ * @brief Read a little-endian 32-bit value
+ */
+static uint32_t read_u32_le(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
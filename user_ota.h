@@ -0,0 +1,41 @@
+/**
+ * @file user_ota.h
+ * @brief Resumable over-the-air image update into the inactive flash bank
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_OTA_H_
+#define USER_OTA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// OTA Control (write + notify), responses start with DATA_HEADER_OTA
+#define OTA_CMD_START                   0x01    // [0x01][Size u32][Crc32 u32] -> [0xF0][0x01][Status][Next u32][Window][MaxData u16]
+#define OTA_CMD_ACK                     0x02    // Device only: [0xF0][0x02][Status][Next u32]
+#define OTA_CMD_END                     0x03    // [0x03] -> [0xF0][0x03][Status][Bytes u32][Elapsed ms u32][Rate B/s u32]
+#define OTA_CMD_ABORT                   0x04    // [0x04], drops the resume point
+#define OTA_CMD_REBOOT                  0x05    // [0x05], boots the new image after a good END
+
+// OTA Data (write without response): [Offset u32][Image bytes...]
+#define OTA_DATA_HEADER_LEN             4
+
+// Status Codes
+#define OTA_STATUS_OK                   0x00
+#define OTA_STATUS_BUSY                 0x01    // Another connection owns the update
+#define OTA_STATUS_BAD_SIZE             0x02
+#define OTA_STATUS_BAD_IMAGE            0x03    // Image header signature missing
+#define OTA_STATUS_OUT_OF_ORDER         0x04    // Resend from Next
+#define OTA_STATUS_FLASH_ERROR          0x05
+#define OTA_STATUS_CRC_MISMATCH         0x06
+#define OTA_STATUS_NOT_STARTED          0x07
+
+// Function Prototypes
+void user_ota_init(void);
+void user_ota_on_control(uint8_t conidx, const uint8_t *data, uint16_t length);
+void user_ota_on_data(uint8_t conidx, const uint8_t *data, uint16_t length);
+void user_ota_poll(void);
+void user_ota_on_disconnect(uint8_t conidx);
+bool user_ota_active(void);
+
+#endif // USER_OTA_H_
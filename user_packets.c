@@ -0,0 +1,647 @@
+/**
+ * @file user_packets.c
+ * @brief Notification packet packers
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Generated by tools/packetgen.py from tools/packets.json - do not edit
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "user_packets.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_ota.h"
+
+// The schema must agree with the service definitions
+#if DATA_HEADER_ALERT != 0xA1
+#error "DATA_HEADER_ALERT does not match tools/packets.json"
+#endif
+#if DATA_HEADER_BATTERY != 0xCC
+#error "DATA_HEADER_BATTERY does not match tools/packets.json"
+#endif
+#if DATA_HEADER_CAPTURE != 0xEE
+#error "DATA_HEADER_CAPTURE does not match tools/packets.json"
+#endif
+#if DATA_HEADER_GAIT != 0xBD
+#error "DATA_HEADER_GAIT does not match tools/packets.json"
+#endif
+#if DATA_HEADER_JUMP_METRICS != 0xBB
+#error "DATA_HEADER_JUMP_METRICS does not match tools/packets.json"
+#endif
+#if DATA_HEADER_OTA != 0xF0
+#error "DATA_HEADER_OTA does not match tools/packets.json"
+#endif
+#if DATA_HEADER_REPS != 0xBE
+#error "DATA_HEADER_REPS does not match tools/packets.json"
+#endif
+#if DATA_HEADER_SENSOR != 0xAA
+#error "DATA_HEADER_SENSOR does not match tools/packets.json"
+#endif
+#if DATA_HEADER_STATUS != 0xDD
+#error "DATA_HEADER_STATUS does not match tools/packets.json"
+#endif
+#if DEVICE_CMD_GET_STATUS != 0x05
+#error "DEVICE_CMD_GET_STATUS does not match tools/packets.json"
+#endif
+#if DEVICE_CMD_TIME_SYNC_REQ != 0x07
+#error "DEVICE_CMD_TIME_SYNC_REQ does not match tools/packets.json"
+#endif
+#if DEVICE_CMD_TIME_SYNC_RESULT != 0x08
+#error "DEVICE_CMD_TIME_SYNC_RESULT does not match tools/packets.json"
+#endif
+#if DEVICE_CMD_TLV_FRAME != 0x7E
+#error "DEVICE_CMD_TLV_FRAME does not match tools/packets.json"
+#endif
+#if OTA_CMD_ACK != 0x02
+#error "OTA_CMD_ACK does not match tools/packets.json"
+#endif
+#if OTA_CMD_END != 0x03
+#error "OTA_CMD_END does not match tools/packets.json"
+#endif
+#if OTA_CMD_START != 0x01
+#error "OTA_CMD_START does not match tools/packets.json"
+#endif
+
+/**
+ * @brief Write the Sensor Data body (no header)
+ * @return PKT_SENSOR_BODY_LEN
+ */
+uint8_t user_pkt_sensor_put(uint8_t *buf, const pkt_sensor_t *pkt) {
+    buf[0] = pkt->accel_x;
+    buf[1] = pkt->accel_y;
+    buf[2] = pkt->accel_z;
+    buf[3] = pkt->jump_height;
+    buf[4] = (uint8_t)(pkt->total_jumps);
+    buf[5] = (uint8_t)(pkt->total_jumps >> 8);
+    buf[6] = (uint8_t)(pkt->pressure);
+    buf[7] = (uint8_t)(pkt->pressure >> 8);
+    buf[8] = (uint8_t)(pkt->battery_mv);
+    buf[9] = (uint8_t)(pkt->battery_mv >> 8);
+    buf[10] = (uint8_t)(pkt->sample_time);
+    buf[11] = (uint8_t)(pkt->sample_time >> 8);
+    buf[12] = (uint8_t)(pkt->sample_time >> 16);
+    buf[13] = (uint8_t)(pkt->sample_time >> 24);
+    buf[14] = (uint8_t)((uint16_t)pkt->load_rate);
+    buf[15] = (uint8_t)((uint16_t)pkt->load_rate >> 8);
+
+    return PKT_SENSOR_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Sensor Data packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_sensor_send(uint8_t target, const pkt_sensor_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_SENSOR_DATA_VAL, PKT_SENSOR_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_SENSOR;
+    user_pkt_sensor_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Jump Metrics body (no header)
+ * @return PKT_JUMP_BODY_LEN
+ */
+uint8_t user_pkt_jump_put(uint8_t *buf, const pkt_jump_t *pkt) {
+    buf[0] = pkt->height;
+    buf[1] = (uint8_t)(pkt->flight_ms);
+    buf[2] = (uint8_t)(pkt->flight_ms >> 8);
+    buf[3] = (uint8_t)(pkt->total_jumps);
+    buf[4] = (uint8_t)(pkt->total_jumps >> 8);
+    buf[5] = pkt->max_height;
+    buf[6] = (uint8_t)(pkt->takeoff_time);
+    buf[7] = (uint8_t)(pkt->takeoff_time >> 8);
+    buf[8] = (uint8_t)(pkt->takeoff_time >> 16);
+    buf[9] = (uint8_t)(pkt->takeoff_time >> 24);
+
+    return PKT_JUMP_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Jump Metrics packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_jump_send(uint8_t target, const pkt_jump_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_JUMP_METRICS_VAL, PKT_JUMP_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_JUMP_METRICS;
+    user_pkt_jump_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Exercise Set body (no header)
+ * @return PKT_REPS_BODY_LEN
+ */
+uint8_t user_pkt_reps_put(uint8_t *buf, const pkt_reps_t *pkt) {
+    buf[0] = (uint8_t)(pkt->set);
+    buf[1] = (uint8_t)(pkt->set >> 8);
+    buf[2] = pkt->slot;
+    buf[3] = (uint8_t)(pkt->reps);
+    buf[4] = (uint8_t)(pkt->reps >> 8);
+    buf[5] = (uint8_t)(pkt->tempo_ms);
+    buf[6] = (uint8_t)(pkt->tempo_ms >> 8);
+    buf[7] = (uint8_t)(pkt->rom_mg);
+    buf[8] = (uint8_t)(pkt->rom_mg >> 8);
+    buf[9] = (uint8_t)(pkt->duration_s);
+    buf[10] = (uint8_t)(pkt->duration_s >> 8);
+
+    return PKT_REPS_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Exercise Set packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_reps_send(uint8_t target, const pkt_reps_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_SENSOR_DATA_VAL, PKT_REPS_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_REPS;
+    user_pkt_reps_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Battery Status body (no header)
+ * @return PKT_BATTERY_BODY_LEN
+ */
+uint8_t user_pkt_battery_put(uint8_t *buf, const pkt_battery_t *pkt) {
+    buf[0] = (uint8_t)(pkt->battery_mv);
+    buf[1] = (uint8_t)(pkt->battery_mv >> 8);
+    buf[2] = pkt->percent;
+    buf[3] = pkt->tier;
+    buf[4] = (uint8_t)(pkt->hours_left);
+    buf[5] = (uint8_t)(pkt->hours_left >> 8);
+
+    return PKT_BATTERY_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Battery Status packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_battery_send(uint8_t target, const pkt_battery_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_BATTERY_STATUS_VAL, PKT_BATTERY_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_BATTERY;
+    user_pkt_battery_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Device Status body (no header)
+ * @return PKT_STATUS_BODY_LEN
+ */
+uint8_t user_pkt_status_put(uint8_t *buf, const pkt_status_t *pkt) {
+    buf[0] = pkt->mode;
+    buf[1] = pkt->flags;
+    buf[2] = (uint8_t)(pkt->total_jumps);
+    buf[3] = (uint8_t)(pkt->total_jumps >> 8);
+    buf[4] = (uint8_t)(pkt->total_jumps >> 16);
+    buf[5] = (uint8_t)(pkt->total_jumps >> 24);
+    buf[6] = (uint8_t)(pkt->battery_mv);
+    buf[7] = (uint8_t)(pkt->battery_mv >> 8);
+
+    return PKT_STATUS_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Device Status packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_status_send(uint8_t target, const pkt_status_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_DEVICE_CONTROL_VAL, PKT_STATUS_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_STATUS;
+    buf[1] = DEVICE_CMD_GET_STATUS;
+    user_pkt_status_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Register Results body (no header)
+ * @return PKT_CTRL_RESULT_BODY_LEN - PKT_CTRL_RESULT_RESULTS_MAX + results_len
+ */
+uint8_t user_pkt_ctrl_result_put(uint8_t *buf, const pkt_ctrl_result_t *pkt) {
+    buf[0] = pkt->seq;
+    memcpy(&buf[1], pkt->results, pkt->results_len);
+
+    return PKT_CTRL_RESULT_BODY_LEN - PKT_CTRL_RESULT_RESULTS_MAX + pkt->results_len;
+}
+
+/**
+ * @brief Pack and notify a Register Results packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_ctrl_result_send(uint8_t target, const pkt_ctrl_result_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_DEVICE_CONTROL_VAL, PKT_CTRL_RESULT_LEN - PKT_CTRL_RESULT_RESULTS_MAX + pkt->results_len);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_STATUS;
+    buf[1] = DEVICE_CMD_TLV_FRAME;
+    user_pkt_ctrl_result_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Time Sync Reply body (no header)
+ * @return PKT_TIME_SYNC_REQ_BODY_LEN
+ */
+uint8_t user_pkt_time_sync_req_put(uint8_t *buf, const pkt_time_sync_req_t *pkt) {
+    buf[0] = pkt->seq;
+    buf[1] = (uint8_t)(pkt->t2);
+    buf[2] = (uint8_t)(pkt->t2 >> 8);
+    buf[3] = (uint8_t)(pkt->t2 >> 16);
+    buf[4] = (uint8_t)(pkt->t2 >> 24);
+    buf[5] = (uint8_t)(pkt->t3);
+    buf[6] = (uint8_t)(pkt->t3 >> 8);
+    buf[7] = (uint8_t)(pkt->t3 >> 16);
+    buf[8] = (uint8_t)(pkt->t3 >> 24);
+
+    return PKT_TIME_SYNC_REQ_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Time Sync Reply packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_time_sync_req_send(uint8_t target, const pkt_time_sync_req_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_DEVICE_CONTROL_VAL, PKT_TIME_SYNC_REQ_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_STATUS;
+    buf[1] = DEVICE_CMD_TIME_SYNC_REQ;
+    user_pkt_time_sync_req_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Time Sync Result body (no header)
+ * @return PKT_TIME_SYNC_RESULT_BODY_LEN
+ */
+uint8_t user_pkt_time_sync_result_put(uint8_t *buf, const pkt_time_sync_result_t *pkt) {
+    buf[0] = pkt->seq;
+    buf[1] = pkt->accepted;
+    buf[2] = (uint8_t)((uint32_t)pkt->residual_us);
+    buf[3] = (uint8_t)((uint32_t)pkt->residual_us >> 8);
+    buf[4] = (uint8_t)((uint32_t)pkt->residual_us >> 16);
+    buf[5] = (uint8_t)((uint32_t)pkt->residual_us >> 24);
+    buf[6] = (uint8_t)((uint32_t)pkt->drift_ppb);
+    buf[7] = (uint8_t)((uint32_t)pkt->drift_ppb >> 8);
+    buf[8] = (uint8_t)((uint32_t)pkt->drift_ppb >> 16);
+    buf[9] = (uint8_t)((uint32_t)pkt->drift_ppb >> 24);
+
+    return PKT_TIME_SYNC_RESULT_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Time Sync Result packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_time_sync_result_send(uint8_t target, const pkt_time_sync_result_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_DEVICE_CONTROL_VAL, PKT_TIME_SYNC_RESULT_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_STATUS;
+    buf[1] = DEVICE_CMD_TIME_SYNC_RESULT;
+    user_pkt_time_sync_result_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Gait Summary body (no header)
+ * @return PKT_GAIT_BODY_LEN
+ */
+uint8_t user_pkt_gait_put(uint8_t *buf, const pkt_gait_t *pkt) {
+    buf[0] = (uint8_t)(pkt->minute);
+    buf[1] = (uint8_t)(pkt->minute >> 8);
+    buf[2] = (uint8_t)(pkt->steps);
+    buf[3] = (uint8_t)(pkt->steps >> 8);
+    buf[4] = pkt->cadence_spm;
+    buf[5] = (uint8_t)(pkt->stance_ms);
+    buf[6] = (uint8_t)(pkt->stance_ms >> 8);
+    buf[7] = (uint8_t)(pkt->swing_ms);
+    buf[8] = (uint8_t)(pkt->swing_ms >> 8);
+    buf[9] = (uint8_t)(pkt->stride_ms);
+    buf[10] = (uint8_t)(pkt->stride_ms >> 8);
+    buf[11] = (uint8_t)(pkt->stride_cv);
+    buf[12] = (uint8_t)(pkt->stride_cv >> 8);
+    buf[13] = (uint8_t)(pkt->total_steps);
+    buf[14] = (uint8_t)(pkt->total_steps >> 8);
+    buf[15] = (uint8_t)(pkt->total_steps >> 16);
+    buf[16] = (uint8_t)(pkt->total_steps >> 24);
+
+    return PKT_GAIT_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Gait Summary packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_gait_send(uint8_t target, const pkt_gait_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_SENSOR_DATA_VAL, PKT_GAIT_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_GAIT;
+    user_pkt_gait_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Jump Capture Header body (no header)
+ * @return PKT_CAPTURE_HEAD_BODY_LEN
+ */
+uint8_t user_pkt_capture_head_put(uint8_t *buf, const pkt_capture_head_t *pkt) {
+    buf[0] = (uint8_t)(pkt->jump_id);
+    buf[1] = (uint8_t)(pkt->jump_id >> 8);
+    buf[2] = 0x00;
+    buf[3] = (uint8_t)(pkt->takeoff_time);
+    buf[4] = (uint8_t)(pkt->takeoff_time >> 8);
+    buf[5] = (uint8_t)(pkt->takeoff_time >> 16);
+    buf[6] = (uint8_t)(pkt->takeoff_time >> 24);
+    buf[7] = (uint8_t)(pkt->flight_ms);
+    buf[8] = (uint8_t)(pkt->flight_ms >> 8);
+    buf[9] = pkt->pre_samples;
+    buf[10] = pkt->post_samples;
+    buf[11] = pkt->chunks;
+    buf[12] = pkt->sample_rate_hz;
+
+    return PKT_CAPTURE_HEAD_BODY_LEN;
+}
+
+/**
+ * @brief Pack and notify a Jump Capture Header packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_capture_head_send(uint8_t target, const pkt_capture_head_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_SENSOR_DATA_VAL, PKT_CAPTURE_HEAD_LEN);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_CAPTURE;
+    user_pkt_capture_head_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Jump Capture Samples body (no header)
+ * @return PKT_CAPTURE_DATA_BODY_LEN - PKT_CAPTURE_DATA_SAMPLES_MAX + samples_len
+ */
+uint8_t user_pkt_capture_data_put(uint8_t *buf, const pkt_capture_data_t *pkt) {
+    buf[0] = (uint8_t)(pkt->jump_id);
+    buf[1] = (uint8_t)(pkt->jump_id >> 8);
+    buf[2] = pkt->chunk;
+    memcpy(&buf[3], pkt->samples, pkt->samples_len);
+
+    return PKT_CAPTURE_DATA_BODY_LEN - PKT_CAPTURE_DATA_SAMPLES_MAX + pkt->samples_len;
+}
+
+/**
+ * @brief Pack and notify a Jump Capture Samples packet
+ * @param target Connection index or CONIDX_ALL
+ * @return false when no connection took the packet
+ */
+bool user_pkt_capture_data_send(uint8_t target, const pkt_capture_data_t *pkt) {
+    uint8_t *buf = user_custs1_ntf_alloc(target, CUSTS1_IDX_SENSOR_DATA_VAL, PKT_CAPTURE_DATA_LEN - PKT_CAPTURE_DATA_SAMPLES_MAX + pkt->samples_len);
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    buf[0] = DATA_HEADER_CAPTURE;
+    user_pkt_capture_data_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+
+    return true;
+}
+
+/**
+ * @brief Write the Fall Alert body (no header)
+ * @return PKT_ALERT_BODY_LEN
+ */
+uint8_t user_pkt_alert_put(uint8_t *buf, const pkt_alert_t *pkt) {
+    buf[0] = pkt->type;
+    buf[1] = pkt->seq;
+    buf[2] = (uint8_t)(pkt->impact_time);
+    buf[3] = (uint8_t)(pkt->impact_time >> 8);
+    buf[4] = (uint8_t)(pkt->impact_time >> 16);
+    buf[5] = (uint8_t)(pkt->impact_time >> 24);
+    buf[6] = (uint8_t)(pkt->peak_mg);
+    buf[7] = (uint8_t)(pkt->peak_mg >> 8);
+
+    return PKT_ALERT_BODY_LEN;
+}
+
+/**
+ * @brief Pack and send a Fall Alert packet
+ * @return Number of connections the packet was queued for
+ */
+uint8_t user_pkt_alert_send(const pkt_alert_t *pkt) {
+    uint8_t *buf = user_custs1_alert_alloc(PKT_ALERT_LEN);
+
+    if (buf == NULL) {
+        return 0;
+    }
+
+    buf[0] = DATA_HEADER_ALERT;
+    user_pkt_alert_put(&buf[1], pkt);
+
+    return user_custs1_ntf_commit();
+}
+
+/**
+ * @brief Write the OTA Start body (no header)
+ * @return PKT_OTA_START_BODY_LEN
+ */
+uint8_t user_pkt_ota_start_put(uint8_t *buf, const pkt_ota_start_t *pkt) {
+    buf[0] = pkt->status;
+    buf[1] = (uint8_t)(pkt->next);
+    buf[2] = (uint8_t)(pkt->next >> 8);
+    buf[3] = (uint8_t)(pkt->next >> 16);
+    buf[4] = (uint8_t)(pkt->next >> 24);
+    buf[5] = pkt->window;
+    buf[6] = (uint8_t)(pkt->max_data);
+    buf[7] = (uint8_t)(pkt->max_data >> 8);
+
+    return PKT_OTA_START_BODY_LEN;
+}
+
+/**
+ * @brief Pack and send a OTA Start packet
+ * @param conidx Connection index
+ */
+void user_pkt_ota_start_send(uint8_t conidx, const pkt_ota_start_t *pkt) {
+    uint8_t *buf = user_custs1_ota_alloc(conidx, PKT_OTA_START_LEN);
+
+    if (buf == NULL) {
+        return;
+    }
+
+    buf[0] = DATA_HEADER_OTA;
+    buf[1] = OTA_CMD_START;
+    user_pkt_ota_start_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+}
+
+/**
+ * @brief Write the OTA Ack body (no header)
+ * @return PKT_OTA_ACK_BODY_LEN
+ */
+uint8_t user_pkt_ota_ack_put(uint8_t *buf, const pkt_ota_ack_t *pkt) {
+    buf[0] = pkt->status;
+    buf[1] = (uint8_t)(pkt->next);
+    buf[2] = (uint8_t)(pkt->next >> 8);
+    buf[3] = (uint8_t)(pkt->next >> 16);
+    buf[4] = (uint8_t)(pkt->next >> 24);
+
+    return PKT_OTA_ACK_BODY_LEN;
+}
+
+/**
+ * @brief Pack and send a OTA Ack packet
+ * @param conidx Connection index
+ */
+void user_pkt_ota_ack_send(uint8_t conidx, const pkt_ota_ack_t *pkt) {
+    uint8_t *buf = user_custs1_ota_alloc(conidx, PKT_OTA_ACK_LEN);
+
+    if (buf == NULL) {
+        return;
+    }
+
+    buf[0] = DATA_HEADER_OTA;
+    buf[1] = OTA_CMD_ACK;
+    user_pkt_ota_ack_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+}
+
+/**
+ * @brief Write the OTA End body (no header)
+ * @return PKT_OTA_END_BODY_LEN
+ */
+uint8_t user_pkt_ota_end_put(uint8_t *buf, const pkt_ota_end_t *pkt) {
+    buf[0] = pkt->status;
+    buf[1] = (uint8_t)(pkt->bytes);
+    buf[2] = (uint8_t)(pkt->bytes >> 8);
+    buf[3] = (uint8_t)(pkt->bytes >> 16);
+    buf[4] = (uint8_t)(pkt->bytes >> 24);
+    buf[5] = (uint8_t)(pkt->elapsed_ms);
+    buf[6] = (uint8_t)(pkt->elapsed_ms >> 8);
+    buf[7] = (uint8_t)(pkt->elapsed_ms >> 16);
+    buf[8] = (uint8_t)(pkt->elapsed_ms >> 24);
+    buf[9] = (uint8_t)(pkt->rate);
+    buf[10] = (uint8_t)(pkt->rate >> 8);
+    buf[11] = (uint8_t)(pkt->rate >> 16);
+    buf[12] = (uint8_t)(pkt->rate >> 24);
+
+    return PKT_OTA_END_BODY_LEN;
+}
+
+/**
+ * @brief Pack and send a OTA End packet
+ * @param conidx Connection index
+ */
+void user_pkt_ota_end_send(uint8_t conidx, const pkt_ota_end_t *pkt) {
+    uint8_t *buf = user_custs1_ota_alloc(conidx, PKT_OTA_END_LEN);
+
+    if (buf == NULL) {
+        return;
+    }
+
+    buf[0] = DATA_HEADER_OTA;
+    buf[1] = OTA_CMD_END;
+    user_pkt_ota_end_put(&buf[2], pkt);
+    user_custs1_ntf_commit();
+}
+
+/**
+ * @brief Write the OTA Reply body (no header)
+ * @return PKT_OTA_REPLY_BODY_LEN
+ */
+uint8_t user_pkt_ota_reply_put(uint8_t *buf, const pkt_ota_reply_t *pkt) {
+    buf[0] = pkt->cmd;
+    buf[1] = pkt->status;
+
+    return PKT_OTA_REPLY_BODY_LEN;
+}
+
+/**
+ * @brief Pack and send a OTA Reply packet
+ * @param conidx Connection index
+ */
+void user_pkt_ota_reply_send(uint8_t conidx, const pkt_ota_reply_t *pkt) {
+    uint8_t *buf = user_custs1_ota_alloc(conidx, PKT_OTA_REPLY_LEN);
+
+    if (buf == NULL) {
+        return;
+    }
+
+    buf[0] = DATA_HEADER_OTA;
+    user_pkt_ota_reply_put(&buf[1], pkt);
+    user_custs1_ntf_commit();
+}
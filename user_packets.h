@@ -0,0 +1,239 @@
+/**
+ * @file user_packets.h
+ * @brief Notification packet packers
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Generated by tools/packetgen.py from tools/packets.json - do not edit
+ */
+
+#ifndef USER_PACKETS_H_
+#define USER_PACKETS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bumped on every layout change that breaks old decoders (register 0x03)
+#define PACKET_SCHEMA_VERSION           2
+
+// Sensor Data: Live sample at the notification rate, register 0x13
+#define PKT_SENSOR_LEN                  17
+#define PKT_SENSOR_BODY_LEN             16
+
+typedef struct {
+    uint8_t accel_x;                // (raw -128) x 0.02 g
+    uint8_t accel_y;                // (raw -128) x 0.02 g
+    uint8_t accel_z;                // (raw -128) x 0.02 g
+    uint8_t jump_height;            // cm
+    uint16_t total_jumps;
+    uint16_t pressure;              // x 0.025 kPa
+    uint16_t battery_mv;            // mV
+    uint32_t sample_time;           // us
+    int16_t load_rate;              // kPa/s
+} pkt_sensor_t;
+
+// Jump Metrics: Sent on every valid jump
+#define PKT_JUMP_LEN                    11
+#define PKT_JUMP_BODY_LEN               10
+
+typedef struct {
+    uint8_t height;                 // cm
+    uint16_t flight_ms;             // ms
+    uint16_t total_jumps;
+    uint8_t max_height;             // cm
+    uint32_t takeoff_time;          // us
+} pkt_jump_t;
+
+// Exercise Set: Medical mode, once a set of template-matched reps ends
+#define PKT_REPS_LEN                    12
+#define PKT_REPS_BODY_LEN               11
+
+typedef struct {
+    uint16_t set;
+    uint8_t slot;
+    uint16_t reps;
+    uint16_t tempo_ms;              // ms
+    uint16_t rom_mg;                // mg
+    uint16_t duration_s;            // s
+} pkt_reps_t;
+
+// Battery Status: Sent after every VBAT measurement
+#define PKT_BATTERY_LEN                 7
+#define PKT_BATTERY_BODY_LEN            6
+
+typedef struct {
+    uint16_t battery_mv;            // mV
+    uint8_t percent;                // %
+    uint8_t tier;
+    uint16_t hours_left;            // h
+} pkt_battery_t;
+
+// Device Status: Answer to command 0x05; the body is also register 0x01
+#define PKT_STATUS_LEN                  10
+#define PKT_STATUS_BODY_LEN             8
+
+typedef struct {
+    uint8_t mode;
+    uint8_t flags;                  // bit 0 calibrated, bit 1 in_jump, bit 2 synced, bit 3 off_body
+    uint32_t total_jumps;
+    uint16_t battery_mv;            // mV
+} pkt_status_t;
+
+// Register Results: Answer to a TLV frame (0x7E) to the writer, one result per answered operation
+#define PKT_CTRL_RESULT_LEN             64
+#define PKT_CTRL_RESULT_BODY_LEN        62
+#define PKT_CTRL_RESULT_RESULTS_MAX     61
+
+typedef struct {
+    uint8_t seq;
+    const uint8_t *results;         // At most 61
+    uint8_t results_len;
+} pkt_ctrl_result_t;
+
+// Time Sync Reply: Answer to a time sync request (0x07) to the sync master
+#define PKT_TIME_SYNC_REQ_LEN           11
+#define PKT_TIME_SYNC_REQ_BODY_LEN      9
+
+typedef struct {
+    uint8_t seq;
+    uint32_t t2;                    // us
+    uint32_t t3;                    // us
+} pkt_time_sync_req_t;
+
+// Time Sync Result: Answer to a time sync result (0x08) to the sync master
+#define PKT_TIME_SYNC_RESULT_LEN        12
+#define PKT_TIME_SYNC_RESULT_BODY_LEN   10
+
+typedef struct {
+    uint8_t seq;
+    uint8_t accepted;
+    int32_t residual_us;            // us
+    int32_t drift_ppb;              // ppb
+} pkt_time_sync_result_t;
+
+// Gait Summary: Medical mode, replaces sensor data packets, once per minute
+#define PKT_GAIT_LEN                    18
+#define PKT_GAIT_BODY_LEN               17
+
+typedef struct {
+    uint16_t minute;
+    uint16_t steps;
+    uint8_t cadence_spm;            // steps/min
+    uint16_t stance_ms;             // ms
+    uint16_t swing_ms;              // ms
+    uint16_t stride_ms;             // ms
+    uint16_t stride_cv;             // x 0.1 %
+    uint32_t total_steps;
+} pkt_gait_t;
+
+// Jump Capture Header: Chunk 0 of a jump snapshot, sent when the link is idle
+#define PKT_CAPTURE_HEAD_LEN            14
+#define PKT_CAPTURE_HEAD_BODY_LEN       13
+
+typedef struct {
+    uint16_t jump_id;
+    uint32_t takeoff_time;          // us
+    uint16_t flight_ms;             // ms
+    uint8_t pre_samples;
+    uint8_t post_samples;
+    uint8_t chunks;
+    uint8_t sample_rate_hz;         // Hz
+} pkt_capture_head_t;
+
+// Jump Capture Samples: Chunks 1 to Chunks-1 of a snapshot, as long as the smallest MTU allows
+#define PKT_CAPTURE_DATA_LEN            244
+#define PKT_CAPTURE_DATA_BODY_LEN       243
+#define PKT_CAPTURE_DATA_SAMPLES_MAX    240
+
+typedef struct {
+    uint16_t jump_id;
+    uint8_t chunk;
+    const uint8_t *samples;         // At most 240
+    uint8_t samples_len;
+} pkt_capture_data_t;
+
+// Fall Alert: Medical mode, to every subscribed central ahead of other traffic
+#define PKT_ALERT_LEN                   9
+#define PKT_ALERT_BODY_LEN              8
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint32_t impact_time;           // us
+    uint16_t peak_mg;               // mg
+} pkt_alert_t;
+
+// OTA Start: Answer to an accepted START
+#define PKT_OTA_START_LEN               10
+#define PKT_OTA_START_BODY_LEN          8
+
+typedef struct {
+    uint8_t status;
+    uint32_t next;
+    uint8_t window;
+    uint16_t max_data;
+} pkt_ota_start_t;
+
+// OTA Ack: Every window of data packets, after a lost packet or a stalled erase
+#define PKT_OTA_ACK_LEN                 7
+#define PKT_OTA_ACK_BODY_LEN            5
+
+typedef struct {
+    uint8_t status;
+    uint32_t next;
+} pkt_ota_ack_t;
+
+// OTA End: Answer to END from the updating connection
+#define PKT_OTA_END_LEN                 15
+#define PKT_OTA_END_BODY_LEN            13
+
+typedef struct {
+    uint8_t status;
+    uint32_t bytes;
+    uint32_t elapsed_ms;            // ms
+    uint32_t rate;                  // B/s
+} pkt_ota_end_t;
+
+// OTA Reply: Every other OTA answer: refused commands, ABORT and REBOOT
+#define PKT_OTA_REPLY_LEN               3
+#define PKT_OTA_REPLY_BODY_LEN          2
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t status;
+} pkt_ota_reply_t;
+
+// Function Prototypes
+uint8_t user_pkt_sensor_put(uint8_t *buf, const pkt_sensor_t *pkt);
+bool user_pkt_sensor_send(uint8_t target, const pkt_sensor_t *pkt);
+uint8_t user_pkt_jump_put(uint8_t *buf, const pkt_jump_t *pkt);
+bool user_pkt_jump_send(uint8_t target, const pkt_jump_t *pkt);
+uint8_t user_pkt_reps_put(uint8_t *buf, const pkt_reps_t *pkt);
+bool user_pkt_reps_send(uint8_t target, const pkt_reps_t *pkt);
+uint8_t user_pkt_battery_put(uint8_t *buf, const pkt_battery_t *pkt);
+bool user_pkt_battery_send(uint8_t target, const pkt_battery_t *pkt);
+uint8_t user_pkt_status_put(uint8_t *buf, const pkt_status_t *pkt);
+bool user_pkt_status_send(uint8_t target, const pkt_status_t *pkt);
+uint8_t user_pkt_ctrl_result_put(uint8_t *buf, const pkt_ctrl_result_t *pkt);
+bool user_pkt_ctrl_result_send(uint8_t target, const pkt_ctrl_result_t *pkt);
+uint8_t user_pkt_time_sync_req_put(uint8_t *buf, const pkt_time_sync_req_t *pkt);
+bool user_pkt_time_sync_req_send(uint8_t target, const pkt_time_sync_req_t *pkt);
+uint8_t user_pkt_time_sync_result_put(uint8_t *buf, const pkt_time_sync_result_t *pkt);
+bool user_pkt_time_sync_result_send(uint8_t target, const pkt_time_sync_result_t *pkt);
+uint8_t user_pkt_gait_put(uint8_t *buf, const pkt_gait_t *pkt);
+bool user_pkt_gait_send(uint8_t target, const pkt_gait_t *pkt);
+uint8_t user_pkt_capture_head_put(uint8_t *buf, const pkt_capture_head_t *pkt);
+bool user_pkt_capture_head_send(uint8_t target, const pkt_capture_head_t *pkt);
+uint8_t user_pkt_capture_data_put(uint8_t *buf, const pkt_capture_data_t *pkt);
+bool user_pkt_capture_data_send(uint8_t target, const pkt_capture_data_t *pkt);
+uint8_t user_pkt_alert_put(uint8_t *buf, const pkt_alert_t *pkt);
+uint8_t user_pkt_alert_send(const pkt_alert_t *pkt);
+uint8_t user_pkt_ota_start_put(uint8_t *buf, const pkt_ota_start_t *pkt);
+void user_pkt_ota_start_send(uint8_t conidx, const pkt_ota_start_t *pkt);
+uint8_t user_pkt_ota_ack_put(uint8_t *buf, const pkt_ota_ack_t *pkt);
+void user_pkt_ota_ack_send(uint8_t conidx, const pkt_ota_ack_t *pkt);
+uint8_t user_pkt_ota_end_put(uint8_t *buf, const pkt_ota_end_t *pkt);
+void user_pkt_ota_end_send(uint8_t conidx, const pkt_ota_end_t *pkt);
+uint8_t user_pkt_ota_reply_put(uint8_t *buf, const pkt_ota_reply_t *pkt);
+void user_pkt_ota_reply_send(uint8_t conidx, const pkt_ota_reply_t *pkt);
+
+#endif // USER_PACKETS_H_
@@ -10,6 +10,22 @@
 #include "uart.h"
 #include "syscntl.h"
 
+// SPI Flash Configuration
+static const spi_cfg_t spi_cfg = {
+    .spi_ms = SPI_MS_MODE_MASTER,
+    .spi_cp = SPI_CP_MODE_0,
+    .spi_speed = SPI_SPEED_MODE_4MHz,
+    .spi_wsz = SPI_MODE_8BIT,
+    .spi_cs = SPI_CS_0,
+    .cs_pad.port = SPI_EN_PORT,
+    .cs_pad.pin = SPI_EN_PIN,
+    .spi_capture = SPI_MASTER_EDGE_CAPTURE
+};
+
+static const spi_flash_cfg_t spi_flash_cfg = {
+    .chip_size = SPI_FLASH_DEV_SIZE
+};
+
 /**
  * @brief Initialize all peripherals
  */
@@ -20,6 +36,13 @@ void periph_init(void) {
     // Configure GPIO reservations
     GPIO_reservations();
     
+    // SPI flash for NVM records and OTA; it idles in power-down, and every
+    // access releases it and powers it down again, so it is off across sleep
+    spi_flash_configure_env(&spi_flash_cfg);
+    spi_initialize(&spi_cfg);
+    spi_flash_release_from_power_down();
+    spi_flash_power_down();
+    
     // Initialize UART for debug output
 #if defined(CFG_PRINTF_UART2)
     uart2_init(UART_BAUDRATE_115200, UART_DATABITS_8, UART_PARITY_NONE, UART_STOPBITS_1, UART_AFCE_DIS, UART_FIFO_EN);
@@ -30,6 +53,15 @@ void periph_init(void) {
  * @brief Set pad functions for all pins
  */
 void set_pad_functions(void) {
+    // P0_0 is SPI flash MOSI, not the hardware reset input
+    GPIO_Disable_HW_Reset();
+    
+    // SPI flash
+    GPIO_ConfigurePin(SPI_EN_PORT, SPI_EN_PIN, OUTPUT, PID_SPI_EN, true);
+    GPIO_ConfigurePin(SPI_CLK_PORT, SPI_CLK_PIN, OUTPUT, PID_SPI_CLK, false);
+    GPIO_ConfigurePin(SPI_DO_PORT, SPI_DO_PIN, OUTPUT, PID_SPI_DO, false);
+    GPIO_ConfigurePin(SPI_DI_PORT, SPI_DI_PIN, INPUT, PID_SPI_DI, false);
+    
     // UART2 Debug pins
     GPIO_ConfigurePin(UART2_TX_PORT, UART2_TX_PIN, OUTPUT, PID_UART2_TX, false);
     GPIO_ConfigurePin(UART2_RX_PORT, UART2_RX_PIN, INPUT, PID_UART2_RX, false);
@@ -56,6 +88,12 @@ void set_pad_functions(void) {
  * @brief Reserve GPIO pins to prevent conflicts
  */
 void GPIO_reservations(void) {
+    // Reserve SPI flash pins
+    RESERVE_GPIO(SPI_EN, SPI_EN_PORT, SPI_EN_PIN, PID_SPI_EN);
+    RESERVE_GPIO(SPI_CLK, SPI_CLK_PORT, SPI_CLK_PIN, PID_SPI_CLK);
+    RESERVE_GPIO(SPI_DO, SPI_DO_PORT, SPI_DO_PIN, PID_SPI_DO);
+    RESERVE_GPIO(SPI_DI, SPI_DI_PORT, SPI_DI_PIN, PID_SPI_DI);
+    
     // Reserve UART pins
     RESERVE_GPIO(UART2_TX, UART2_TX_PORT, UART2_TX_PIN, PID_UART2_TX);
     RESERVE_GPIO(UART2_RX, UART2_RX_PORT, UART2_RX_PIN, PID_UART2_RX);
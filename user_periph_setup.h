@@ -11,6 +11,7 @@
 #include "uart.h"
 #include "i2c.h"
 #include "spi.h"
+#include "spi_flash.h"
 #include "arch_system.h"
 
 // UART Configuration for Debug
@@ -35,6 +36,17 @@
 #define GPIO_PRESSURE_PORT      GPIO_PORT_0
 #define GPIO_PRESSURE_PIN       GPIO_PIN_5
 
+// SPI Flash (inside the DA14531MOD: NVM records and OTA image banks)
+#define SPI_EN_PORT             GPIO_PORT_0
+#define SPI_EN_PIN              GPIO_PIN_1
+#define SPI_CLK_PORT            GPIO_PORT_0
+#define SPI_CLK_PIN             GPIO_PIN_4
+#define SPI_DO_PORT             GPIO_PORT_0
+#define SPI_DO_PIN              GPIO_PIN_0
+#define SPI_DI_PORT             GPIO_PORT_0
+#define SPI_DI_PIN              GPIO_PIN_3
+#define SPI_FLASH_DEV_SIZE      (128 * 1024)
+
 // SWD Configuration
 #define SWD_CLK_PORT            GPIO_PORT_0
 #define SWD_CLK_PIN             GPIO_PIN_2
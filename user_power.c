@@ -0,0 +1,164 @@
+/**
+ * @file user_power.c
+ * @brief Battery governor: VBAT tiers that cap rates, advertising and LED use
+ * @author Muhammad Umer Sajid, Student
+ *
+ * VBAT readings are smoothed with an EMA (1/4 per reading, Q4) and mapped to
+ * tiers. A tier is entered below its threshold and only left again
+ * POWER_TIER_HYSTERESIS_MV above it, so the coin cell recovering between
+ * radio bursts does not flip the device back and forth. Each tier caps the
+ * sample and notification rates set over BLE; it never raises them.
+ */
+
+#include <stdio.h>
+#include "user_power.h"
+#include "user_config.h"
+#include "user_ctrl.h"
+
+// Per-Tier Limits
+typedef struct {
+    uint16_t enter_mv;      // Tier starts below this
+    uint8_t max_sample_rate_hz;
+    uint8_t max_tx_rate_hz;
+    uint8_t adv_shift;      // Advertising intervals doubled this many times
+    bool led;               // Jump/status LED pulses (fall alerts always blink)
+    uint16_t avg_current_ua; // Estimated average draw, for the runtime estimate
+} power_limits_t;
+
+static const power_limits_t tier_limits[POWER_TIER_NB] = {
+    [POWER_TIER_NORMAL]   = { 0xFFFF,                  100, 20, 0, true,  900 },
+    [POWER_TIER_ECO]      = { POWER_TIER_ECO_MV,       50,  5,  1, true,  480 },
+    [POWER_TIER_LOW]      = { POWER_TIER_LOW_MV,       25,  2,  2, false, 250 },
+    [POWER_TIER_CRITICAL] = { POWER_TIER_CRITICAL_MV,  10,  1,  3, false, 110 },
+    [POWER_TIER_CUTOFF]   = { POWER_TIER_CUTOFF_MV,    10,  1,  4, false, 60 }
+};
+
+// Remaining charge of a CR2032 under light load (mV, percent)
+static const uint16_t charge_curve[][2] = {
+    { 3000, 100 }, { 2900, 80 }, { 2800, 55 }, { 2700, 30 },
+    { 2600, 15 },  { 2500, 5 },  { 2400, 0 }
+};
+
+#define CHARGE_CURVE_NB                 (sizeof(charge_curve) / sizeof(charge_curve[0]))
+
+// Global Variables
+static uint32_t vbat_q4 = 0;
+static bool have_reading = false;
+static power_tier_t tier = POWER_TIER_NORMAL;
+
+/**
+ * @brief Start in the normal tier until the first reading
+ */
+void user_power_init(void) {
+    vbat_q4 = 0;
+    have_reading = false;
+    tier = POWER_TIER_NORMAL;
+}
+
+/**
+ * @brief Filter a VBAT reading and re-evaluate the tier
+ * @return true if the tier changed
+ */
+bool user_power_update(uint16_t vbat_mv) {
+    power_tier_t old = tier;
+
+    if (!have_reading) {
+        vbat_q4 = (uint32_t)vbat_mv << 4;
+        have_reading = true;
+    } else {
+        vbat_q4 = vbat_q4 + ((int32_t)(((uint32_t)vbat_mv << 4) - vbat_q4) >> 2);
+    }
+
+    uint16_t mv = user_power_vbat_mv();
+
+    // Falling: step down through every threshold crossed
+    while (tier < POWER_TIER_CUTOFF && mv < tier_limits[tier + 1].enter_mv) {
+        tier++;
+    }
+
+    // Rising: only once clear of the hysteresis band
+    while (tier > POWER_TIER_NORMAL && mv >= tier_limits[tier].enter_mv + POWER_TIER_HYSTERESIS_MV) {
+        tier--;
+    }
+
+    if (tier != old) {
+        printf("Power tier %d -> %d at %dmV\n", old, tier, mv);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Current governor tier
+ */
+power_tier_t user_power_tier(void) {
+    return tier;
+}
+
+/**
+ * @brief Filtered battery voltage
+ */
+uint16_t user_power_vbat_mv(void) {
+    return (uint16_t)((vbat_q4 + 8) >> 4);
+}
+
+/**
+ * @brief Sample rate: the BLE setting capped by the tier
+ */
+uint8_t user_power_sample_rate(void) {
+    uint8_t rate = user_ctrl_settings()->sample_rate_hz;
+    return (rate > tier_limits[tier].max_sample_rate_hz) ? tier_limits[tier].max_sample_rate_hz : rate;
+}
+
+/**
+ * @brief Notification rate: the BLE setting capped by the tier
+ */
+uint8_t user_power_tx_rate(void) {
+    uint8_t rate = user_ctrl_settings()->tx_rate_hz;
+    return (rate > tier_limits[tier].max_tx_rate_hz) ? tier_limits[tier].max_tx_rate_hz : rate;
+}
+
+/**
+ * @brief Advertising interval scaling (power of two)
+ */
+uint8_t user_power_adv_shift(void) {
+    return tier_limits[tier].adv_shift;
+}
+
+/**
+ * @brief Check if non-alert LED pulses are allowed
+ */
+bool user_power_led_allowed(void) {
+    return tier_limits[tier].led;
+}
+
+/**
+ * @brief Remaining charge estimate from the filtered voltage
+ */
+uint8_t user_power_percent(void) {
+    uint16_t mv = user_power_vbat_mv();
+
+    if (mv >= charge_curve[0][0]) {
+        return 100;
+    }
+
+    for (uint8_t i = 1; i < CHARGE_CURVE_NB; i++) {
+        if (mv >= charge_curve[i][0]) {
+            uint16_t span_mv = charge_curve[i - 1][0] - charge_curve[i][0];
+            uint16_t span_pct = charge_curve[i - 1][1] - charge_curve[i][1];
+            return (uint8_t)(charge_curve[i][1] + ((mv - charge_curve[i][0]) * span_pct) / span_mv);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Remaining runtime at the current tier's average draw
+ */
+uint16_t user_power_hours_left(void) {
+    // percent/100 * mAh * 1000 uAh / uA
+    uint32_t hours = ((uint32_t)user_power_percent() * POWER_BATTERY_CAPACITY_MAH * 10) /
+                     tier_limits[tier].avg_current_ua;
+    return (hours > 0xFFFF) ? 0xFFFF : (uint16_t)hours;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file user_power.h
+ * @brief Battery governor: VBAT tiers that cap rates, advertising and LED use
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_POWER_H_
+#define USER_POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Battery Status Packet (battery status characteristic)
+// [0xCC][Battery mV u16][Percent][Tier][Hours left u16]
+#define POWER_STATUS_LEN                7
+
+// Governor Tiers (ordered by falling VBAT)
+typedef enum {
+    POWER_TIER_NORMAL = 0,
+    POWER_TIER_ECO,
+    POWER_TIER_LOW,
+    POWER_TIER_CRITICAL,
+    POWER_TIER_CUTOFF,      // Logs flushed, streaming stopped
+    POWER_TIER_NB
+} power_tier_t;
+
+// Function Prototypes
+void user_power_init(void);
+bool user_power_update(uint16_t vbat_mv);
+power_tier_t user_power_tier(void);
+uint16_t user_power_vbat_mv(void);
+uint8_t user_power_sample_rate(void);
+uint8_t user_power_tx_rate(void);
+uint8_t user_power_adv_shift(void);
+bool user_power_led_allowed(void);
+uint8_t user_power_percent(void);
+uint16_t user_power_hours_left(void);
+
+#endif // USER_POWER_H_
@@ -0,0 +1,38 @@
+/**
+ * @file user_pressure.h
+ * @brief Pressure channel: CIC decimation, LUT calibration and load rate
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_PRESSURE_H_
+#define USER_PRESSURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "user_config.h"
+
+// Filter Output (12-bit raw, PRESSURE_PA_PER_LSB per calibrated LSB)
+#define PRESSURE_RAW_BITS               12
+#define PRESSURE_RAW_MAX                ((1 << PRESSURE_RAW_BITS) - 1)
+#define PRESSURE_PA_PER_LSB             25
+
+// Calibration Table (piecewise linear, equal raw segments)
+#define PRESSURE_CAL_SEG_SHIFT          8
+#define PRESSURE_CAL_POINTS             ((1 << (PRESSURE_RAW_BITS - PRESSURE_CAL_SEG_SHIFT)) + 1)
+#define PRESSURE_CAL_LEN                (PRESSURE_CAL_POINTS * 2)
+
+typedef struct {
+    uint16_t raw;           // Decimated 12-bit ADC code
+    uint16_t pressure;      // Calibrated, 25 Pa per LSB
+    int32_t load_rate;      // 25 Pa/s per LSB
+} pressure_out_t;
+
+// Function Prototypes
+void user_pressure_init(void);
+void user_pressure_push(uint16_t adc_raw);
+void user_pressure_decimate(uint8_t sample_rate_hz, pressure_out_t *out);
+bool user_pressure_set_calibration(const uint8_t *points);
+void user_pressure_get_calibration(uint8_t *points);
+void user_pressure_save_poll(void);
+
+#endif // USER_PRESSURE_H_
@@ -0,0 +1,102 @@
+/**
+ * @file user_profile.c
+ * @brief Cycle-count profiling of the sampling loop hot paths
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The Cortex-M0+ has no DWT cycle counter, so SysTick runs free from the
+ * core clock as a 24-bit down counter. Sections must stay below 2^24 cycles
+ * (~1s at 16MHz), which holds for everything in the sampling loop.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_profile.h"
+#include "datasheet.h"
+
+#define SYSTICK_MASK                    0x00FFFFFF
+
+// Budgets per call, average above this is reported as a regression
+static const uint32_t prof_budget[PROF_SECTION_NB] = {
+    [PROF_READ_SENSORS] = PROFILE_BUDGET_READ_SENSORS,
+    [PROF_DETECT_JUMP]  = PROFILE_BUDGET_DETECT_JUMP,
+    [PROF_BLE_TRANSMIT] = PROFILE_BUDGET_BLE_TRANSMIT,
+    [PROF_GAIT]         = PROFILE_BUDGET_GAIT,
+    [PROF_PRESSURE]     = PROFILE_BUDGET_PRESSURE,
+    [PROF_REPS]         = PROFILE_BUDGET_REPS
+};
+
+static const char *const prof_name[PROF_SECTION_NB] = {
+    [PROF_READ_SENSORS] = "read_sensors",
+    [PROF_DETECT_JUMP]  = "detect_jump",
+    [PROF_BLE_TRANSMIT] = "ble_transmit",
+    [PROF_GAIT]         = "gait",
+    [PROF_PRESSURE]     = "pressure",
+    [PROF_REPS]         = "reps"
+};
+
+// Global Variables
+static prof_stats_t prof_stats[PROF_SECTION_NB];
+
+/**
+ * @brief Start SysTick as a free-running cycle counter
+ */
+void user_profile_init(void) {
+    SysTick->LOAD = SYSTICK_MASK;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    memset(prof_stats, 0, sizeof(prof_stats));
+}
+
+/**
+ * @brief Current cycle counter value (counts down)
+ */
+uint32_t user_profile_now(void) {
+    return SysTick->VAL;
+}
+
+/**
+ * @brief Account the cycles spent since start to a section
+ */
+void user_profile_record(prof_section_t section, uint32_t start) {
+    uint32_t cycles = (start - SysTick->VAL) & SYSTICK_MASK;
+    prof_stats_t *stats = &prof_stats[section];
+
+    if (stats->calls == 0 || cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->total_cycles += cycles;
+    stats->calls++;
+}
+
+/**
+ * @brief Copy statistics of one section
+ */
+void user_profile_get(prof_section_t section, prof_stats_t *stats) {
+    *stats = prof_stats[section];
+}
+
+/**
+ * @brief Print per-section cycles, compare with budget and start a new window
+ */
+void user_profile_report(void) {
+    for (uint8_t i = 0; i < PROF_SECTION_NB; i++) {
+        prof_stats_t *stats = &prof_stats[i];
+
+        if (stats->calls == 0) {
+            continue;
+        }
+
+        uint32_t avg = stats->total_cycles / stats->calls;
+        printf("PROF %s: avg %lu min %lu max %lu cyc (%lu calls)%s\n",
+               prof_name[i], (unsigned long)avg,
+               (unsigned long)stats->min_cycles, (unsigned long)stats->max_cycles,
+               (unsigned long)stats->calls,
+               (avg > prof_budget[i]) ? " OVER BUDGET" : "");
+    }
+
+    memset(prof_stats, 0, sizeof(prof_stats));
+}
@@ -0,0 +1,51 @@
+/**
+ * @file user_profile.h
+ * @brief Cycle-count profiling of the sampling loop hot paths
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_PROFILE_H_
+#define USER_PROFILE_H_
+
+#include <stdint.h>
+#include "user_config.h"
+
+// Profiled Sections
+typedef enum {
+    PROF_READ_SENSORS = 0,
+    PROF_DETECT_JUMP,
+    PROF_BLE_TRANSMIT,
+    PROF_GAIT,
+    PROF_PRESSURE,
+    PROF_REPS,
+    PROF_SECTION_NB
+} prof_section_t;
+
+// Per-Section Statistics (since last report)
+typedef struct {
+    uint32_t calls;
+    uint32_t total_cycles;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+} prof_stats_t;
+
+#if CFG_PROFILE_HOT_PATHS
+    #define PROFILE_BEGIN()             uint32_t prof_start_ = user_profile_now()
+    #define PROFILE_END(section)        user_profile_record((section), prof_start_)
+    #define PROFILE_BEGIN_AT(name)      uint32_t name = user_profile_now()
+    #define PROFILE_END_AT(section, name) user_profile_record((section), name)
+#else
+    #define PROFILE_BEGIN()
+    #define PROFILE_END(section)
+    #define PROFILE_BEGIN_AT(name)
+    #define PROFILE_END_AT(section, name)
+#endif
+
+// Function Prototypes
+void user_profile_init(void);
+uint32_t user_profile_now(void);
+void user_profile_record(prof_section_t section, uint32_t start);
+void user_profile_get(prof_section_t section, prof_stats_t *stats);
+void user_profile_report(void);
+
+#endif // USER_PROFILE_H_
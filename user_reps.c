@@ -0,0 +1,452 @@
+/**
+ * @file user_reps.c
+ * @brief Exercise repetition counter by template matching (medical mode)
+ * @author Muhammad Umer Sajid, Student
+ *
+ * The IMU is block-averaged to REPS_RATE_HZ and kept as int8 (16 mg) per
+ * axis. At every new block the last Len samples of each loaded template's
+ * axis are mean-removed and compared with the template by banded DTW
+ * (sum of |difference| along the path). An LB_Keogh bound against the
+ * template envelope rejects most windows in O(Len) before DTW runs, and DTW
+ * stops as soon as a whole row is above the threshold. A run of matches
+ * counts one rep at its best distance; a pause of REPS_SET_GAP_MS closes
+ * the set. Templates are stored in NVM.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_reps.h"
+#include "user_nvm.h"
+
+#define REPS_TEMPLATE_VERSION           1
+#define REPS_BLOCK_MS                   (1000 / REPS_RATE_HZ)
+#define REPS_DIST_INF                   0xFFFF
+#define REPS_SLOT_EMPTY                 0xFF
+
+// Stored template (mean removed)
+typedef struct {
+    uint8_t axis;           // REPS_AXIS_*, REPS_SLOT_EMPTY when unused
+    uint8_t len;
+    uint16_t threshold;     // DTW distance limit, REPS_LSB_MG units
+    int8_t samples[REPS_TEMPLATE_MAX_LEN];
+} reps_template_t;
+
+// Matcher state per template
+typedef struct {
+    int8_t upper[REPS_TEMPLATE_MAX_LEN];    // LB_Keogh envelope
+    int8_t lower[REPS_TEMPLATE_MAX_LEN];
+    bool armed;
+    uint8_t run;
+    uint8_t holdoff;
+    uint16_t best;
+    uint16_t best_rom_mg;
+    uint32_t best_ms;
+} reps_match_t;
+
+// Global Variables
+static reps_template_t templates[REPS_TEMPLATE_SLOTS];
+static reps_match_t match[REPS_TEMPLATE_SLOTS];
+static bool save_pending = false;
+
+// Downsampler and window ring
+static uint32_t block_end_ms = 0;
+static int32_t block_sum[REPS_AXIS_NB];
+static uint8_t block_count = 0;
+static int8_t ring[REPS_AXIS_NB][REPS_TEMPLATE_MAX_LEN];
+static uint8_t ring_head = 0;
+static uint8_t ring_fill = 0;
+
+// DTW scratch
+static int16_t window[REPS_TEMPLATE_MAX_LEN];
+static uint16_t dtw_row[2][REPS_TEMPLATE_MAX_LEN];
+
+// Current set
+static uint8_t set_slot = REPS_SLOT_EMPTY;
+static uint16_t set_reps = 0;
+static uint32_t set_first_ms = 0;
+static uint32_t set_last_ms = 0;
+static uint32_t set_rom_sum = 0;
+static uint16_t sets_done = 0;
+static reps_set_t pending_set;
+static bool set_ready = false;
+
+// Local Functions
+static void envelope_update(uint8_t slot);
+static uint16_t window_distance(uint8_t slot, uint16_t *rom_mg);
+static void match_update(uint8_t slot, uint16_t dist, uint16_t rom_mg, uint32_t now_ms);
+static void set_close(void);
+
+/**
+ * @brief Load templates from NVM
+ */
+void user_reps_init(void) {
+    if (user_nvm_read(NVM_RECORD_REP_TEMPLATES, REPS_TEMPLATE_VERSION, templates, sizeof(templates))) {
+        printf("Rep templates loaded from NVM\n");
+    } else {
+        for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+            templates[slot].axis = REPS_SLOT_EMPTY;
+            templates[slot].len = 0;
+        }
+    }
+
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        envelope_update(slot);
+    }
+
+    user_reps_reset();
+}
+
+/**
+ * @brief Drop the window and any open set (mode change)
+ */
+void user_reps_reset(void) {
+    block_count = 0;
+    ring_head = 0;
+    ring_fill = 0;
+    set_slot = REPS_SLOT_EMPTY;
+    set_reps = 0;
+
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        match[slot].armed = false;
+        match[slot].holdoff = 0;
+    }
+}
+
+/**
+ * @brief Feed one IMU sample (any rate)
+ */
+void user_reps_process(const reps_sample_t *sample) {
+    uint8_t loaded = 0;
+
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        loaded |= (templates[slot].len > 0);
+    }
+    if (!loaded) {
+        return;
+    }
+
+    if (ring_fill == 0 && block_count == 0) {
+        block_end_ms = sample->time_ms + REPS_BLOCK_MS;
+    }
+    if (block_count == 0) {
+        memset(block_sum, 0, sizeof(block_sum));
+    }
+    block_sum[REPS_AXIS_X] += sample->accel[0];
+    block_sum[REPS_AXIS_Y] += sample->accel[1];
+    block_sum[REPS_AXIS_Z] += sample->accel[2];
+    block_sum[REPS_AXIS_MAG] += sample->accel_mg;
+    block_count++;
+
+    if ((int32_t)(sample->time_ms - block_end_ms) < 0) {
+        return;
+    }
+
+    // Fixed block grid, restarted after a gap (rate change, mode switch)
+    block_end_ms += REPS_BLOCK_MS;
+    if ((int32_t)(sample->time_ms - block_end_ms) >= 0) {
+        block_end_ms = sample->time_ms + REPS_BLOCK_MS;
+    }
+
+    // Close the block: one int8 per axis into the ring
+    for (uint8_t axis = 0; axis < REPS_AXIS_NB; axis++) {
+        int32_t v = block_sum[axis] / ((int32_t)block_count * REPS_LSB_MG);
+        ring[axis][ring_head] = (int8_t)((v > 127) ? 127 : ((v < -127) ? -127 : v));
+    }
+    block_count = 0;
+    ring_head = (ring_head + 1) % REPS_TEMPLATE_MAX_LEN;
+    if (ring_fill < REPS_TEMPLATE_MAX_LEN) {
+        ring_fill++;
+    }
+
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        if (templates[slot].len == 0 || ring_fill < templates[slot].len) {
+            continue;
+        }
+
+        // One exercise per set, other templates wait for it to close
+        if (set_reps > 0 && set_slot != slot) {
+            continue;
+        }
+
+        uint16_t rom_mg = 0;
+        uint16_t dist = window_distance(slot, &rom_mg);
+        match_update(slot, dist, rom_mg, sample->time_ms);
+    }
+
+    if (set_reps > 0 && (sample->time_ms - set_last_ms) > REPS_SET_GAP_MS) {
+        set_close();
+    }
+}
+
+/**
+ * @brief Take the last finished set
+ * @return false when no set finished since the last call
+ */
+bool user_reps_take_set(reps_set_t *set) {
+    if (!set_ready) {
+        return false;
+    }
+
+    *set = pending_set;
+    set_ready = false;
+    return true;
+}
+
+/**
+ * @brief Store a template from the control register
+ * @return false when the value is out of range
+ */
+bool user_reps_set_template(const uint8_t *blob) {
+    uint8_t slot = blob[0];
+    uint8_t axis = blob[1];
+    uint16_t threshold = (uint16_t)(blob[2] | (blob[3] << 8));
+    uint8_t len = blob[4];
+    const int8_t *samples = (const int8_t *)&blob[5];
+
+    if (slot >= REPS_TEMPLATE_SLOTS) {
+        return false;
+    }
+
+    reps_template_t *tpl = &templates[slot];
+
+    if (len == 0) {
+        tpl->axis = REPS_SLOT_EMPTY;
+        tpl->len = 0;
+    } else {
+        if (axis >= REPS_AXIS_NB || threshold == 0 ||
+            len < REPS_TEMPLATE_MIN_LEN || len > REPS_TEMPLATE_MAX_LEN) {
+            return false;
+        }
+
+        // Matching is offset free: store the template around its mean
+        int32_t sum = 0;
+        for (uint8_t i = 0; i < len; i++) {
+            sum += samples[i];
+        }
+        int32_t mean = sum / len;
+
+        tpl->axis = axis;
+        tpl->len = len;
+        tpl->threshold = threshold;
+        for (uint8_t i = 0; i < len; i++) {
+            int32_t v = samples[i] - mean;
+            tpl->samples[i] = (int8_t)((v > 127) ? 127 : ((v < -127) ? -127 : v));
+        }
+    }
+
+    envelope_update(slot);
+    match[slot].armed = false;
+    match[slot].holdoff = 0;
+    save_pending = true;
+    return true;
+}
+
+/**
+ * @brief Encode the status register
+ */
+void user_reps_get_status(uint8_t *out) {
+    uint8_t mask = 0;
+
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        mask |= (templates[slot].len > 0) ? (1 << slot) : 0;
+    }
+
+    out[0] = mask;
+    out[1] = (set_reps > 0) ? set_slot : REPS_SLOT_EMPTY;
+    out[2] = (uint8_t)(set_reps & 0xFF);
+    out[3] = (uint8_t)(set_reps >> 8);
+    out[4] = (uint8_t)(sets_done & 0xFF);
+    out[5] = (uint8_t)(sets_done >> 8);
+}
+
+/**
+ * @brief Write changed templates to NVM from the sampling loop (sector erase blocks)
+ */
+void user_reps_save_poll(void) {
+    if (!save_pending) {
+        return;
+    }
+
+    save_pending = false;
+    if (user_nvm_write(NVM_RECORD_REP_TEMPLATES, REPS_TEMPLATE_VERSION, templates, sizeof(templates))) {
+        printf("Rep templates saved\n");
+    }
+}
+
+/**
+ * @brief Min/max of the template over the DTW band (LB_Keogh envelope)
+ */
+static void envelope_update(uint8_t slot) {
+    const reps_template_t *tpl = &templates[slot];
+
+    for (uint8_t i = 0; i < tpl->len; i++) {
+        uint8_t lo = (i > REPS_DTW_BAND) ? (i - REPS_DTW_BAND) : 0;
+        uint8_t hi = (i + REPS_DTW_BAND < tpl->len) ? (i + REPS_DTW_BAND) : (tpl->len - 1);
+        int8_t up = tpl->samples[lo];
+        int8_t down = tpl->samples[lo];
+
+        for (uint8_t j = lo + 1; j <= hi; j++) {
+            up = (tpl->samples[j] > up) ? tpl->samples[j] : up;
+            down = (tpl->samples[j] < down) ? tpl->samples[j] : down;
+        }
+        match[slot].upper[i] = up;
+        match[slot].lower[i] = down;
+    }
+}
+
+/**
+ * @brief DTW distance between the newest window and a template
+ * @param rom_mg Peak-to-peak of the window
+ * @return Distance, REPS_DIST_INF once it is known to exceed the threshold
+ */
+static uint16_t window_distance(uint8_t slot, uint16_t *rom_mg) {
+    const reps_template_t *tpl = &templates[slot];
+    const reps_match_t *m = &match[slot];
+    const int8_t *src = ring[tpl->axis];
+    uint8_t len = tpl->len;
+    uint8_t pos = (ring_head + REPS_TEMPLATE_MAX_LEN - len) % REPS_TEMPLATE_MAX_LEN;
+    int16_t sum = 0;
+    int8_t lo = 127;
+    int8_t hi = -127;
+
+    for (uint8_t i = 0; i < len; i++) {
+        int8_t v = src[pos];
+        window[i] = v;
+        sum += v;
+        lo = (v < lo) ? v : lo;
+        hi = (v > hi) ? v : hi;
+        pos = (pos + 1) % REPS_TEMPLATE_MAX_LEN;
+    }
+    *rom_mg = (uint16_t)((hi - lo) * REPS_LSB_MG);
+
+    // Mean removal, then LB_Keogh with early abandon
+    int16_t mean = sum / len;
+    uint16_t bound = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        int16_t v = window[i] - mean;
+        window[i] = v;
+
+        if (v > m->upper[i]) {
+            bound += v - m->upper[i];
+        } else if (v < m->lower[i]) {
+            bound += m->lower[i] - v;
+        }
+        if (bound > tpl->threshold) {
+            return REPS_DIST_INF;
+        }
+    }
+
+    // Banded DTW on two rows, abandoned when a whole row is over the threshold
+    uint16_t *prev = dtw_row[0];
+    uint16_t *cur = dtw_row[1];
+
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t jlo = (i > REPS_DTW_BAND) ? (i - REPS_DTW_BAND) : 0;
+        uint8_t jhi = (i + REPS_DTW_BAND < len) ? (i + REPS_DTW_BAND) : (len - 1);
+        uint16_t row_min = REPS_DIST_INF;
+
+        for (uint8_t j = jlo; j <= jhi; j++) {
+            int16_t diff = window[i] - tpl->samples[j];
+            uint16_t best = (i == 0 && j == 0) ? 0 : REPS_DIST_INF;
+
+            if (i > 0) {
+                // prev[] is only valid inside the previous row's band
+                if (j + 1 <= i + REPS_DTW_BAND && prev[j] < best) {
+                    best = prev[j];
+                }
+                if (j > 0 && prev[j - 1] < best) {
+                    best = prev[j - 1];
+                }
+            }
+            if (j > jlo && cur[j - 1] < best) {
+                best = cur[j - 1];
+            }
+
+            uint32_t cell = (uint32_t)best + (uint16_t)((diff < 0) ? -diff : diff);
+            cur[j] = (cell >= REPS_DIST_INF) ? REPS_DIST_INF : (uint16_t)cell;
+            row_min = (cur[j] < row_min) ? cur[j] : row_min;
+        }
+
+        if (row_min > tpl->threshold) {
+            return REPS_DIST_INF;
+        }
+
+        uint16_t *swap = prev;
+        prev = cur;
+        cur = swap;
+    }
+
+    return prev[len - 1];
+}
+
+/**
+ * @brief Turn a run of matching windows into one rep at its best distance
+ */
+static void match_update(uint8_t slot, uint16_t dist, uint16_t rom_mg, uint32_t now_ms) {
+    reps_match_t *m = &match[slot];
+    uint8_t half = templates[slot].len / 2;
+
+    // Overlapping windows of the same rep
+    if (m->holdoff > 0) {
+        m->holdoff--;
+        return;
+    }
+
+    if (dist <= templates[slot].threshold) {
+        if (!m->armed || dist < m->best) {
+            m->best = dist;
+            m->best_rom_mg = rom_mg;
+            m->best_ms = now_ms;
+        }
+        if (!m->armed) {
+            m->armed = true;
+            m->run = 0;
+        }
+        if (++m->run < half) {
+            return;
+        }
+    } else if (!m->armed) {
+        return;
+    }
+
+    // Run ended (or reached half a template): count it
+    m->armed = false;
+    m->holdoff = half;
+
+    if (set_reps == 0) {
+        set_slot = slot;
+        set_first_ms = m->best_ms;
+        set_rom_sum = 0;
+    }
+    set_reps++;
+    set_last_ms = m->best_ms;
+    set_rom_sum += m->best_rom_mg;
+}
+
+/**
+ * @brief Publish the open set if it has enough reps
+ */
+static void set_close(void) {
+    if (set_reps >= REPS_MIN_PER_SET) {
+        uint32_t span = set_last_ms - set_first_ms;
+
+        pending_set.set = sets_done++;
+        pending_set.slot = set_slot;
+        pending_set.reps = set_reps;
+        pending_set.tempo_ms = (uint16_t)(span / (set_reps - 1));
+        pending_set.rom_mg = (uint16_t)(set_rom_sum / set_reps);
+        pending_set.duration_s = (uint16_t)(span / 1000);
+        set_ready = true;
+
+        printf("Set %d: %d reps, tempo %dms, ROM %dmg\n", pending_set.set, pending_set.reps,
+               pending_set.tempo_ms, pending_set.rom_mg);
+    }
+
+    set_slot = REPS_SLOT_EMPTY;
+    set_reps = 0;
+    for (uint8_t slot = 0; slot < REPS_TEMPLATE_SLOTS; slot++) {
+        match[slot].armed = false;
+        match[slot].holdoff = 0;
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file user_reps.h
+ * @brief Exercise repetition counter by template matching (medical mode)
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_REPS_H_
+#define USER_REPS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Matching Parameters
+#define REPS_RATE_HZ                    10      // IMU is block-averaged down to this rate
+#define REPS_LSB_MG                     16      // Template and window units (int8, +-2g)
+#define REPS_TEMPLATE_SLOTS             3
+#define REPS_TEMPLATE_MIN_LEN           8
+#define REPS_TEMPLATE_MAX_LEN           32      // 3.2s at REPS_RATE_HZ
+#define REPS_DTW_BAND                   4       // Sakoe-Chiba half width, samples
+#define REPS_SET_GAP_MS                 8000    // Longer pause closes the set
+#define REPS_MIN_PER_SET                2
+
+// Template Register (CTRL_REG_REP_TEMPLATE, write only)
+// [Slot][Axis][Threshold u16][Len][Samples i8 x REPS_TEMPLATE_MAX_LEN], Len 0 clears the slot
+#define REPS_TEMPLATE_BLOB_LEN          (5 + REPS_TEMPLATE_MAX_LEN)
+
+// Status Register (CTRL_REG_REP_STATUS)
+// [Loaded slots mask][Set slot or 0xFF][Set reps u16][Sets u16]
+#define REPS_STATUS_LEN                 6
+
+// Template Axes
+typedef enum {
+    REPS_AXIS_X = 0,
+    REPS_AXIS_Y,
+    REPS_AXIS_Z,
+    REPS_AXIS_MAG,
+    REPS_AXIS_NB
+} reps_axis_t;
+
+// Input Sample
+typedef struct {
+    uint32_t time_ms;
+    int16_t accel[3];       // mg
+    uint16_t accel_mg;      // Magnitude
+} reps_sample_t;
+
+// Per-Set Summary
+typedef struct {
+    uint16_t set;
+    uint8_t slot;           // Template that matched
+    uint16_t reps;
+    uint16_t tempo_ms;      // Mean time between reps
+    uint16_t rom_mg;        // Mean peak-to-peak on the template axis
+    uint16_t duration_s;
+} reps_set_t;
+
+// Function Prototypes
+void user_reps_init(void);
+void user_reps_reset(void);
+void user_reps_process(const reps_sample_t *sample);
+bool user_reps_take_set(reps_set_t *set);
+bool user_reps_set_template(const uint8_t *blob);
+void user_reps_get_status(uint8_t *out);
+void user_reps_save_poll(void);
+
+#endif // USER_REPS_H_
@@ -0,0 +1,242 @@
+/**
+ * @file user_time_sync.c
+ * @brief Time synchronization with the central (shared timebase)
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Two-way exchange per sync round:
+ *   1. Central writes SYNC_REQ [seq][T1], band stamps T2 on receipt
+ *   2. Band notifies [0xDD][SYNC_REQ][seq][T2][T3], T3 stamped at send
+ *   3. Central writes SYNC_RESULT [seq][T1][T4], T4 = central receive time
+ *   4. Band notifies [0xDD][SYNC_RESULT][seq][accepted][residual][drift ppb]
+ * Offset sample (central - local) = ((T1 - T2) + (T4 - T3)) / 2 feeds an
+ * alpha-beta filter that tracks offset and drift between rounds.
+ *
+ * One central owns the filter until it disconnects; requests from other
+ * centrals are ignored. Timestamps on the wire are mod 2^32 us, the filter
+ * reference is kept in the 64-bit local clock so drift is extrapolated
+ * correctly across the 71.6 min wrap.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "user_time_sync.h"
+#include "user_custs1_def.h"
+#include "user_custs1_impl.h"
+#include "user_packets.h"
+
+// Pending exchange (one in flight per sync master)
+typedef struct {
+    uint8_t seq;
+    bool valid;
+    uint32_t t2;
+    uint32_t t3;
+} sync_exchange_t;
+
+// Filter State (offset mod 2^32 us)
+typedef struct {
+    bool synced;
+    bool owned;                 // master_conidx is connected and owns the filter
+    bool restart;               // New owner: next accepted sample restarts the filter
+    uint8_t master_conidx;
+    uint8_t samples;
+    uint64_t ref_local;
+    uint32_t offset;
+    int32_t drift;
+    int32_t last_residual;
+    uint32_t last_rtt;
+} sync_state_t;
+
+// Global Variables
+static sync_exchange_t exchange = {0};
+static sync_state_t sync = {0};
+
+// Local Functions
+static int32_t drift_correction(uint64_t local_us);
+static void filter_update(uint64_t local_us, uint32_t measured_offset);
+static uint64_t local_extend(uint32_t local_us);
+
+/**
+ * @brief Forget the current estimate (e.g. sync master changed)
+ */
+void user_time_sync_reset(void) {
+    memset(&exchange, 0, sizeof(exchange));
+    memset(&sync, 0, sizeof(sync));
+}
+
+/**
+ * @brief Handle SYNC_REQ: answer with receive and transmit timestamps
+ */
+void user_time_sync_on_request(uint8_t conidx, uint8_t seq, uint32_t rx_local_us) {
+    // Timestamps from two centrals cannot share one filter
+    if (!sync.owned) {
+        // Keep extrapolating the old estimate until the new owner's first sample
+        sync.owned = true;
+        sync.restart = sync.synced;
+        sync.master_conidx = conidx;
+    } else if (conidx != sync.master_conidx) {
+        printf("Time sync from conn %d ignored, owned by %d\n", conidx, sync.master_conidx);
+        return;
+    }
+
+    exchange.seq = seq;
+    exchange.valid = true;
+    exchange.t2 = rx_local_us;
+
+    // T3 taken as late as possible before the message is queued
+    exchange.t3 = user_get_time_us();
+
+    pkt_time_sync_req_t pkt = {
+        .seq = seq,
+        .t2 = exchange.t2,
+        .t3 = exchange.t3
+    };
+    user_pkt_time_sync_req_send(conidx, &pkt);
+}
+
+/**
+ * @brief Handle SYNC_RESULT: compute offset sample and update the filter
+ * @return true if the sample was accepted
+ */
+bool user_time_sync_on_result(uint8_t conidx, uint8_t seq, uint32_t central_t1_us,
+                              uint32_t central_t4_us) {
+    if (!exchange.valid || exchange.seq != seq || conidx != sync.master_conidx) {
+        return false;
+    }
+    exchange.valid = false;
+
+    // Round trip minus time spent on the band
+    uint32_t rtt = (central_t4_us - central_t1_us) - (exchange.t3 - exchange.t2);
+    bool accepted = (rtt <= TIME_SYNC_MAX_RTT_US);
+    sync.last_rtt = rtt;
+
+    if (accepted) {
+        // Midpoint of both legs; legs differ by the (small) path delay, so
+        // averaging via their difference stays correct for any offset mod 2^32
+        uint32_t fwd = central_t1_us - exchange.t2;
+        uint32_t back = central_t4_us - exchange.t3;
+        uint32_t measured = fwd + (uint32_t)((int32_t)(back - fwd) / 2);
+
+        // Offset is tracked relative to T2, the local receive instant
+        filter_update(local_extend(exchange.t2), measured);
+    } else {
+        printf("Time sync rejected: rtt %luus\n", (unsigned long)rtt);
+    }
+
+    // Report sync quality back so the app can decide when to stop
+    time_sync_quality_t quality;
+    user_time_sync_get_quality(&quality);
+
+    pkt_time_sync_result_t pkt = {
+        .seq = seq,
+        .accepted = (uint8_t)accepted,
+        .residual_us = quality.last_residual_us,
+        .drift_ppb = quality.drift_ppb
+    };
+    user_pkt_time_sync_result_send(conidx, &pkt);
+    return accepted;
+}
+
+/**
+ * @brief Release the filter when its owner disconnects
+ */
+void user_time_sync_on_disconnect(uint8_t conidx) {
+    if (sync.owned && conidx == sync.master_conidx) {
+        sync.owned = false;
+        exchange.valid = false;
+    }
+}
+
+/**
+ * @brief Convert a local timestamp to the shared (central) timebase
+ * @param local_us Local time mod 2^32, within 35 min of now
+ */
+uint32_t user_time_sync_to_shared(uint32_t local_us) {
+    if (!sync.synced) {
+        return local_us;
+    }
+
+    return local_us + sync.offset + (uint32_t)drift_correction(local_extend(local_us));
+}
+
+/**
+ * @brief Report current sync quality
+ */
+void user_time_sync_get_quality(time_sync_quality_t *quality) {
+    quality->synced = sync.synced;
+    quality->samples = sync.samples;
+    quality->last_residual_us = sync.last_residual;
+    quality->drift_ppb = (int32_t)(((int64_t)sync.drift * 1000000000LL) >> TIME_SYNC_DRIFT_SHIFT);
+    quality->last_rtt_us = sync.last_rtt;
+}
+
+/**
+ * @brief Offset accumulated by drift since the filter reference point
+ */
+static int32_t drift_correction(uint64_t local_us) {
+    // Negative for stamps taken before the last accepted exchange
+    int64_t elapsed = (int64_t)(local_us - sync.ref_local);
+    return (int32_t)(((int64_t)sync.drift * elapsed) >> TIME_SYNC_DRIFT_SHIFT);
+}
+
+/**
+ * @brief Place a 32-bit local stamp on the 64-bit clock, nearest to now
+ */
+static uint64_t local_extend(uint32_t local_us) {
+    uint64_t now = user_get_time_us64();
+    return now - (int64_t)(int32_t)((uint32_t)now - local_us);
+}
+
+/**
+ * @brief Alpha-beta update of offset and drift
+ */
+static void filter_update(uint64_t local_us, uint32_t measured_offset) {
+    if (!sync.synced || sync.restart) {
+        sync.synced = true;
+        sync.restart = false;
+        sync.ref_local = local_us;
+        sync.offset = measured_offset;
+        sync.drift = 0;
+        sync.last_residual = 0;
+        sync.samples = 1;
+        return;
+    }
+
+    uint64_t elapsed = local_us - sync.ref_local;
+    uint32_t predicted = sync.offset + (uint32_t)drift_correction(local_us);
+    int32_t residual = (int32_t)(measured_offset - predicted);
+
+    // Converge fast on the first rounds, then smooth BLE latency jitter
+    uint8_t alpha_shift = 4;
+    uint8_t beta_shift = 7;
+    if (sync.samples < TIME_SYNC_FAST_SAMPLES) {
+        alpha_shift = 1;
+        beta_shift = 1;
+    } else if (sync.samples < TIME_SYNC_SETTLE_SAMPLES) {
+        alpha_shift = 2;
+        beta_shift = 3;
+    } else if (sync.samples < TIME_SYNC_STEADY_SAMPLES) {
+        alpha_shift = 3;
+        beta_shift = 5;
+    }
+
+    if (elapsed >= TIME_SYNC_MIN_SPAN_US) {
+        int64_t step = ((int64_t)residual * (1 << TIME_SYNC_DRIFT_SHIFT)) / (int64_t)elapsed;
+        int32_t drift = sync.drift + (int32_t)(step >> beta_shift);
+
+        if (drift > TIME_SYNC_DRIFT_LIMIT) {
+            drift = TIME_SYNC_DRIFT_LIMIT;
+        } else if (drift < -TIME_SYNC_DRIFT_LIMIT) {
+            drift = -TIME_SYNC_DRIFT_LIMIT;
+        }
+        sync.drift = drift;
+    }
+
+    // Move the reference to this sample
+    sync.offset = predicted + (uint32_t)(residual >> alpha_shift);
+    sync.ref_local = local_us;
+    sync.last_residual = residual;
+
+    if (sync.samples < 0xFF) {
+        sync.samples++;
+    }
+}
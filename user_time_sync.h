@@ -0,0 +1,44 @@
+/**
+ * @file user_time_sync.h
+ * @brief Time synchronization with the central (shared timebase)
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_TIME_SYNC_H_
+#define USER_TIME_SYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Filter Configuration
+#define TIME_SYNC_DRIFT_SHIFT           24      // Drift in 2^-24 us/us (~0.06 ppm)
+#define TIME_SYNC_DRIFT_LIMIT           8389    // +/-500 ppm
+#define TIME_SYNC_MAX_RTT_US            250000  // Reject slower exchanges
+#define TIME_SYNC_MIN_SPAN_US           500000  // Min spacing for drift updates
+#define TIME_SYNC_FAST_SAMPLES          4       // High gain until converged
+#define TIME_SYNC_SETTLE_SAMPLES        16      // Medium gain, then low gain
+#define TIME_SYNC_STEADY_SAMPLES        48      // Lowest gain once drift has settled
+
+// Sync Quality
+typedef struct {
+    bool synced;
+    uint8_t samples;
+    int32_t last_residual_us;
+    int32_t drift_ppb;
+    uint32_t last_rtt_us;
+} time_sync_quality_t;
+
+// Local Clock (provided by main.c, 1024Hz tick + timer0 32.768kHz sub-tick)
+uint64_t user_get_time_us64(void);
+uint32_t user_get_time_us(void);
+
+// Function Prototypes
+void user_time_sync_reset(void);
+void user_time_sync_on_request(uint8_t conidx, uint8_t seq, uint32_t rx_local_us);
+bool user_time_sync_on_result(uint8_t conidx, uint8_t seq, uint32_t central_t1_us,
+                              uint32_t central_t4_us);
+void user_time_sync_on_disconnect(uint8_t conidx);
+uint32_t user_time_sync_to_shared(uint32_t local_us);
+void user_time_sync_get_quality(time_sync_quality_t *quality);
+
+#endif // USER_TIME_SYNC_H_
@@ -0,0 +1,219 @@
+/**
+ * @file user_wear.c
+ * @brief Off-body detection: suspends the sensing pipeline when the band is not worn
+ * @author Muhammad Umer Sajid, Student
+ *
+ * Worn, the band is never perfectly still: standing, sitting or lying there
+ * is foot pressure, tremor or slow changes of the ankle angle. Each 1 s block
+ * gives the accel magnitude variance, the mean gravity vector and the peak
+ * pressure. WEAR_OFF_CONFIRM_BLOCKS blocks in a row with no contact, a still
+ * magnitude and no change in orientation mean the band is lying somewhere,
+ * unless the caller holds it on body (a wearer lying still after a fall).
+ * Off body the loop drops to WEAR_OFF_SAMPLE_HZ and every sample is checked
+ * against the parked gravity vector and the pressure channel, so putting the
+ * band back on resumes full rate within a few hundred ms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "user_wear.h"
+#include "user_config.h"
+
+#define WEAR_DELTA_CLAMP                2047    // Keeps a 100 Hz block of squares in 32 bits
+
+// Global Variables
+static bool off_body = false;
+
+// Current block, relative to its first magnitude
+static uint32_t block_end_ms = 0;
+static uint16_t block_count = 0;
+static int32_t block_ref = 0;
+static int32_t block_sum = 0;
+static uint32_t block_sum_sq = 0;
+static int32_t block_axis_sum[3];
+static uint16_t block_pressure_max = 0;
+static int16_t last_mean[3];
+static bool have_last_mean = false;
+static uint8_t quiet_blocks = 0;
+
+// Off body
+static int16_t parked[3];
+static uint8_t wake_count = 0;
+static uint32_t wake_first_ms = 0;
+static uint32_t off_since_ms = 0;
+static uint32_t last_ms = 0;
+
+// Statistics
+static uint16_t removals = 0;
+static uint32_t off_time_ms = 0;
+static uint32_t runs_done = 0;
+static uint32_t runs_skipped = 0;
+static uint16_t wake_latency_ms = 0;
+
+// Local Functions
+static void block_reset(void);
+static uint16_t vector_delta(const int16_t *a, const int16_t *b);
+
+/**
+ * @brief Start worn (calibration needs the band on)
+ */
+void user_wear_init(uint32_t now_ms) {
+    off_body = false;
+    have_last_mean = false;
+    quiet_blocks = 0;
+    block_reset();
+    block_end_ms = now_ms + WEAR_BLOCK_MS;
+}
+
+/**
+ * @brief Feed one sample
+ * @param full_rate_hz Loop rate while worn, for the duty-cycle statistics
+ * @return true when the worn/off-body state changed
+ */
+bool user_wear_process(const wear_sample_t *sample, uint8_t full_rate_hz) {
+    runs_done++;
+    last_ms = sample->time_ms;
+
+    if (off_body) {
+        if (full_rate_hz > WEAR_OFF_SAMPLE_HZ) {
+            runs_skipped += (full_rate_hz / WEAR_OFF_SAMPLE_HZ) - 1;
+        }
+
+        bool evidence = (sample->pressure >= WEAR_PRESSURE_CONTACT) ||
+                        (vector_delta(sample->accel, parked) > WEAR_WAKE_DELTA_MG);
+        if (!evidence) {
+            wake_count = 0;
+            return false;
+        }
+
+        if (wake_count == 0) {
+            wake_first_ms = sample->time_ms;
+        }
+        if (++wake_count < WEAR_ON_CONFIRM_SAMPLES) {
+            return false;
+        }
+
+        off_body = false;
+        off_time_ms += sample->time_ms - off_since_ms;
+        wake_latency_ms = (uint16_t)(sample->time_ms - wake_first_ms);
+        have_last_mean = false;
+        quiet_blocks = 0;
+        block_reset();
+        block_end_ms = sample->time_ms + WEAR_BLOCK_MS;
+        printf("Band on body (wake %dms)\n", wake_latency_ms);
+        return true;
+    }
+
+    // Accumulate the block
+    if (block_count == 0) {
+        block_ref = sample->accel_mg;
+    }
+    int32_t delta = (int32_t)sample->accel_mg - block_ref;
+    if (delta > WEAR_DELTA_CLAMP) {
+        delta = WEAR_DELTA_CLAMP;
+    } else if (delta < -WEAR_DELTA_CLAMP) {
+        delta = -WEAR_DELTA_CLAMP;
+    }
+    block_sum += delta;
+    block_sum_sq += (uint32_t)(delta * delta);
+    for (uint8_t i = 0; i < 3; i++) {
+        block_axis_sum[i] += sample->accel[i];
+    }
+    if (sample->pressure > block_pressure_max) {
+        block_pressure_max = sample->pressure;
+    }
+    block_count++;
+
+    if ((int32_t)(sample->time_ms - block_end_ms) < 0) {
+        return false;
+    }
+    block_end_ms += WEAR_BLOCK_MS;
+    if ((int32_t)(sample->time_ms - block_end_ms) >= 0) {
+        block_end_ms = sample->time_ms + WEAR_BLOCK_MS;
+    }
+
+    // Close the block: stillness, orientation change and contact
+    int32_t n = block_count;
+    int32_t mean_delta = block_sum / n;
+    int32_t variance = (int32_t)(block_sum_sq / n) - mean_delta * mean_delta;
+    int16_t mean[3];
+
+    for (uint8_t i = 0; i < 3; i++) {
+        mean[i] = (int16_t)(block_axis_sum[i] / n);
+    }
+
+    bool still = variance <= WEAR_STILL_VAR_MG2;
+    bool level = have_last_mean && (vector_delta(mean, last_mean) <= WEAR_ORIENT_DELTA_MG);
+    bool contact = block_pressure_max >= WEAR_PRESSURE_CONTACT;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        last_mean[i] = mean[i];
+    }
+    have_last_mean = true;
+    block_reset();
+
+    quiet_blocks = (still && level && !contact) ? (quiet_blocks + 1) : 0;
+    if (quiet_blocks < WEAR_OFF_CONFIRM_BLOCKS || sample->hold_on) {
+        return false;
+    }
+
+    off_body = true;
+    off_since_ms = sample->time_ms;
+    wake_count = 0;
+    removals++;
+    for (uint8_t i = 0; i < 3; i++) {
+        parked[i] = mean[i];
+    }
+    printf("Band off body, sensing suspended\n");
+    return true;
+}
+
+/**
+ * @brief Current state
+ */
+bool user_wear_off_body(void) {
+    return off_body;
+}
+
+/**
+ * @brief Duty-cycle statistics (CTRL_REG_DIAG_WEAR)
+ */
+void user_wear_get(wear_stats_t *stats) {
+    uint32_t total = runs_done + runs_skipped;
+    uint32_t off_ms = off_time_ms;
+
+    if (off_body) {
+        off_ms += last_ms - off_since_ms;
+    }
+
+    stats->off_body = off_body;
+    stats->removals = removals;
+    stats->off_time_s = off_ms / 1000;
+    if (total == 0) {
+        stats->saved_permille = 0;
+    } else if (runs_skipped < (0xFFFFFFFFUL / 1000)) {
+        stats->saved_permille = (uint16_t)((runs_skipped * 1000) / total);
+    } else {
+        stats->saved_permille = (uint16_t)(runs_skipped / (total / 1000));
+    }
+    stats->wake_latency_ms = wake_latency_ms;
+}
+
+/**
+ * @brief Clear the block accumulators
+ */
+static void block_reset(void) {
+    block_count = 0;
+    block_sum = 0;
+    block_sum_sq = 0;
+    block_axis_sum[0] = block_axis_sum[1] = block_axis_sum[2] = 0;
+    block_pressure_max = 0;
+}
+
+/**
+ * @brief L1 distance between two accel vectors in mg
+ */
+static uint16_t vector_delta(const int16_t *a, const int16_t *b) {
+    uint32_t d = (uint32_t)abs(a[0] - b[0]) + (uint32_t)abs(a[1] - b[1]) + (uint32_t)abs(a[2] - b[2]);
+    return (d > 0xFFFF) ? 0xFFFF : (uint16_t)d;
+}
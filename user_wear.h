@@ -0,0 +1,50 @@
+/**
+ * @file user_wear.h
+ * @brief Off-body detection: suspends the sensing pipeline when the band is not worn
+ * @author Muhammad Umer Sajid, Student
+ */
+
+#ifndef USER_WEAR_H_
+#define USER_WEAR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Detection Parameters
+#define WEAR_BLOCK_MS                   1000    // Statistics block, the window slides by one block
+#define WEAR_OFF_CONFIRM_BLOCKS         30      // Still, level and no contact this long = removed
+#define WEAR_STILL_VAR_MG2              36      // Magnitude variance in a block (6 mg rms)
+#define WEAR_ORIENT_DELTA_MG            24      // Block-to-block change of the mean gravity vector
+#define WEAR_WAKE_DELTA_MG              120     // Off body: move this far from the parked vector to wake
+#define WEAR_ON_CONFIRM_SAMPLES         2       // Consecutive wake samples (200ms at 10Hz)
+#define WEAR_OFF_SAMPLE_HZ              10      // Loop rate while off body
+
+// Diagnostics Register (CTRL_REG_DIAG_WEAR)
+// [State][Removals u16][Off time s u32][Saved 0.1% u16][Wake latency ms u16]
+#define WEAR_DIAG_LEN                   11
+
+// Input Sample
+typedef struct {
+    uint32_t time_ms;
+    int16_t accel[3];       // mg
+    uint16_t accel_mg;      // Magnitude
+    uint16_t pressure;      // 25 Pa per LSB
+    bool hold_on;           // Never go off body now (fall being confirmed or alerted)
+} wear_sample_t;
+
+// Duty-Cycle Statistics
+typedef struct {
+    bool off_body;
+    uint16_t removals;
+    uint32_t off_time_s;
+    uint16_t saved_permille;    // Pipeline runs skipped vs running at full rate
+    uint16_t wake_latency_ms;   // Last off -> on, first evidence to resume
+} wear_stats_t;
+
+// Function Prototypes
+void user_wear_init(uint32_t now_ms);
+bool user_wear_process(const wear_sample_t *sample, uint8_t full_rate_hz);
+bool user_wear_off_body(void);
+void user_wear_get(wear_stats_t *stats);
+
+#endif // USER_WEAR_H_